@@ -0,0 +1,378 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <GLviz/utility.hpp>
+
+#include "preprocess.hpp"
+#include "decimation.hpp"
+#include "kd_tree.hpp"
+#include "mapped_file.hpp"
+#include "memory_stats.hpp"
+#include "parallel.hpp"
+#include "ply.hpp"
+#include "point_cloud.hpp"
+#include "procedural.hpp"
+#include "spatial_sort.hpp"
+#include "surfel_file.hpp"
+
+#include <Eigen/Core>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+struct Measurement
+{
+    double milliseconds;
+    double allocations, allocated_bytes, peak_bytes;
+};
+
+// Runs a function repeatedly for at least min_time seconds after one
+// warm-up run and returns the mean time and allocations per run, and the
+// peak heap growth of a run.
+template <typename Function>
+Measurement
+measure(Function const& function, double min_time)
+{
+    std::size_t peak_bytes;
+    {
+        MemoryScope scope;
+        function();
+        peak_bytes = scope.peak_bytes() - scope.begin_bytes();
+    }
+
+    MemoryStats stats = memory_stats();
+
+    auto begin = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed(0.0);
+    unsigned int n(0);
+
+    while (n < 3 || elapsed.count() < min_time)
+    {
+        function();
+        ++n;
+
+        elapsed = std::chrono::steady_clock::now() - begin;
+    }
+
+    Measurement m;
+    m.milliseconds = 1e3 * elapsed.count() / n;
+    m.allocations = static_cast<double>(memory_stats().allocations
+        - stats.allocations) / n;
+    m.allocated_bytes = static_cast<double>(memory_stats().allocated_bytes
+        - stats.allocated_bytes) / n;
+    m.peak_bytes = static_cast<double>(peak_bytes);
+
+    return m;
+}
+
+// Reports the time and allocations per run and the throughput in items
+// and, for file loaders, in bytes.
+void
+report(std::string const& name, std::size_t items, Measurement const& m,
+    std::size_t bytes = 0)
+{
+    std::cout << std::left << std::setw(32) << name << std::right
+        << std::fixed << std::setprecision(3)
+        << std::setw(12) << m.milliseconds
+        << std::setw(12) << 1e-3 * static_cast<double>(items)
+            / m.milliseconds;
+
+    if (bytes > 0)
+    {
+        std::cout << std::setw(10) << 1e-6 * static_cast<double>(bytes)
+            / m.milliseconds;
+    }
+    else
+    {
+        std::cout << std::setw(10) << "-";
+    }
+
+    std::cout << std::setprecision(1)
+        << std::setw(12) << m.allocations
+        << std::setw(14) << m.allocated_bytes / 1024.0
+        << std::setw(14) << m.peak_bytes / 1024.0 << std::endl;
+}
+
+bool
+is_ply(std::string const& filename)
+{
+    return filename.size() > 4 && filename.compare(filename.size() - 4, 4,
+        ".ply") == 0;
+}
+
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string filename("stanford_dragon_v40k_f80k.raw");
+    double min_time(0.5);
+
+    if (argc > 1)
+    {
+        filename = argv[1];
+    }
+
+    if (argc > 2)
+    {
+        min_time = std::atof(argv[2]);
+    }
+
+    std::vector<Eigen::Vector3f>              vertices, normals;
+    std::vector<std::array<unsigned int, 3>>  faces;
+    std::vector<unsigned int>                 colors;
+    std::vector<Surfel>                       surfels;
+
+    // PLY loading is measured on the input file if it is a PLY file, or
+    // otherwise on a temporary PLY file holding the same mesh.
+    std::string ply_filename(is_ply(filename) ? filename
+        : "preprocess_benchmark.ply");
+    std::size_t ply_size(0);
+
+    try
+    {
+        if (is_ply(filename))
+        {
+            load_ply(filename, vertices, faces, normals, colors);
+        }
+        else
+        {
+            load_triangle_mesh(filename, vertices, faces);
+            write_ply(ply_filename, vertices, faces, normals, colors);
+        }
+
+        ply_size = MappedFile(ply_filename).size();
+    }
+    catch (std::runtime_error const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << std::endl << std::left << std::setw(32) << "benchmark"
+        << std::right << std::setw(12) << "ms" << std::setw(12)
+        << "Mitems/s" << std::setw(10) << "GB/s" << std::setw(12)
+        << "allocs" << std::setw(14) << "alloc KiB" << std::setw(14)
+        << "peak KiB" << std::endl;
+
+    if (!is_ply(filename))
+    {
+        // A raw file holds the number of vertices and faces followed by
+        // their coordinates and indices.
+        std::size_t raw_size = 8 + 12 * (vertices.size() + faces.size());
+
+        report("load_triangle_mesh", faces.size(), measure([&]() {
+            std::cout.setstate(std::ios::failbit);
+            load_triangle_mesh(filename, vertices, faces);
+            std::cout.clear();
+        }, min_time), raw_size);
+    }
+
+    report("load_ply", faces.size(), measure([&]() {
+        load_ply(ply_filename, vertices, faces, normals, colors);
+    }, min_time), ply_size);
+
+    if (!is_ply(filename))
+    {
+        std::remove(ply_filename.c_str());
+    }
+
+    report("set_vertex_normals", vertices.size(), measure([&]() {
+        GLviz::set_vertex_normals_from_triangle_mesh(vertices, faces,
+            normals);
+    }, min_time));
+
+    std::vector<float> ellipses(9 * faces.size());
+    report("steiner_circumellipse", faces.size(), measure([&]() {
+        for (std::size_t i(0); i < faces.size(); ++i)
+        {
+            steiner_circumellipse(
+                vertices[faces[i][0]].data(),
+                vertices[faces[i][1]].data(),
+                vertices[faces[i][2]].data(),
+                &ellipses[9 * i], &ellipses[9 * i + 3], &ellipses[9 * i + 6]);
+        }
+    }, min_time));
+
+    std::vector<float> rgb(3 * 360 * 256);
+    report("hsv2rgb", 360 * 256, measure([&]() {
+        for (std::size_t i(0); i < 360 * 256; ++i)
+        {
+            hsv2rgb(static_cast<float>(i) / 256.0f, 1.0f, 1.0f,
+                rgb[3 * i], rgb[3 * i + 1], rgb[3 * i + 2]);
+        }
+    }, min_time));
+
+    surfels.resize(faces.size());
+    report("face_to_surfel", faces.size(), measure([&]() {
+        for (std::size_t i(0); i < faces.size(); ++i)
+        {
+            face_to_surfel(vertices, faces[i], surfels[i]);
+        }
+    }, min_time));
+
+    // Scaling of mesh_to_surfel with the number of threads.
+    unsigned int max_threads = hardware_threads();
+
+    for (unsigned int threads(1); ; threads = std::min(2 * threads,
+        max_threads))
+    {
+        std::ostringstream name;
+        name << "mesh_to_surfel/" << threads;
+
+        report(name.str(), faces.size(), measure([&]() {
+            mesh_to_surfel(vertices, faces, surfels, threads);
+        }, min_time));
+
+        if (threads == max_threads)
+        {
+            break;
+        }
+    }
+
+    std::vector<Surfel> decimated;
+    mesh_to_surfel(vertices, faces, surfels);
+    report("decimate", surfels.size(), measure([&]() {
+        decimate(surfels, decimated, 1e-4f, 0.17f);
+    }, min_time));
+
+    // The sort includes copying the unsorted surfels.
+    std::vector<Surfel> sorted;
+    for (unsigned int threads(1); ; threads = std::min(2 * threads,
+        max_threads))
+    {
+        std::ostringstream name;
+        name << "morton_sort/" << threads;
+
+        report(name.str(), surfels.size(), measure([&]() {
+            sorted = surfels;
+            morton_sort(sorted, false, threads);
+        }, min_time));
+
+        if (threads == max_threads)
+        {
+            break;
+        }
+    }
+
+    // Cluster construction on spatially sorted input.
+    report("decimate/morton", sorted.size(), measure([&]() {
+        decimate(sorted, decimated, 1e-4f, 0.17f);
+    }, min_time));
+
+    // Surfel file round trip through a temporary file. The throughput
+    // refers to the compressed size.
+    std::string const surfel_filename("preprocess_benchmark.srf");
+
+    report("write_surfels", surfels.size(), measure([&]() {
+        write_surfels(surfel_filename, surfels);
+    }, min_time));
+
+    {
+        SurfelFile file(surfel_filename);
+        std::size_t const file_size = MappedFile(surfel_filename).size();
+
+        for (unsigned int threads(1); ; threads = std::min(2 * threads,
+            max_threads))
+        {
+            std::ostringstream name;
+            name << "decode_surfels/" << threads;
+
+            report(name.str(), file.size(), measure([&]() {
+                file.decode(sorted, threads);
+            }, min_time), file_size);
+
+            if (threads == max_threads)
+            {
+                break;
+            }
+        }
+
+        std::cout << "  " << std::fixed << std::setprecision(1)
+            << static_cast<double>(file_size) / static_cast<double>(
+                std::max<std::size_t>(file.size(), 1))
+            << " bytes per surfel" << std::endl;
+    }
+
+    std::remove(surfel_filename.c_str());
+
+    // Surfels from the mesh vertices as an unorganized point cloud.
+    report("kd_tree", vertices.size(), measure([&]() {
+        KdTree tree(vertices);
+    }, min_time));
+
+    for (unsigned int threads(1); ; threads = std::min(2 * threads,
+        max_threads))
+    {
+        std::ostringstream name;
+        name << "point_cloud_to_surfel/" << threads;
+
+        report(name.str(), vertices.size(), measure([&]() {
+            point_cloud_to_surfel(vertices, normals, colors, surfels, 16,
+                threads);
+        }, min_time));
+
+        if (threads == max_threads)
+        {
+            break;
+        }
+    }
+
+    report("load_plane/200", 4 * 200 * 200, measure([&]() {
+        load_plane(200, surfels);
+    }, min_time));
+
+    // Procedural scenes of about 4M surfels. Replicas copy the mesh surfels.
+    std::vector<Surfel> model;
+    mesh_to_surfel(vertices, faces, model);
+
+    std::vector<Surfel> scene;
+
+    Measurement m = measure([&]() {
+        generate_checkerboards(4000000, scene);
+    }, min_time);
+    report("generate_checkerboards/4M", scene.size(), m,
+        scene.size() * sizeof(Surfel));
+
+    m = measure([&]() {
+        generate_terrain(4000000, scene);
+    }, min_time);
+    report("generate_terrain/4M", scene.size(), m,
+        scene.size() * sizeof(Surfel));
+
+    m = measure([&]() {
+        generate_replicas(model, 4000000, scene);
+    }, min_time);
+    report("generate_replicas/4M", scene.size(), m,
+        scene.size() * sizeof(Surfel));
+
+    return EXIT_SUCCESS;
+}
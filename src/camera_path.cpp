@@ -0,0 +1,142 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "camera_path.hpp"
+
+#include <Eigen/Geometry>
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace Eigen;
+
+std::vector<CameraPose>
+load_camera_poses(std::string const& filename)
+{
+    std::ifstream input(filename);
+    if (!input.good())
+    {
+        throw std::runtime_error("Failed to open " + filename + ".");
+    }
+
+    std::vector<CameraPose> poses;
+    std::string line;
+
+    for (unsigned int line_number(1); std::getline(input, line);
+        ++line_number)
+    {
+        std::istringstream tokens(line);
+        std::string first;
+
+        if (!(tokens >> first) || first[0] == '#')
+        {
+            continue;
+        }
+
+        tokens.clear();
+        tokens.seekg(0);
+
+        Vector3f t;
+        Quaternionf q;
+        if (!(tokens >> t.x() >> t.y() >> t.z()
+            >> q.w() >> q.x() >> q.y() >> q.z()))
+        {
+            std::ostringstream message;
+            message << filename << "(" << line_number
+                << "): Expected 'tx ty tz qw qx qy qz'.";
+            throw std::runtime_error(message.str());
+        }
+
+        CameraPose pose;
+        pose.translation = t;
+        pose.rotation = q.normalized().toRotationMatrix();
+        poses.push_back(pose);
+    }
+
+    return poses;
+}
+
+std::vector<CameraPose>
+stereo_poses(CameraPose const& pose, float eye_separation)
+{
+    std::vector<CameraPose> poses(2, pose);
+
+    poses[0].translation.x() += 0.5f * eye_separation;
+    poses[1].translation.x() -= 0.5f * eye_separation;
+
+    return poses;
+}
+
+std::vector<CameraPose>
+cube_map_poses(CameraPose const& pose)
+{
+    Vector3f const direction[6] = {
+        Vector3f::UnitX(), -Vector3f::UnitX(),
+        Vector3f::UnitY(), -Vector3f::UnitY(),
+        Vector3f::UnitZ(), -Vector3f::UnitZ()
+    };
+
+    std::vector<CameraPose> poses(6);
+
+    for (unsigned int i(0); i < 6; ++i)
+    {
+        Matrix3f face = Quaternionf::FromTwoVectors(direction[i],
+            -Vector3f::UnitZ()).toRotationMatrix();
+
+        poses[i].translation = face * pose.translation;
+        poses[i].rotation = face * pose.rotation;
+    }
+
+    return poses;
+}
+
+void
+set_camera_pose(GLviz::Camera& camera, CameraPose const& pose)
+{
+    camera = GLviz::Camera();
+    camera.rotate(Quaternionf(pose.rotation));
+    camera.translate(pose.translation);
+}
+
+CameraPose
+camera_pose(GLviz::Camera const& camera)
+{
+    Matrix4f modelview = camera.get_modelview_matrix();
+
+    CameraPose pose;
+    pose.translation = modelview.topRightCorner<3, 1>();
+    pose.rotation = modelview.topLeftCorner<3, 3>();
+
+    return pose;
+}
+
+CameraPose
+interpolate_poses(CameraPose const& a, CameraPose const& b, float t)
+{
+    CameraPose pose;
+    pose.translation = (1.0f - t) * a.translation + t * b.translation;
+    pose.rotation = Quaternionf(a.rotation).slerp(t,
+        Quaternionf(b.rotation)).toRotationMatrix();
+
+    return pose;
+}
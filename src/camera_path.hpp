@@ -0,0 +1,65 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef CAMERA_PATH_HPP
+#define CAMERA_PATH_HPP
+
+#include <GLviz/camera.hpp>
+
+#include <Eigen/Core>
+
+#include <string>
+#include <vector>
+
+// A camera pose is given by the rotation and translation of the
+// modelview matrix, i.e. modelview = [rotation | translation].
+struct CameraPose
+{
+    Eigen::Vector3f translation;
+    Eigen::Matrix3f rotation;
+};
+
+// Reads camera poses from a text file. Each non-empty line not starting
+// with '#' holds a translation and a unit quaternion, 'tx ty tz qw qx qy qz'.
+std::vector<CameraPose> load_camera_poses(std::string const& filename);
+
+// Derives the poses of a stereo pair, left eye first, separated along the
+// x-axis of the eye space of the given pose.
+std::vector<CameraPose> stereo_poses(CameraPose const& pose,
+    float eye_separation);
+
+// Derives the poses of six cube map faces looking along the +x, -x, +y, -y,
+// +z and -z axes of the eye space of the given pose.
+std::vector<CameraPose> cube_map_poses(CameraPose const& pose);
+
+// Resets the modelview transformation of a camera to the given pose.
+// The projection has to be set up again afterwards.
+void set_camera_pose(GLviz::Camera& camera, CameraPose const& pose);
+
+// Returns the pose of the modelview transformation of a camera.
+CameraPose camera_pose(GLviz::Camera const& camera);
+
+// Interpolates two poses, spherically for the rotation, with t in [0, 1].
+CameraPose interpolate_poses(CameraPose const& a, CameraPose const& b,
+    float t);
+
+#endif // CAMERA_PATH_HPP
@@ -0,0 +1,774 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "cpu_renderer.hpp"
+#include "parallel.hpp"
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Eigen;
+
+namespace
+{
+
+int const tile_size = 64;
+
+// Pixels evaluated at once, one SIMD packet of floats, e.g. four with SSE
+// and eight with AVX. Splats mostly cover a few pixels per row, hence
+// longer spans waste more lanes than they save.
+int const span_size = internal::packet_traits<float>::size;
+
+typedef Array<float, span_size, 1> SpanArray;
+
+// Upper bound on the point size similar to GL_POINT_SIZE_RANGE.
+float const max_point_size = 2048.0f;
+
+// See lighting.glsl.
+Vector3f
+lighting(Vector3f const& normal_eye, Vector3f const& v_eye,
+    Vector3f const& color, float shininess)
+{
+    Vector3f const light_eye(0.0f, 0.0f, 1.0f);
+
+    float dif = std::max(light_eye.dot(normal_eye), 0.0f);
+    Vector3f refl_eye = light_eye - 2.0f * normal_eye.dot(light_eye)
+        * normal_eye;
+
+    Vector3f view_eye = v_eye.normalized();
+    float spe = std::pow(std::min(std::max(refl_eye.dot(view_eye), 0.0f),
+        1.0f), shininess);
+    float rim = std::pow(1.0f + normal_eye.dot(view_eye), 3.0f);
+
+    Vector3f res = 0.15f * color;
+    res += 0.6f * dif * color;
+    res += 0.1f * spe * Vector3f::Ones();
+    res += 0.1f * rim * Vector3f::Ones();
+
+    return res;
+}
+
+// Sutherland-Hodgman clipping of a polygon in clip space by the view
+// frustum, see clip_polygon() in attribute_vs.glsl.
+int
+clip_polygon(Vector4f const* p0, Vector4f* p1)
+{
+    Vector4f p[16];
+    int n = 4;
+
+    std::copy(p0, p0 + 4, p);
+
+    for (int i = 0; i < 6; ++i)
+    {
+        int const axis = i / 2;
+        float const sign = static_cast<float>(-1 + 2 * (i % 2));
+        int k = 0;
+
+        for (int j = 0; j < n; ++j)
+        {
+            Vector4f const& v1 = p[j];
+            Vector4f const& v2 = p[(j + 1) % n];
+
+            float b1 = v1.w() + sign * v1[axis];
+            float b2 = v2.w() + sign * v2[axis];
+
+            bool tb1 = b1 > 0.0f;
+            bool tb2 = b2 > 0.0f;
+
+            if (tb1 && tb2)
+            {
+                p1[k++] = v2;
+            }
+            else if (tb1 != tb2)
+            {
+                float a = b1 / (b1 - b2);
+                p1[k++] = (1.0f - a) * v1 + a * v2;
+
+                if (tb2)
+                {
+                    p1[k++] = v2;
+                }
+            }
+        }
+
+        std::copy(p1, p1 + k, p);
+        n = k;
+    }
+
+    return n;
+}
+
+}
+
+CpuSplatRenderer::CpuSplatRenderer()
+    : m_width(0), m_height(0),
+      m_threads(hardware_threads()),
+      m_soft_zbuffer(true), m_backface_culling(false), m_smooth(false),
+      m_color_material(true), m_ewa_filter(false),
+      m_color(Vector3f(0.0, 0.25f, 1.0f)), m_epsilon(1.0f * 1e-3f),
+      m_shininess(8.0f), m_radius_scale(1.0f), m_ewa_radius(1.0f)
+{
+    // See SplatRenderer::setup_filter_kernel().
+    const float sigma2 = 0.316228f;
+
+    for (unsigned int i = 0; i < 256; ++i)
+    {
+        float x = static_cast<float>(i) / 255.0f;
+        float const w = x * x / (2.0f * sigma2);
+        m_filter_kernel[i] = std::exp(-w);
+    }
+}
+
+void
+CpuSplatRenderer::render_frame(std::vector<Surfel> const& geometry,
+    Matrix4f const& modelview_matrix, Matrix4f const& projection_matrix)
+{
+    m_modelview_matrix = modelview_matrix;
+    m_projection_matrix = projection_matrix;
+    m_projection_matrix_inv = projection_matrix.inverse();
+
+    m_splats.resize(geometry.size());
+    parallel_for(geometry.size(), m_threads, 4096,
+        [&](std::size_t b, std::size_t e) {
+            for (std::size_t i = b; i < e; ++i)
+            {
+                setup_splat(geometry[i], m_splats[i]);
+            }
+        });
+
+    bin_splats();
+
+    unsigned int tiles_x = (m_width + tile_size - 1) / tile_size;
+    unsigned int tiles_y = (m_height + tile_size - 1) / tile_size;
+
+    parallel_for(tiles_x * tiles_y, m_threads, 1,
+        [&](std::size_t b, std::size_t e) {
+            for (std::size_t i = b; i < e; ++i)
+            {
+                render_tile(static_cast<unsigned int>(i));
+            }
+        });
+}
+
+void
+CpuSplatRenderer::setup_splat(Surfel const& surfel, Splat& splat) const
+{
+    // See main() and pointsprite() in attribute_vs.glsl.
+    Matrix3f const modelview = m_modelview_matrix.topLeftCorner<3, 3>();
+
+    Vector3f c_eye = modelview * surfel.c
+        + m_modelview_matrix.block<3, 1>(0, 3);
+    Vector3f u_eye = m_radius_scale * (modelview * surfel.u);
+    Vector3f v_eye = m_radius_scale * (modelview * surfel.v);
+    Vector3f n_eye = u_eye.cross(v_eye).normalized();
+
+    splat.valid = false;
+
+    if (m_backface_culling && !(n_eye.dot(-c_eye) > 0.0f))
+    {
+        return;
+    }
+
+    Vector4f p0[4] = {
+        m_projection_matrix * (c_eye + u_eye + v_eye).homogeneous(),
+        m_projection_matrix * (c_eye + u_eye - v_eye).homogeneous(),
+        m_projection_matrix * (c_eye - u_eye - v_eye).homogeneous(),
+        m_projection_matrix * (c_eye - u_eye + v_eye).homogeneous()
+    };
+
+    Vector4f p1[16];
+    int n_pts = clip_polygon(p0, p1);
+
+    if (n_pts == 0)
+    {
+        return;
+    }
+
+    Vector2f p_min = Vector2f::Ones();
+    Vector2f p_max = -Vector2f::Ones();
+
+    for (int i = 0; i < n_pts; ++i)
+    {
+        Vector2f p1i = p1[i].head<2>() / p1[i].w();
+        p_min = p_min.cwiseMin(p1i);
+        p_max = p_max.cwiseMax(p1i);
+    }
+
+    Vector2f w = 0.5f * (p_max - p_min);
+    Vector2f p_scr = p_min + w;
+
+    float point_size = std::max(w.x() * static_cast<float>(m_width),
+        w.y() * static_cast<float>(m_height)) + 1.0f;
+
+    splat.size[0] = std::min(point_size, max_point_size);
+    splat.size[1] = m_ewa_filter ? std::max(2.0f, splat.size[0])
+        : splat.size[0];
+    splat.c_scr = 0.5f * (p_scr + Vector2f::Ones()).cwiseProduct(
+        Vector2f(static_cast<float>(m_width),
+            static_cast<float>(m_height)));
+
+    Vector3f color = m_color;
+    if (!m_color_material)
+    {
+        color = Vector3f(
+            static_cast<float>(surfel.rgba & 0xff),
+            static_cast<float>((surfel.rgba >> 8) & 0xff),
+            static_cast<float>((surfel.rgba >> 16) & 0xff)) / 255.0f;
+    }
+
+    splat.c = c_eye;
+    splat.u = u_eye;
+    splat.v = v_eye;
+    splat.n = n_eye;
+    splat.p = surfel.p;
+    splat.color = m_smooth ? color
+        : lighting(n_eye, c_eye, color, m_shininess);
+    splat.valid = true;
+}
+
+void
+CpuSplatRenderer::bin_splats()
+{
+    int const tiles_x = (m_width + tile_size - 1) / tile_size;
+    int const tiles_y = (m_height + tile_size - 1) / tile_size;
+    std::size_t const num_tiles = tiles_x * tiles_y;
+
+    // Splats are binned in contiguous chunks. Concatenating the bins of all
+    // chunks in chunk order preserves the input order within each tile.
+    std::size_t const num_chunks = m_threads;
+    std::size_t const n = m_splats.size();
+
+    auto tile_range = [&](Splat const& splat, int& tx0, int& tx1,
+        int& ty0, int& ty1) {
+        float const r = 0.5f * splat.size[1];
+        tx0 = std::max(0, static_cast<int>(std::floor(
+            (splat.c_scr.x() - r) / tile_size)));
+        tx1 = std::min(tiles_x - 1, static_cast<int>(std::floor(
+            (splat.c_scr.x() + r) / tile_size)));
+        ty0 = std::max(0, static_cast<int>(std::floor(
+            (splat.c_scr.y() - r) / tile_size)));
+        ty1 = std::min(tiles_y - 1, static_cast<int>(std::floor(
+            (splat.c_scr.y() + r) / tile_size)));
+    };
+
+    std::vector<unsigned int> count(num_chunks * num_tiles, 0);
+
+    parallel_for(num_chunks, m_threads, 1, [&](std::size_t b, std::size_t e) {
+        for (std::size_t k = b; k < e; ++k)
+        {
+            unsigned int* chunk_count = &count[k * num_tiles];
+
+            for (std::size_t i = k * n / num_chunks;
+                i < (k + 1) * n / num_chunks; ++i)
+            {
+                if (!m_splats[i].valid) continue;
+
+                int tx0, tx1, ty0, ty1;
+                tile_range(m_splats[i], tx0, tx1, ty0, ty1);
+
+                for (int ty = ty0; ty <= ty1; ++ty)
+                    for (int tx = tx0; tx <= tx1; ++tx)
+                        ++chunk_count[ty * tiles_x + tx];
+            }
+        }
+    });
+
+    m_tile_offset.assign(num_tiles + 1, 0);
+
+    unsigned int offset(0);
+    for (std::size_t t(0); t < num_tiles; ++t)
+    {
+        m_tile_offset[t] = offset;
+        for (std::size_t k(0); k < num_chunks; ++k)
+        {
+            unsigned int c = count[k * num_tiles + t];
+            count[k * num_tiles + t] = offset;
+            offset += c;
+        }
+    }
+    m_tile_offset[num_tiles] = offset;
+
+    m_tile_splats.resize(offset);
+
+    parallel_for(num_chunks, m_threads, 1, [&](std::size_t b, std::size_t e) {
+        for (std::size_t k = b; k < e; ++k)
+        {
+            unsigned int* chunk_offset = &count[k * num_tiles];
+
+            for (std::size_t i = k * n / num_chunks;
+                i < (k + 1) * n / num_chunks; ++i)
+            {
+                if (!m_splats[i].valid) continue;
+
+                int tx0, tx1, ty0, ty1;
+                tile_range(m_splats[i], tx0, tx1, ty0, ty1);
+
+                for (int ty = ty0; ty <= ty1; ++ty)
+                    for (int tx = tx0; tx <= tx1; ++tx)
+                        m_tile_splats[chunk_offset[ty * tiles_x + tx]++]
+                            = static_cast<unsigned int>(i);
+            }
+        }
+    });
+}
+
+void
+CpuSplatRenderer::render_tile(unsigned int tile)
+{
+    int const tiles_x = (m_width + tile_size - 1) / tile_size;
+    int const x0 = static_cast<int>(tile % tiles_x) * tile_size;
+    int const y0 = static_cast<int>(tile / tiles_x) * tile_size;
+    int const x1 = std::min(x0 + tile_size, m_width);
+    int const y1 = std::min(y0 + tile_size, m_height);
+
+    for (int y = y0; y < y1; ++y)
+    {
+        std::size_t i = static_cast<std::size_t>(y) * m_width;
+
+        std::fill(m_color_buffer.begin() + 4 * (i + x0),
+            m_color_buffer.begin() + 4 * (i + x1), 0.0f);
+        std::fill(m_depth_buffer.begin() + i + x0,
+            m_depth_buffer.begin() + i + x1, 1.0f);
+
+        if (m_smooth)
+        {
+            std::fill(m_normal_buffer.begin() + 4 * (i + x0),
+                m_normal_buffer.begin() + 4 * (i + x1), 0.0f);
+        }
+    }
+
+    unsigned int const begin = m_tile_offset[tile];
+    unsigned int const end = m_tile_offset[tile + 1];
+
+    if (m_soft_zbuffer)
+    {
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            render_splat<false>(m_splats[m_tile_splats[i]], true,
+                x0, x1, y0, y1);
+        }
+    }
+
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        if (m_ewa_filter)
+        {
+            render_splat<true>(m_splats[m_tile_splats[i]], false,
+                x0, x1, y0, y1);
+        }
+        else
+        {
+            render_splat<false>(m_splats[m_tile_splats[i]], false,
+                x0, x1, y0, y1);
+        }
+    }
+}
+
+template <bool ewa> void
+CpuSplatRenderer::render_splat(Splat const& splat, bool depth_only,
+    int x0, int x1, int y0, int y1)
+{
+    // Rasterize the point sprite. A pixel is covered if its center lies
+    // within the square of the point size around the splat center.
+    float const r = 0.5f * splat.size[depth_only ? 0 : 1];
+
+    x0 = std::max(x0, static_cast<int>(std::ceil(splat.c_scr.x() - r - 0.5f)));
+    x1 = std::min(x1, static_cast<int>(std::ceil(splat.c_scr.x() + r - 0.5f)));
+    y0 = std::max(y0, static_cast<int>(std::ceil(splat.c_scr.y() - r - 0.5f)));
+    y1 = std::min(y1, static_cast<int>(std::ceil(splat.c_scr.y() + r - 0.5f)));
+
+    float const width = static_cast<float>(m_width);
+    float const height = static_cast<float>(m_height);
+
+    // The eye space position on the near plane is an affine function of
+    // the normalized device coordinates, see attribute_fs.glsl.
+    Vector4f const a = m_projection_matrix_inv.col(0);
+    Vector4f const b = m_projection_matrix_inv.col(1);
+    Vector4f const c = m_projection_matrix_inv.col(3)
+        - m_projection_matrix_inv.col(2);
+
+    float const cn = splat.c.dot(splat.n);
+    Vector3f const u = splat.u / splat.u.dot(splat.u);
+    Vector3f const v = splat.v / splat.v.dot(splat.v);
+
+    float const p22 = m_projection_matrix(2, 2);
+    float const p23 = m_projection_matrix(2, 3);
+    float const epsilon = depth_only ? m_epsilon : 0.0f;
+
+    // Pixel centers of a span relative to its first pixel.
+    SpanArray const offset = SpanArray::LinSpaced(span_size, 0.5f,
+        static_cast<float>(span_size) - 0.5f);
+
+    SpanArray depth, alpha;
+
+    for (int y = y0; y < y1; ++y)
+    {
+        float const fy = static_cast<float>(y) + 0.5f;
+        Vector4f const row = b * (2.0f * fy / height - 1.0f) + c;
+
+        for (int xa = x0; xa < x1; xa += span_size)
+        {
+            int const n = std::min(span_size, x1 - xa);
+
+            // The whole span is evaluated in SIMD packets without branches,
+            // including the pixels past its end. Discarded pixels get a
+            // depth of 2, which fails the depth test.
+            SpanArray const fx = offset + static_cast<float>(xa);
+            SpanArray const ndc_x = 2.0f * fx / width - 1.0f;
+
+            SpanArray const ew = a.w() * ndc_x + row.w();
+            SpanArray qx = (a.x() * ndc_x + row.x()) / ew;
+            SpanArray qy = (a.y() * ndc_x + row.y()) / ew;
+            SpanArray qz = (a.z() * ndc_x + row.z()) / ew;
+
+            SpanArray const t = cn / (qx * splat.n.x() + qy * splat.n.y()
+                + qz * splat.n.z());
+            qx *= t; qy *= t; qz *= t;
+
+            SpanArray const dx = qx - splat.c.x();
+            SpanArray const dy = qy - splat.c.y();
+            SpanArray const dz = qz - splat.c.z();
+
+            SpanArray const uu = u.x() * dx + u.y() * dy + u.z() * dz;
+            SpanArray const vv = v.x() * dx + v.y() * dy + v.z() * dz;
+
+            SpanArray const w3d = (uu * uu + vv * vv).sqrt();
+            SpanArray zval = qz;
+            SpanArray dist = w3d;
+
+            if (ewa)
+            {
+                SpanArray const sx = fx - splat.c_scr.x();
+                float const sy = fy - splat.c_scr.y();
+                SpanArray const w2d = (sx * sx + sy * sy).sqrt()
+                    / m_ewa_radius;
+
+                dist = w2d.min(w3d);
+                zval = (w3d > 1.0f).select(splat.c.z(), zval);
+            }
+
+            zval -= epsilon;
+            SpanArray const d = 0.5f * (-p23 * zval.inverse() - p22 + 1.0f);
+
+            depth = (uu * splat.p.x() + vv * splat.p.y() + splat.p.z()
+                < 0.0f || dist > 1.0f || d.isNaN()).select(2.0f,
+                d.max(0.0f).min(1.0f));
+            alpha = dist;
+
+            std::size_t const i = static_cast<std::size_t>(y) * m_width + xa;
+
+            for (int k = 0; k < n; ++k)
+            {
+                if (!(depth[k] < m_depth_buffer[i + k]))
+                {
+                    continue;
+                }
+
+                if (depth_only)
+                {
+                    m_depth_buffer[i + k] = depth[k];
+                    continue;
+                }
+
+                float const w = ewa ? m_filter_kernel[std::min(255,
+                    static_cast<int>(alpha[k] * 256.0f))] : 1.0f;
+
+                float* color = &m_color_buffer[4 * (i + k)];
+                float* normal = &m_normal_buffer[m_smooth ? 4 * (i + k) : 0];
+
+                if (m_soft_zbuffer)
+                {
+                    color[0] += w * splat.color.x();
+                    color[1] += w * splat.color.y();
+                    color[2] += w * splat.color.z();
+                    color[3] += w;
+
+                    if (m_smooth)
+                    {
+                        normal[0] += w * splat.n.x();
+                        normal[1] += w * splat.n.y();
+                        normal[2] += w * splat.n.z();
+                        normal[3] += w;
+                    }
+                }
+                else
+                {
+                    m_depth_buffer[i + k] = depth[k];
+
+                    color[0] = splat.color.x();
+                    color[1] = splat.color.y();
+                    color[2] = splat.color.z();
+                    color[3] = w;
+
+                    if (m_smooth)
+                    {
+                        normal[0] = splat.n.x();
+                        normal[1] = splat.n.y();
+                        normal[2] = splat.n.z();
+                        normal[3] = w;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void
+CpuSplatRenderer::finalize(std::vector<unsigned char>& rgba) const
+{
+    // See finalization_fs.glsl.
+    rgba.resize(4 * static_cast<std::size_t>(m_width) * m_height);
+
+    parallel_for(m_height, m_threads, 16, [&](std::size_t b, std::size_t e) {
+        for (std::size_t y = b; y < e; ++y)
+        {
+            for (std::size_t x = 0; x < static_cast<std::size_t>(m_width);
+                ++x)
+            {
+                std::size_t const i = y * m_width + x;
+                float const* pixel = &m_color_buffer[4 * i];
+
+                Vector3f res = Vector3f::Ones();
+
+                if (pixel[3] > 0.0f)
+                {
+                    res = Vector3f(pixel[0], pixel[1], pixel[2]) / pixel[3];
+
+                    if (m_smooth)
+                    {
+                        Vector3f normal = Map<const Vector3f>(
+                            &m_normal_buffer[4 * i]).normalized();
+
+                        Vector4f p_ndc(
+                            2.0f * (static_cast<float>(x) + 0.5f)
+                                / static_cast<float>(m_width) - 1.0f,
+                            2.0f * (static_cast<float>(y) + 0.5f)
+                                / static_cast<float>(m_height) - 1.0f,
+                            2.0f * m_depth_buffer[i] - 1.0f,
+                            1.0f);
+
+                        Vector4f v_eye = m_projection_matrix_inv * p_ndc;
+                        v_eye /= v_eye.w();
+
+                        res = lighting(normal, v_eye.head<3>(), res,
+                            m_shininess);
+                    }
+                }
+
+                for (unsigned int j(0); j < 3; ++j)
+                {
+                    float value = std::min(std::max(std::sqrt(res[j]),
+                        0.0f), 1.0f);
+                    rgba[4 * i + j] = static_cast<unsigned char>(
+                        value * 255.0f + 0.5f);
+                }
+                rgba[4 * i + 3] = 255;
+            }
+        }
+    });
+}
+
+std::vector<float> const&
+CpuSplatRenderer::color_buffer() const
+{
+    return m_color_buffer;
+}
+
+std::vector<float> const&
+CpuSplatRenderer::normal_buffer() const
+{
+    return m_normal_buffer;
+}
+
+std::vector<float> const&
+CpuSplatRenderer::depth_buffer() const
+{
+    return m_depth_buffer;
+}
+
+int
+CpuSplatRenderer::width() const
+{
+    return m_width;
+}
+
+int
+CpuSplatRenderer::height() const
+{
+    return m_height;
+}
+
+void
+CpuSplatRenderer::reshape(int width, int height)
+{
+    std::size_t const n = static_cast<std::size_t>(width) * height;
+
+    m_width = width;
+    m_height = height;
+
+    m_color_buffer.assign(4 * n, 0.0f);
+    m_normal_buffer.assign(m_smooth ? 4 * n : 0, 0.0f);
+    m_depth_buffer.assign(n, 1.0f);
+}
+
+unsigned int
+CpuSplatRenderer::threads() const
+{
+    return m_threads;
+}
+
+void
+CpuSplatRenderer::set_threads(unsigned int threads)
+{
+    m_threads = std::max(1u, threads);
+}
+
+bool
+CpuSplatRenderer::smooth() const
+{
+    return m_smooth;
+}
+
+void
+CpuSplatRenderer::set_smooth(bool enable)
+{
+    m_smooth = enable;
+    m_normal_buffer.assign(m_smooth ? m_color_buffer.size() : 0, 0.0f);
+}
+
+bool
+CpuSplatRenderer::color_material() const
+{
+    return m_color_material;
+}
+
+void
+CpuSplatRenderer::set_color_material(bool enable)
+{
+    m_color_material = enable;
+}
+
+bool
+CpuSplatRenderer::backface_culling() const
+{
+    return m_backface_culling;
+}
+
+void
+CpuSplatRenderer::set_backface_culling(bool enable)
+{
+    m_backface_culling = enable;
+}
+
+bool
+CpuSplatRenderer::soft_zbuffer() const
+{
+    return m_soft_zbuffer;
+}
+
+void
+CpuSplatRenderer::set_soft_zbuffer(bool enable)
+{
+    if (!enable)
+    {
+        m_ewa_filter = false;
+    }
+
+    m_soft_zbuffer = enable;
+}
+
+float
+CpuSplatRenderer::soft_zbuffer_epsilon() const
+{
+    return m_epsilon;
+}
+
+void
+CpuSplatRenderer::set_soft_zbuffer_epsilon(float epsilon)
+{
+    m_epsilon = epsilon;
+}
+
+bool
+CpuSplatRenderer::ewa_filter() const
+{
+    return m_ewa_filter;
+}
+
+void
+CpuSplatRenderer::set_ewa_filter(bool enable)
+{
+    if (m_soft_zbuffer)
+    {
+        m_ewa_filter = enable;
+    }
+}
+
+float const*
+CpuSplatRenderer::material_color() const
+{
+    return m_color.data();
+}
+
+void
+CpuSplatRenderer::set_material_color(float const* color_ptr)
+{
+    m_color = Map<const Vector3f>(color_ptr);
+}
+
+float
+CpuSplatRenderer::material_shininess() const
+{
+    return m_shininess;
+}
+
+void
+CpuSplatRenderer::set_material_shininess(float shininess)
+{
+    m_shininess = shininess;
+}
+
+float
+CpuSplatRenderer::radius_scale() const
+{
+    return m_radius_scale;
+}
+
+void
+CpuSplatRenderer::set_radius_scale(float radius_scale)
+{
+    m_radius_scale = radius_scale;
+}
+
+float
+CpuSplatRenderer::ewa_radius() const
+{
+    return m_ewa_radius;
+}
+
+void
+CpuSplatRenderer::set_ewa_radius(float ewa_radius)
+{
+    m_ewa_radius = ewa_radius;
+}
@@ -0,0 +1,129 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef CPU_RENDERER_HPP
+#define CPU_RENDERER_HPP
+
+#include "surfel.hpp"
+
+#include <Eigen/Core>
+#include <vector>
+
+// Reference implementation of the splatting pipeline of SplatRenderer on the
+// CPU. It mirrors the attribute and finalization shaders using the PBP point
+// size method: point size bounds by a clipped bounding polygon, ray-splat
+// intersection, clipping planes, the EWA filter approximation and the soft
+// z-buffer. The image is rendered in screen tiles by a pool of threads.
+// Within a tile, splats are processed in input order, hence the result does
+// not depend on the number of threads. Multisampling is not supported.
+class CpuSplatRenderer
+{
+
+public:
+    CpuSplatRenderer();
+
+    void render_frame(std::vector<Surfel> const& geometry,
+        Eigen::Matrix4f const& modelview_matrix,
+        Eigen::Matrix4f const& projection_matrix);
+
+    // Writes the finalized image as 8-bit RGBA with rows in bottom-up order,
+    // i.e. as glReadPixels would return it.
+    void finalize(std::vector<unsigned char>& rgba) const;
+
+    // Color and normal buffer hold four floats per pixel, the depth buffer
+    // one float per pixel. Rows are stored in bottom-up order. The normal
+    // buffer is only written if smooth shading is enabled.
+    std::vector<float> const& color_buffer() const;
+    std::vector<float> const& normal_buffer() const;
+    std::vector<float> const& depth_buffer() const;
+
+    int width() const;
+    int height() const;
+    void reshape(int width, int height);
+
+    unsigned int threads() const;
+    void set_threads(unsigned int threads);
+
+    bool smooth() const;
+    void set_smooth(bool enable = true);
+
+    bool color_material() const;
+    void set_color_material(bool enable = true);
+
+    bool backface_culling() const;
+    void set_backface_culling(bool enable = true);
+
+    bool soft_zbuffer() const;
+    void set_soft_zbuffer(bool enable = true);
+
+    float soft_zbuffer_epsilon() const;
+    void set_soft_zbuffer_epsilon(float epsilon);
+
+    bool ewa_filter() const;
+    void set_ewa_filter(bool enable = true);
+
+    float const* material_color() const;
+    void set_material_color(float const* color_ptr);
+    float material_shininess() const;
+    void set_material_shininess(float shininess);
+
+    float radius_scale() const;
+    void set_radius_scale(float radius_scale);
+
+    float ewa_radius() const;
+    void set_ewa_radius(float ewa_radius);
+
+private:
+    struct Splat
+    {
+        Eigen::Vector3f c, u, v, n, p, color;
+        Eigen::Vector2f c_scr;
+        float size[2];
+        bool valid;
+    };
+
+    void setup_splat(Surfel const& surfel, Splat& splat) const;
+    void bin_splats();
+    void render_tile(unsigned int tile);
+    template <bool ewa> void render_splat(Splat const& splat,
+        bool depth_only, int x0, int x1, int y0, int y1);
+
+private:
+    int m_width, m_height;
+    unsigned int m_threads;
+
+    bool m_soft_zbuffer, m_backface_culling, m_smooth,
+        m_color_material, m_ewa_filter;
+    Eigen::Vector3f m_color;
+    float m_epsilon, m_shininess, m_radius_scale, m_ewa_radius;
+
+    Eigen::Matrix4f m_modelview_matrix, m_projection_matrix,
+        m_projection_matrix_inv;
+    float m_filter_kernel[256];
+
+    std::vector<Splat> m_splats;
+    std::vector<unsigned int> m_tile_offset, m_tile_splats;
+
+    std::vector<float> m_color_buffer, m_normal_buffer, m_depth_buffer;
+};
+
+#endif // CPU_RENDERER_HPP
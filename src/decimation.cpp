@@ -0,0 +1,242 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "decimation.hpp"
+#include "kd_tree.hpp"
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace Eigen;
+
+namespace
+{
+
+// Number of points sampled on the boundary of an ellipse.
+unsigned int const num_samples = 8;
+
+// Upper bound on the ratio of the semi-axes of a merged surfel.
+float const max_anisotropy = 4.0f;
+
+bool
+similar_color(unsigned int c0, unsigned int c1, unsigned int max_difference)
+{
+    for (unsigned int i(0); i < 24; i += 8)
+    {
+        int d = static_cast<int>((c0 >> i) & 0xff)
+            - static_cast<int>((c1 >> i) & 0xff);
+
+        if (static_cast<unsigned int>(std::abs(d)) > max_difference)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+boundary_samples(Surfel const& surfel, Vector3f* samples)
+{
+    for (unsigned int i(0); i < num_samples; ++i)
+    {
+        float t = 6.28318531f * static_cast<float>(i)
+            / static_cast<float>(num_samples);
+        samples[i] = surfel.c + std::cos(t) * surfel.u
+            + std::sin(t) * surfel.v;
+    }
+}
+
+Surfel
+merge(std::vector<Surfel> const& surfels,
+    std::vector<unsigned int> const& members, Vector3f const& n0)
+{
+    Surfel const& seed = surfels[members.front()];
+
+    Vector3f t1 = seed.u.normalized();
+    Vector3f t2 = n0.cross(t1);
+
+    // Boundary samples of all members in the plane of the seed.
+    std::vector<Vector2f> samples;
+    samples.reserve(num_samples * members.size());
+
+    Vector2f mean = Vector2f::Zero();
+    unsigned int rgba[4] = { 0, 0, 0, 0 };
+
+    for (unsigned int member : members)
+    {
+        Vector3f x[num_samples];
+        boundary_samples(surfels[member], x);
+
+        for (unsigned int i(0); i < num_samples; ++i)
+        {
+            Vector3f d = x[i] - seed.c;
+            samples.push_back(Vector2f(t1.dot(d), t2.dot(d)));
+            mean += samples.back();
+        }
+
+        for (unsigned int i(0); i < 4; ++i)
+        {
+            rgba[i] += (surfels[member].rgba >> (8 * i)) & 0xff;
+        }
+    }
+
+    mean /= static_cast<float>(samples.size());
+
+    Matrix2f C = Matrix2f::Zero();
+    for (auto const& x : samples)
+    {
+        C += (x - mean) * (x - mean).transpose();
+    }
+
+    SelfAdjointEigenSolver<Matrix2f> es;
+    es.computeDirect(C);
+
+    Vector2f e1 = es.eigenvectors().col(1);
+    Vector2f e2 = es.eigenvectors().col(0);
+
+    float l1 = std::max(es.eigenvalues()(1), 1e-20f);
+    float l2 = std::max(es.eigenvalues()(0), l1 / (max_anisotropy
+        * max_anisotropy));
+
+    // Scale the ellipse until it contains all samples.
+    float s2(0.0f);
+    for (auto const& x : samples)
+    {
+        float a = e1.dot(x - mean), b = e2.dot(x - mean);
+        s2 = std::max(s2, a * a / l1 + b * b / l2);
+    }
+
+    float s = std::sqrt(s2);
+
+    Surfel merged;
+    merged.c = seed.c + mean.x() * t1 + mean.y() * t2;
+    merged.u = s * std::sqrt(l1) * (e1.x() * t1 + e1.y() * t2);
+    merged.v = s * std::sqrt(l2) * (e2.x() * t1 + e2.y() * t2);
+    merged.p = Vector3f::Zero();
+
+    if (merged.u.cross(merged.v).dot(n0) < 0.0f)
+    {
+        merged.u.swap(merged.v);
+    }
+
+    merged.rgba = 0;
+    for (unsigned int i(0); i < 4; ++i)
+    {
+        unsigned int n = static_cast<unsigned int>(members.size());
+        merged.rgba |= ((rgba[i] + n / 2) / n) << (8 * i);
+    }
+
+    return merged;
+}
+
+}
+
+void
+decimate(std::vector<Surfel> const& surfels, std::vector<Surfel>& decimated,
+    float max_distance, float max_angle, unsigned int max_color_difference,
+    unsigned int cluster_size)
+{
+    std::vector<Vector3f> centers(surfels.size());
+    for (std::size_t i(0); i < surfels.size(); ++i)
+    {
+        centers[i] = surfels[i].c;
+    }
+
+    KdTree tree(centers);
+
+    float const cos_max_angle = std::cos(max_angle);
+
+    std::vector<unsigned char> merged(surfels.size(), 0);
+    std::vector<std::pair<float, unsigned int>> neighbors;
+    std::vector<unsigned int> members;
+
+    decimated.clear();
+
+    // Seeds are visited in tree order, i.e. clusters grow in spatially
+    // coherent order.
+    for (unsigned int index : tree.indices())
+    {
+        if (merged[index])
+        {
+            continue;
+        }
+
+        merged[index] = 1;
+
+        Surfel const& seed = surfels[index];
+        Vector3f n0 = seed.u.cross(seed.v);
+
+        if (!seed.p.isZero() || !(n0.squaredNorm() > 0.0f))
+        {
+            decimated.push_back(seed);
+            continue;
+        }
+
+        n0.normalize();
+
+        tree.knn(seed.c, cluster_size, neighbors);
+        members.assign(1, index);
+
+        for (auto const& neighbor : neighbors)
+        {
+            unsigned int j = neighbor.second;
+            Surfel const& surfel = surfels[j];
+
+            if (merged[j] || !surfel.p.isZero()
+                || !similar_color(seed.rgba, surfel.rgba,
+                    max_color_difference)
+                || !(n0.dot(surfel.u.cross(surfel.v).normalized())
+                    >= cos_max_angle))
+            {
+                continue;
+            }
+
+            Vector3f x[num_samples];
+            boundary_samples(surfel, x);
+
+            bool within(true);
+            for (unsigned int i(0); i < num_samples && within; ++i)
+            {
+                within = std::abs(n0.dot(x[i] - seed.c)) <= max_distance;
+            }
+
+            if (within)
+            {
+                members.push_back(j);
+                merged[j] = 1;
+            }
+        }
+
+        if (members.size() == 1)
+        {
+            decimated.push_back(seed);
+        }
+        else
+        {
+            decimated.push_back(merge(surfels, members, n0));
+        }
+    }
+}
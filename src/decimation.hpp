@@ -0,0 +1,43 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef DECIMATION_HPP
+#define DECIMATION_HPP
+
+#include "surfel.hpp"
+
+#include <vector>
+
+// Simplifies a set of surfels by greedily merging each surfel with those of
+// its nearest neighbors which
+//   - deviate from its plane by at most max_distance,
+//   - have a normal within max_angle (in radians) of its normal, and
+//   - differ in each color channel by at most max_color_difference.
+// The merged surfel is an ellipse in the plane of the seed surfel bounding
+// all merged ellipses. At most cluster_size surfels are merged into one.
+// Surfels with a clipping plane are kept as they are, since merging them
+// would lose the sharp feature they represent.
+void decimate(std::vector<Surfel> const& surfels,
+    std::vector<Surfel>& decimated, float max_distance, float max_angle,
+    unsigned int max_color_difference = 16, unsigned int cluster_size = 16);
+
+#endif // DECIMATION_HPP
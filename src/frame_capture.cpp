@@ -0,0 +1,330 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "frame_capture.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+const unsigned int FrameCapture::num_buffers;
+
+namespace
+{
+
+unsigned int
+channel_index(FrameCapture::Channel channel)
+{
+    switch (channel)
+    {
+        case FrameCapture::depth:
+            return 1;
+        case FrameCapture::normal:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+}
+
+FrameCapture::Frame::Frame()
+    : index(0), width(0), height(0)
+{
+}
+
+FrameCapture::FrameCapture()
+    : m_current(0), m_oldest(0), m_in_flight(0), m_frames(0), m_stalls(0),
+      m_writer_stalls(0), m_writing(false)
+{
+    for (Slot& slot : m_slots)
+    {
+        std::fill(slot.pbo, slot.pbo + 3, 0);
+        std::fill(slot.bytes, slot.bytes + 3, 0);
+        slot.channels = 0;
+        slot.fence = nullptr;
+    }
+}
+
+FrameCapture::~FrameCapture()
+{
+    finish();
+    set_consumer(nullptr);
+
+    for (Slot& slot : m_slots)
+    {
+        glDeleteBuffers(3, slot.pbo);
+    }
+}
+
+void
+FrameCapture::set_consumer(std::function<void (Frame&)> consumer,
+    bool writer_thread)
+{
+    if (m_writer.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_writing = false;
+        }
+
+        m_changed.notify_all();
+        m_writer.join();
+    }
+
+    m_consumer = consumer;
+
+    if (consumer && writer_thread)
+    {
+        m_writing = true;
+        m_writer = std::thread(&FrameCapture::write, this);
+    }
+}
+
+void
+FrameCapture::begin(GLsizei width, GLsizei height)
+{
+    if (m_in_flight == num_buffers)
+    {
+        deliver(m_slots[m_oldest], true);
+    }
+
+    Slot& slot = m_slots[m_current];
+
+    if (slot.pbo[0] == 0)
+    {
+        glGenBuffers(3, slot.pbo);
+    }
+
+    slot.channels = 0;
+    slot.frame.index = m_frames++;
+    slot.frame.width = width;
+    slot.frame.height = height;
+}
+
+void
+FrameCapture::read(Channel channel)
+{
+    Slot& slot = m_slots[m_current];
+    unsigned int i = channel_index(channel);
+
+    GLenum format = GL_RGBA, type = GL_UNSIGNED_BYTE;
+    std::size_t pixel_bytes(4);
+
+    if (channel == depth)
+    {
+        format = GL_DEPTH_COMPONENT;
+        type = GL_FLOAT;
+    }
+    else if (channel == normal)
+    {
+        format = GL_RGB;
+        type = GL_FLOAT;
+        pixel_bytes = 3 * sizeof(float);
+    }
+
+    std::size_t bytes = pixel_bytes * slot.frame.width * slot.frame.height;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo[i]);
+
+    if (slot.bytes[i] != bytes)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        slot.bytes[i] = bytes;
+    }
+
+    GLint alignment;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    glReadPixels(0, 0, slot.frame.width, slot.frame.height, format, type,
+        nullptr);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.channels |= channel;
+}
+
+void
+FrameCapture::end()
+{
+    Slot& slot = m_slots[m_current];
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    m_current = (m_current + 1) % num_buffers;
+    ++m_in_flight;
+
+    // Frames are delivered in order as long as they have completed.
+    while (m_in_flight > 0)
+    {
+        Slot& oldest = m_slots[m_oldest];
+
+        GLenum result = glClientWaitSync(oldest.fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            break;
+        }
+
+        deliver(oldest, false);
+    }
+}
+
+void
+FrameCapture::finish()
+{
+    while (m_in_flight > 0)
+    {
+        deliver(m_slots[m_oldest], true);
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_changed.wait(lock, [this] { return m_queue.empty(); });
+}
+
+std::size_t
+FrameCapture::captured_frames() const
+{
+    return m_frames;
+}
+
+std::size_t
+FrameCapture::stalls() const
+{
+    return m_stalls;
+}
+
+std::size_t
+FrameCapture::writer_stalls() const
+{
+    return m_writer_stalls;
+}
+
+void
+FrameCapture::deliver(Slot& slot, bool wait)
+{
+    if (wait)
+    {
+        GLenum result = glClientWaitSync(slot.fence,
+            GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            ++m_stalls;
+
+            do
+            {
+                result = glClientWaitSync(slot.fence,
+                    GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            }
+            while (result == GL_TIMEOUT_EXPIRED);
+        }
+    }
+
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    Frame& frame = slot.frame;
+    void* data[3] = { nullptr, nullptr, nullptr };
+
+    frame.rgba.resize(slot.channels & color ? slot.bytes[0] : 0);
+    frame.depth.resize(slot.channels & depth ? slot.bytes[1]
+        / sizeof(float) : 0);
+    frame.normal.resize(slot.channels & normal ? slot.bytes[2]
+        / sizeof(float) : 0);
+
+    data[0] = frame.rgba.data();
+    data[1] = frame.depth.data();
+    data[2] = frame.normal.data();
+
+    for (unsigned int i(0); i < 3; ++i)
+    {
+        if (!(slot.channels & (1u << i)))
+        {
+            continue;
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo[i]);
+
+        void const* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+            slot.bytes[i], GL_MAP_READ_BIT);
+        if (pixels)
+        {
+            std::memcpy(data[i], pixels, slot.bytes[i]);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_oldest = (m_oldest + 1) % num_buffers;
+    --m_in_flight;
+
+    if (m_writer.joinable())
+    {
+        {
+            // The queue includes the frame being consumed.
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_queue.size() >= num_buffers)
+            {
+                ++m_writer_stalls;
+                m_changed.wait(lock, [this] {
+                    return m_queue.size() < num_buffers; });
+            }
+
+            m_queue.push_back(Frame());
+            std::swap(m_queue.back(), frame);
+        }
+
+        m_changed.notify_all();
+    }
+    else if (m_consumer)
+    {
+        m_consumer(frame);
+    }
+}
+
+void
+FrameCapture::write()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;)
+    {
+        m_changed.wait(lock, [this] {
+            return !m_writing || !m_queue.empty(); });
+
+        if (m_queue.empty())
+        {
+            break;
+        }
+
+        // The frame stays queued while it is consumed, such that finish()
+        // waits for it.
+        lock.unlock();
+        m_consumer(m_queue.front());
+        lock.lock();
+
+        m_queue.pop_front();
+        m_changed.notify_all();
+    }
+}
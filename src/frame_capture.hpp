@@ -0,0 +1,128 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef FRAME_CAPTURE_HPP
+#define FRAME_CAPTURE_HPP
+
+#include <GL/glew.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Reads frames back through a ring of pixel buffer objects. Each read is
+// fenced and its pixels are mapped once the GPU has completed it, such that
+// frames are delivered up to num_buffers - 1 frames late without stalling
+// the pipeline. Frames are delivered to a consumer on the GL thread, or on
+// a writer thread, e.g. to encode them to disk. The writer thread holds at
+// most num_buffers frames, beyond which the GL thread waits for it rather
+// than dropping frames.
+class FrameCapture
+{
+
+public:
+    static const unsigned int num_buffers = 3;
+
+    enum Channel
+    {
+        color = 1,
+        depth = 2,
+        normal = 4
+    };
+
+    // Pixels of a frame in bottom-up row order. The color holds 8-bit RGBA,
+    // the depth one float and the normal three floats per pixel. Channels
+    // that were not read are empty.
+    struct Frame
+    {
+        Frame();
+
+        std::size_t index;
+        GLsizei width, height;
+        std::vector<unsigned char> rgba;
+        std::vector<float> depth, normal;
+    };
+
+    FrameCapture();
+    ~FrameCapture();
+
+    // The consumer may take the contents of the frame. With a writer
+    // thread, it is called on that thread in the order of the frames.
+    void set_consumer(std::function<void (Frame&)> consumer,
+        bool writer_thread = false);
+
+    // Starts a frame of the given size, which delivers the oldest frame
+    // first if all buffers are in flight.
+    void begin(GLsizei width, GLsizei height);
+
+    // Reads a channel of the current read framebuffer into the frame.
+    void read(Channel channel);
+
+    // Fences the frame and delivers the frames completed since.
+    void end();
+
+    // Delivers all frames in flight, waiting for the GPU, and for the
+    // writer thread to consume them.
+    void finish();
+
+    std::size_t captured_frames() const;
+
+    // Number of frames that had to wait for the GPU when delivered.
+    std::size_t stalls() const;
+
+    // Number of frames that had to wait for the writer thread to consume
+    // a frame when delivered.
+    std::size_t writer_stalls() const;
+
+private:
+    struct Slot
+    {
+        GLuint pbo[3];
+        std::size_t bytes[3];
+        unsigned int channels;
+        GLsync fence;
+        Frame frame;
+    };
+
+    void deliver(Slot& slot, bool wait);
+    void write();
+
+private:
+    Slot m_slots[num_buffers];
+    unsigned int m_current, m_oldest, m_in_flight;
+    std::size_t m_frames, m_stalls, m_writer_stalls;
+
+    std::function<void (Frame&)> m_consumer;
+
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::deque<Frame> m_queue;
+    bool m_writing;
+};
+
+#endif // FRAME_CAPTURE_HPP
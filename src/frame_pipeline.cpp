@@ -0,0 +1,190 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "frame_pipeline.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+
+unsigned int const no_slot = std::numeric_limits<unsigned int>::max();
+
+}
+
+FramePipeline::Statistics::Statistics()
+    : prepared_frames(0), consumed_frames(0), waits(0), queue_depth(0),
+      latency_ms(0.0)
+{
+}
+
+FramePipeline::FramePipeline()
+    : m_running(false), m_max_ahead(num_frames - 1), m_acquired(no_slot)
+{
+}
+
+FramePipeline::~FramePipeline()
+{
+    stop();
+}
+
+void
+FramePipeline::start(std::function<void (unsigned int)> prepare,
+    unsigned int max_ahead)
+{
+    stop();
+
+    m_prepare = prepare;
+    m_max_ahead = std::max(1u, std::min(max_ahead, num_frames - 1));
+    m_statistics = Statistics();
+
+    m_free.clear();
+    m_ready.clear();
+    for (unsigned int i(0); i < num_frames; ++i)
+    {
+        m_free.push_back(i);
+    }
+
+    m_acquired = no_slot;
+    m_running = true;
+    m_worker = std::thread(&FramePipeline::run, this);
+}
+
+void
+FramePipeline::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+
+    m_changed.notify_all();
+
+    if (m_worker.joinable())
+    {
+        m_worker.join();
+    }
+}
+
+bool
+FramePipeline::running() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running;
+}
+
+unsigned int
+FramePipeline::acquire()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (m_ready.empty())
+    {
+        ++m_statistics.waits;
+        m_changed.wait(lock, [this] {
+            return !m_running || !m_ready.empty(); });
+    }
+
+    if (m_ready.empty())
+    {
+        return num_frames;
+    }
+
+    m_statistics.queue_depth = m_ready.size();
+
+    m_acquired = m_ready.front();
+    m_ready.pop_front();
+
+    std::chrono::duration<double, std::milli> latency = Clock::now()
+        - m_started[m_acquired];
+    m_statistics.latency_ms = latency.count();
+    ++m_statistics.consumed_frames;
+
+    // The worker may prepare another frame.
+    unsigned int slot = m_acquired;
+    lock.unlock();
+    m_changed.notify_all();
+
+    return slot;
+}
+
+void
+FramePipeline::release()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_acquired == no_slot)
+        {
+            return;
+        }
+
+        m_free.push_back(m_acquired);
+        m_acquired = no_slot;
+    }
+
+    m_changed.notify_all();
+}
+
+FramePipeline::Statistics
+FramePipeline::statistics() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_statistics;
+}
+
+void
+FramePipeline::run()
+{
+    for (;;)
+    {
+        unsigned int slot;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_changed.wait(lock, [this] {
+                return !m_running || (!m_free.empty()
+                    && m_ready.size() < m_max_ahead); });
+
+            if (!m_running)
+            {
+                break;
+            }
+
+            slot = m_free.front();
+            m_free.pop_front();
+            m_started[slot] = Clock::now();
+        }
+
+        m_prepare(slot);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_ready.push_back(slot);
+            ++m_statistics.prepared_frames;
+        }
+
+        m_changed.notify_all();
+    }
+}
@@ -0,0 +1,101 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef FRAME_PIPELINE_HPP
+#define FRAME_PIPELINE_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Prepares frames on a worker thread ahead of the thread consuming them.
+// The frames are kept by the caller in num_frames slots: while the
+// consumer uses one slot, the worker fills the others in turn, such that
+// preparing the next frame overlaps rendering the current one. The worker
+// prepares at most a given number of frames ahead, which bounds the
+// latency of inputs read while preparing.
+class FramePipeline
+{
+
+public:
+    static const unsigned int num_frames = 3;
+
+    struct Statistics
+    {
+        Statistics();
+
+        std::size_t prepared_frames, consumed_frames;
+
+        // Number of times acquire() had to wait for the worker.
+        std::size_t waits;
+
+        // Prepared frames queued at the last acquire() and the time from
+        // the start of preparing its frame until it was acquired.
+        std::size_t queue_depth;
+        double latency_ms;
+    };
+
+    FramePipeline();
+    ~FramePipeline();
+
+    // Starts the worker, which calls prepare with the slot to fill while
+    // fewer than max_ahead prepared frames are waiting.
+    void start(std::function<void (unsigned int)> prepare,
+        unsigned int max_ahead = num_frames - 1);
+    void stop();
+
+    bool running() const;
+
+    // Waits for the next prepared frame and returns its slot, which stays
+    // valid until release(). Returns num_frames if the worker is stopped.
+    unsigned int acquire();
+    void release();
+
+    Statistics statistics() const;
+
+private:
+    void run();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    std::function<void (unsigned int)> m_prepare;
+    std::thread m_worker;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_changed;
+    bool m_running;
+    unsigned int m_max_ahead;
+
+    std::deque<unsigned int> m_free, m_ready;
+    unsigned int m_acquired;
+    Clock::time_point m_started[num_frames];
+
+    Statistics m_statistics;
+};
+
+#endif // FRAME_PIPELINE_HPP
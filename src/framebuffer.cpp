@@ -43,6 +43,7 @@ struct Framebuffer::Impl
     virtual void resize_depth_texture(GLuint texture,
         GLsizei width, GLsizei height) = 0;
     virtual bool multisample() const = 0;
+    virtual GLsizei layers() const = 0;
 };
 
 struct Framebuffer::Default : public Framebuffer::Impl
@@ -104,6 +105,11 @@ struct Framebuffer::Default : public Framebuffer::Impl
     {
         return false;
     }
+
+    GLsizei layers() const
+    {
+        return 0;
+    }
 };
 
 struct Framebuffer::Multisample : public Framebuffer::Impl
@@ -161,11 +167,92 @@ struct Framebuffer::Multisample : public Framebuffer::Impl
     {
         return true;
     }
+
+    GLsizei layers() const
+    {
+        return 0;
+    }
+};
+
+struct Framebuffer::Layered : public Framebuffer::Impl
+{
+    Layered(GLsizei layers)
+        : m_layers(layers)
+    {
+    }
+
+    void framebuffer_texture_2d(GLenum target,
+        GLenum attachment, GLuint texture, GLint level)
+    {
+        glFramebufferTexture(target, attachment, texture, level);
+    }
+
+    // Renderbuffers cannot be layered. The depth attachment of a layered
+    // framebuffer is therefore always a texture array.
+    void renderbuffer_storage(GLenum target,
+        GLenum internalformat, GLsizei width, GLsizei height)
+    {
+        glRenderbufferStorage(target, internalformat,
+            width, height);
+    }
+
+    void allocate_depth_texture(GLuint texture,
+        GLsizei width, GLsizei height)
+    {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F,
+            width, height, m_layers, 0, GL_DEPTH_COMPONENT, GL_FLOAT,
+            nullptr);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    void allocate_rgba_texture(GLuint texture,
+        GLsizei width, GLsizei height)
+    {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA32F,
+            width, height, m_layers, 0, GL_RGBA, GL_FLOAT, nullptr);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    void resize_rgba_texture(GLuint texture, GLsizei width, GLsizei height)
+    {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA32F,
+            width, height, m_layers, 0, GL_RGBA, GL_FLOAT, nullptr);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    void resize_depth_texture(GLuint texture, GLsizei width, GLsizei height)
+    {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F,
+            width, height, m_layers, 0, GL_DEPTH_COMPONENT, GL_FLOAT,
+            nullptr);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    bool multisample() const
+    {
+        return false;
+    }
+
+    GLsizei layers() const
+    {
+        return m_layers;
+    }
+
+    GLsizei m_layers;
 };
 
 Framebuffer::Framebuffer()
-    : m_fbo(0), m_color(0), m_normal(0), m_depth(0),
-      m_pimpl(new Default())
+    : m_fbo(0), m_color(0), m_normal(0), m_depth(0), m_width(0),
+      m_height(0), m_pimpl(new Default())
 {
     // Create framebuffer object.
     glGenFramebuffers(1, &m_fbo);
@@ -194,6 +281,11 @@ Framebuffer::color_texture()
 void
 Framebuffer::enable_depth_texture()
 {
+    if (m_pimpl->layers() > 0)
+    {
+        return;
+    }
+
     bind();
 
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
@@ -214,6 +306,11 @@ Framebuffer::enable_depth_texture()
 void
 Framebuffer::disable_depth_texture()
 {
+    if (m_pimpl->layers() > 0)
+    {
+        return;
+    }
+
     bind();
 
     m_pimpl->framebuffer_texture_2d(GL_FRAMEBUFFER,
@@ -286,49 +383,87 @@ Framebuffer::set_multisample(bool enable)
 {
     if (m_pimpl->multisample() != enable)
     {
-        bind();
-
-        GLint type;
-        glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER,
-            GL_COLOR_ATTACHMENT1, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &type);
-
-        remove_and_delete_attachments();
-
-        if (m_pimpl->multisample())
+        if (enable)
         {
-            m_pimpl = std::unique_ptr<Framebuffer::Impl>(
-                new Framebuffer::Default());
+            replace_impl(new Framebuffer::Multisample());
         }
         else
         {
-            m_pimpl = std::unique_ptr<Framebuffer::Impl>(
-                new Framebuffer::Multisample());
+            replace_impl(new Framebuffer::Default());
         }
+    }
+}
 
-        initialize();
-        if (type == GL_TEXTURE)
+void
+Framebuffer::set_layers(GLsizei layers)
+{
+    if (m_pimpl->layers() != layers)
+    {
+        if (layers > 0)
         {
-            attach_normal_texture();
-            enable_depth_texture();
+            replace_impl(new Framebuffer::Layered(layers));
         }
-
-#ifndef NDEBUG
-        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-        if (status != GL_FRAMEBUFFER_COMPLETE)
+        else
         {
-            std::cerr << __FILE__ << "(" << __LINE__ << "): "
-                << GLviz::get_gl_framebuffer_status_string(status) << std::endl;
+            replace_impl(new Framebuffer::Default());
         }
+    }
+}
 
-        GLenum gl_error = glGetError();
-        if (GL_NO_ERROR != gl_error)
-        {
-            std::cerr << __FILE__ << "(" << __LINE__ << "): "
-                << GLviz::get_gl_error_string(gl_error) << std::endl;
-        }
-#endif
-        unbind();
+GLsizei
+Framebuffer::layers() const
+{
+    return m_pimpl->layers();
+}
+
+GLsizei
+Framebuffer::width() const
+{
+    return m_width;
+}
+
+GLsizei
+Framebuffer::height() const
+{
+    return m_height;
+}
+
+void
+Framebuffer::replace_impl(Impl* impl)
+{
+    bind();
+
+    GLint type;
+    glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER,
+        GL_COLOR_ATTACHMENT1, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &type);
+
+    remove_and_delete_attachments();
+
+    m_pimpl = std::unique_ptr<Framebuffer::Impl>(impl);
+
+    initialize();
+    if (type == GL_TEXTURE)
+    {
+        attach_normal_texture();
+        enable_depth_texture();
     }
+
+#ifndef NDEBUG
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << __FILE__ << "(" << __LINE__ << "): "
+            << GLviz::get_gl_framebuffer_status_string(status) << std::endl;
+    }
+
+    GLenum gl_error = glGetError();
+    if (GL_NO_ERROR != gl_error)
+    {
+        std::cerr << __FILE__ << "(" << __LINE__ << "): "
+            << GLviz::get_gl_error_string(gl_error) << std::endl;
+    }
+#endif
+    unbind();
 }
 
 void
@@ -346,6 +481,9 @@ Framebuffer::unbind()
 void
 Framebuffer::reshape(GLint width, GLint height)
 {
+    m_width = width;
+    m_height = height;
+
     bind();
 
     GLenum attachment[2] = {
@@ -420,20 +558,34 @@ Framebuffer::initialize()
     GLint viewport[4];
     glGetIntegerv(GL_VIEWPORT, viewport);
 
+    m_width = viewport[2];
+    m_height = viewport[3];
+
     // Attach color texture to framebuffer object.
     glGenTextures(1, &m_color);
     m_pimpl->allocate_rgba_texture(m_color, viewport[2], viewport[3]);
     m_pimpl->framebuffer_texture_2d(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
         m_color, 0);
 
-    // Attach renderbuffer object to framebuffer object.
-    glGenRenderbuffers(1, &m_depth);
-    glBindRenderbuffer(GL_RENDERBUFFER, m_depth);
-    m_pimpl->renderbuffer_storage(GL_RENDERBUFFER,
-        GL_DEPTH_COMPONENT32F, viewport[2], viewport[3]);
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
-        GL_RENDERBUFFER, m_depth);
+    if (m_pimpl->layers() > 0)
+    {
+        // Attach depth texture array to framebuffer object.
+        glGenTextures(1, &m_depth);
+        m_pimpl->allocate_depth_texture(m_depth, viewport[2], viewport[3]);
+        m_pimpl->framebuffer_texture_2d(GL_FRAMEBUFFER,
+            GL_DEPTH_ATTACHMENT, m_depth, 0);
+    }
+    else
+    {
+        // Attach renderbuffer object to framebuffer object.
+        glGenRenderbuffers(1, &m_depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, m_depth);
+        m_pimpl->renderbuffer_storage(GL_RENDERBUFFER,
+            GL_DEPTH_COMPONENT32F, viewport[2], viewport[3]);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+            GL_RENDERBUFFER, m_depth);
+    }
 
     GLenum buffers[] = { GL_COLOR_ATTACHMENT0 };
     glDrawBuffers(1, buffers);
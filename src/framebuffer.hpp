@@ -45,6 +45,15 @@ public:
 
     void set_multisample(bool enable = true);
 
+    // Allocates all attachments as texture arrays with the given number
+    // of layers, or as ordinary textures if layers is zero. Layered
+    // framebuffers are not multisampled.
+    void set_layers(GLsizei layers);
+    GLsizei layers() const;
+
+    GLsizei width() const;
+    GLsizei height() const;
+
     void bind();
     void unbind();
     void reshape(GLint width, GLint height);
@@ -53,12 +62,16 @@ private:
     void initialize();
     void remove_and_delete_attachments();
 
-    GLuint m_fbo;
-    GLuint m_color, m_normal, m_depth;
-
     struct Impl;
     struct Default;
     struct Multisample;
+    struct Layered;
+
+    void replace_impl(Impl* impl);
+
+    GLuint m_fbo;
+    GLuint m_color, m_normal, m_depth;
+    GLsizei m_width, m_height;
 
     std::unique_ptr<Impl> m_pimpl;
 };
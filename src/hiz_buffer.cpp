@@ -0,0 +1,396 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "hiz_buffer.hpp"
+
+#include <GLviz/utility.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using namespace Eigen;
+
+namespace
+{
+
+GLuint
+create_framebuffer(GLenum attachment, GLuint texture)
+{
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D,
+        texture, 0);
+
+    if (attachment == GL_DEPTH_ATTACHMENT)
+    {
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Warning: Incomplete hierarchical z-buffer framebuffer."
+            << std::endl;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    return fbo;
+}
+
+}
+
+const GLsizei HiZBuffer::max_size;
+
+HiZBuffer::HiZBuffer()
+    : m_depth_fbo(0), m_depth(0), m_block_size(1), m_current(0)
+{
+    std::fill(m_viewport, m_viewport + 4, 0);
+
+    for (Readback& readback : m_readback)
+    {
+        readback.width = readback.height = 0;
+        readback.block_size = 1;
+        readback.fence = nullptr;
+        glGenBuffers(1, &readback.pbo);
+    }
+}
+
+HiZBuffer::~HiZBuffer()
+{
+    release();
+
+    for (Readback& readback : m_readback)
+    {
+        glDeleteSync(readback.fence);
+        glDeleteBuffers(1, &readback.pbo);
+    }
+}
+
+void
+HiZBuffer::allocate(GLsizei width, GLsizei height)
+{
+    release();
+
+    glGenTextures(1, &m_depth);
+    glBindTexture(GL_TEXTURE_2D, m_depth);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, width, height, 0,
+        GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+
+    m_depth_fbo = create_framebuffer(GL_DEPTH_ATTACHMENT, m_depth);
+
+    m_block_size = 1;
+
+    while (width > max_size || height > max_size)
+    {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+        m_block_size *= 2;
+
+        Level level;
+        level.width = width;
+        level.height = height;
+
+        glGenTextures(1, &level.texture);
+        glBindTexture(GL_TEXTURE_2D, level.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED,
+            GL_FLOAT, nullptr);
+
+        level.fbo = create_framebuffer(GL_COLOR_ATTACHMENT0, level.texture);
+
+        m_pyramid.push_back(level);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void
+HiZBuffer::release()
+{
+    for (Level const& level : m_pyramid)
+    {
+        glDeleteTextures(1, &level.texture);
+        glDeleteFramebuffers(1, &level.fbo);
+    }
+
+    m_pyramid.clear();
+
+    glDeleteTextures(1, &m_depth);
+    glDeleteFramebuffers(1, &m_depth_fbo);
+
+    m_depth = 0;
+    m_depth_fbo = 0;
+}
+
+void
+HiZBuffer::build(GLuint quad_vao, Matrix4f const& modelview_projection)
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    if (m_depth == 0 || viewport[2] != m_viewport[2]
+        || viewport[3] != m_viewport[3])
+    {
+        allocate(viewport[2], viewport[3]);
+    }
+
+    std::copy(viewport, viewport + 4, m_viewport);
+
+    GLsizei width = viewport[2], height = viewport[3];
+
+    // Depth renderbuffers cannot be sampled, hence the copy.
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_depth_fbo);
+    glBlitFramebuffer(viewport[0], viewport[1], viewport[0] + width,
+        viewport[1] + height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT,
+        GL_NEAREST);
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    m_program.use();
+
+    try
+    {
+        m_program.set_uniform_1i("depth_texture", 0);
+    }
+    catch (uniform_not_found_error const& e)
+    {
+        std::cerr << "Warning: Failed to set a uniform variable." << std::endl
+            << e.what() << std::endl;
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(quad_vao);
+
+    for (std::size_t i(0); i < m_pyramid.size(); ++i)
+    {
+        glBindTexture(GL_TEXTURE_2D, i == 0 ? m_depth
+            : m_pyramid[i - 1].texture);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, m_pyramid[i].fbo);
+        glViewport(0, 0, m_pyramid[i].width, m_pyramid[i].height);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    m_program.unuse();
+
+    GLsizei coarse_width = width, coarse_height = height;
+    GLuint coarse_fbo = m_depth_fbo;
+    GLenum format = GL_DEPTH_COMPONENT;
+
+    if (!m_pyramid.empty())
+    {
+        coarse_width = m_pyramid.back().width;
+        coarse_height = m_pyramid.back().height;
+        coarse_fbo = m_pyramid.back().fbo;
+        format = GL_RED;
+    }
+
+    Readback& readback = m_readback[m_current];
+    readback.modelview_projection = modelview_projection;
+    std::copy(viewport, viewport + 4, readback.viewport);
+    readback.width = coarse_width;
+    readback.height = coarse_height;
+    readback.block_size = m_block_size;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, coarse_fbo);
+    if (format == GL_RED)
+    {
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+    }
+
+    GLint alignment;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(
+        sizeof(float) * static_cast<std::size_t>(coarse_width)
+        * static_cast<std::size_t>(coarse_height)), nullptr,
+        GL_STREAM_READ);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, coarse_width, coarse_height, format, GL_FLOAT,
+        nullptr);
+    glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glDeleteSync(readback.fence);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    m_current = 1 - m_current;
+    finish_readback(m_readback[m_current]);
+}
+
+void
+HiZBuffer::finish_readback(Readback& readback)
+{
+    if (!readback.fence)
+    {
+        return;
+    }
+
+    // The previous frame has usually completed on the GPU, in which case
+    // this returns without waiting. Waiting otherwise keeps the tested
+    // depth independent of the timing of the GPU.
+    GLenum status = glClientWaitSync(readback.fence,
+        GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+    {
+        m_max_depth.clear();
+        return;
+    }
+
+    std::size_t size = static_cast<std::size_t>(readback.width)
+        * static_cast<std::size_t>(readback.height);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+
+    void const* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+        static_cast<GLsizeiptr>(sizeof(float) * size), GL_MAP_READ_BIT);
+
+    if (data)
+    {
+        float const* depth = static_cast<float const*>(data);
+        m_max_depth.assign(depth, depth + size);
+        m_tested = readback;
+
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    else
+    {
+        m_max_depth.clear();
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void
+HiZBuffer::discard()
+{
+    for (Readback& readback : m_readback)
+    {
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+    }
+
+    m_max_depth.clear();
+}
+
+bool
+HiZBuffer::occluded(AlignedBox3f const& box, float margin) const
+{
+    if (m_max_depth.empty() || box.isEmpty())
+    {
+        return false;
+    }
+
+    Vector3f ndc_min = Vector3f::Constant(1.0f);
+    Vector3f ndc_max = Vector3f::Constant(-1.0f);
+
+    for (unsigned int i(0); i < 8; ++i)
+    {
+        Vector4f p = m_tested.modelview_projection * box.corner(
+            static_cast<AlignedBox3f::CornerType>(i)).homogeneous();
+
+        // Boxes reaching behind the near plane may cover any pixel.
+        if (p.w() <= 0.0f || p.z() < -p.w())
+        {
+            return false;
+        }
+
+        Vector3f ndc = p.head<3>() / p.w();
+
+        if (i == 0)
+        {
+            ndc_min = ndc_max = ndc;
+        }
+        else
+        {
+            ndc_min = ndc_min.cwiseMin(ndc);
+            ndc_max = ndc_max.cwiseMax(ndc);
+        }
+    }
+
+    GLint const* viewport = m_tested.viewport;
+    GLsizei const block_size = m_tested.block_size;
+
+    Vector2f ndc_margin(2.0f * margin / static_cast<float>(viewport[2]),
+        2.0f * margin / static_cast<float>(viewport[3]));
+    ndc_min.head<2>() -= ndc_margin;
+    ndc_max.head<2>() += ndc_margin;
+
+    // Boxes not entirely within the previous viewport may have come into
+    // view since. Those outside the current one are culled by the frustum.
+    if (ndc_min.x() < -1.0f || ndc_max.x() > 1.0f
+        || ndc_min.y() < -1.0f || ndc_max.y() > 1.0f)
+    {
+        return false;
+    }
+
+    float depth = 0.5f * (ndc_min.z() + 1.0f);
+
+    GLsizei const coarse_width = m_tested.width;
+    GLsizei const coarse_height = m_tested.height;
+
+    auto texel = [block_size](float ndc, GLsizei size, GLsizei extent) {
+        float pixel = 0.5f * (std::min(std::max(ndc, -1.0f), 1.0f) + 1.0f)
+            * static_cast<float>(extent);
+        return std::min(size - 1, static_cast<GLsizei>(
+            std::floor(pixel / static_cast<float>(block_size))));
+    };
+
+    GLsizei x0 = texel(ndc_min.x(), coarse_width, viewport[2]);
+    GLsizei x1 = texel(ndc_max.x(), coarse_width, viewport[2]);
+    GLsizei y0 = texel(ndc_min.y(), coarse_height, viewport[3]);
+    GLsizei y1 = texel(ndc_max.y(), coarse_height, viewport[3]);
+
+    for (GLsizei y(y0); y <= y1; ++y)
+    {
+        for (GLsizei x(x0); x <= x1; ++x)
+        {
+            if (depth <= m_max_depth[static_cast<std::size_t>(y)
+                * static_cast<std::size_t>(coarse_width) + x])
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
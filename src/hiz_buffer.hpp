@@ -0,0 +1,105 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef HIZ_BUFFER_HPP
+#define HIZ_BUFFER_HPP
+
+#include "program_hiz.hpp"
+
+#include <GL/glew.h>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <vector>
+
+// Hierarchical z-buffer holding the maximum depth of square pixel blocks.
+// The pyramid is reduced on the GPU and its coarsest level is read back
+// asynchronously through a pixel buffer object, such that bounding boxes
+// can be tested for occlusion on the CPU against the previous build.
+class HiZBuffer
+{
+
+public:
+    // The coarsest level is at most this many texels wide and high.
+    static const GLsizei max_size = 64;
+
+    HiZBuffer();
+    ~HiZBuffer();
+
+    // Builds the pyramid from the depth attachment of the framebuffer
+    // bound to GL_READ_FRAMEBUFFER, which must be single-sampled and match
+    // the current viewport, as rendered with the given matrix. Starts the
+    // read back of its coarsest level and finishes that of the previous
+    // build, which the GPU has usually completed by then. Leaves the
+    // viewport and the framebuffer bindings in an undefined state.
+    void build(GLuint quad_vao,
+        Eigen::Matrix4f const& modelview_projection);
+
+    // Returns true if the box lay within the viewport and entirely behind
+    // the depth of the previous build, as seen with its matrix.
+    // The projected box is enlarged by a margin in pixels, e.g. for the
+    // extent of a screen-space filter. Returns false before a second build.
+    bool occluded(Eigen::AlignedBox3f const& box, float margin = 0.0f) const;
+
+    // Discards the builds, e.g. after frames rendered without building,
+    // whose depth does not match the view any more.
+    void discard();
+
+private:
+    struct Level
+    {
+        GLsizei width, height;
+        GLuint fbo, texture;
+    };
+
+    // Coarsest level of a build in a pixel buffer object, with the pixels
+    // covered by each of its texels.
+    struct Readback
+    {
+        Eigen::Matrix4f modelview_projection;
+        GLint viewport[4];
+        GLsizei width, height, block_size;
+        GLuint pbo;
+        GLsync fence;
+    };
+
+    void allocate(GLsizei width, GLsizei height);
+    void release();
+    void finish_readback(Readback& readback);
+
+private:
+    ProgramHiZ m_program;
+
+    GLint m_viewport[4];
+    GLuint m_depth_fbo, m_depth;
+    std::vector<Level> m_pyramid;
+    GLsizei m_block_size;
+
+    // Read backs of the last two builds, the current one alternating.
+    Readback m_readback[2];
+    unsigned int m_current;
+
+    // Coarsest level of the previous build, tested by occluded().
+    std::vector<float> m_max_depth;
+    Readback m_tested;
+};
+
+#endif // HIZ_BUFFER_HPP
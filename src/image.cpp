@@ -0,0 +1,400 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "image.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+namespace
+{
+
+std::array<std::uint32_t, 256>
+crc_table()
+{
+    std::array<std::uint32_t, 256> table;
+
+    for (std::uint32_t n(0); n < 256; ++n)
+    {
+        std::uint32_t c = n;
+        for (unsigned int k(0); k < 8; ++k)
+        {
+            c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        table[n] = c;
+    }
+
+    return table;
+}
+
+std::uint32_t
+crc(std::uint32_t c, unsigned char const* data, std::size_t size)
+{
+    static const std::array<std::uint32_t, 256> table = crc_table();
+
+    for (std::size_t i(0); i < size; ++i)
+    {
+        c = table[(c ^ data[i]) & 0xff] ^ (c >> 8);
+    }
+
+    return c;
+}
+
+void
+append_u32(std::vector<unsigned char>& out, std::uint32_t x)
+{
+    out.push_back(static_cast<unsigned char>(x >> 24));
+    out.push_back(static_cast<unsigned char>(x >> 16));
+    out.push_back(static_cast<unsigned char>(x >> 8));
+    out.push_back(static_cast<unsigned char>(x));
+}
+
+// Chunk lengths must not exceed 2^31 - 1 bytes.
+std::size_t const max_chunk_size = 0x7fffffff;
+
+void
+write_chunk(std::ofstream& output, char const* type,
+    unsigned char const* data, std::size_t size)
+{
+    std::vector<unsigned char> header;
+    append_u32(header, static_cast<std::uint32_t>(size));
+    header.insert(header.end(), type, type + 4);
+
+    std::vector<unsigned char> footer;
+    append_u32(footer, crc(crc(0xffffffffu, header.data() + 4, 4), data,
+        size) ^ 0xffffffffu);
+
+    output.write(reinterpret_cast<char const*>(header.data()),
+        header.size());
+    output.write(reinterpret_cast<char const*>(data), size);
+    output.write(reinterpret_cast<char const*>(footer.data()),
+        footer.size());
+}
+
+void
+write_chunk(std::ofstream& output, char const* type,
+    std::vector<unsigned char> const& data)
+{
+    write_chunk(output, type, data.data(), data.size());
+}
+
+std::uint32_t
+read_u32(unsigned char const* data)
+{
+    return (static_cast<std::uint32_t>(data[0]) << 24)
+        | (static_cast<std::uint32_t>(data[1]) << 16)
+        | (static_cast<std::uint32_t>(data[2]) << 8)
+        | static_cast<std::uint32_t>(data[3]);
+}
+
+unsigned char
+paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+
+    if (pa <= pb && pa <= pc) return static_cast<unsigned char>(a);
+    if (pb <= pc) return static_cast<unsigned char>(b);
+    return static_cast<unsigned char>(c);
+}
+
+// Converts an sRGB color to CIE L*a*b* with D65 white point.
+std::array<float, 3>
+srgb_to_lab(unsigned char const* rgb)
+{
+    float c[3];
+    for (unsigned int i(0); i < 3; ++i)
+    {
+        float x = static_cast<float>(rgb[i]) / 255.0f;
+        c[i] = x <= 0.04045f ? x / 12.92f
+            : std::pow((x + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float xyz[3] = {
+        (0.4124f * c[0] + 0.3576f * c[1] + 0.1805f * c[2]) / 0.95047f,
+        (0.2126f * c[0] + 0.7152f * c[1] + 0.0722f * c[2]),
+        (0.0193f * c[0] + 0.1192f * c[1] + 0.9505f * c[2]) / 1.08883f
+    };
+
+    float f[3];
+    for (unsigned int i(0); i < 3; ++i)
+    {
+        f[i] = xyz[i] > 0.008856f ? std::cbrt(xyz[i])
+            : 7.787f * xyz[i] + 16.0f / 116.0f;
+    }
+
+    return {{ 116.0f * f[1] - 16.0f, 500.0f * (f[0] - f[1]),
+        200.0f * (f[1] - f[2]) }};
+}
+
+}
+
+void
+write_png(std::string const& filename, int width, int height,
+    std::vector<unsigned char> const& rgba)
+{
+    std::size_t const stride = 4 * static_cast<std::size_t>(width);
+
+    if (width <= 0 || height <= 0 || rgba.size() < stride * height)
+    {
+        throw std::runtime_error("Invalid image dimensions for "
+            + filename + ".");
+    }
+
+    std::ofstream output(filename, std::ios::binary);
+    if (!output.good())
+    {
+        throw std::runtime_error("Failed to open " + filename + ".");
+    }
+
+    unsigned char const signature[8] = {
+        0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'
+    };
+    output.write(reinterpret_cast<char const*>(signature), 8);
+
+    std::vector<unsigned char> header;
+    append_u32(header, static_cast<std::uint32_t>(width));
+    append_u32(header, static_cast<std::uint32_t>(height));
+    header.insert(header.end(), { 8, 6, 0, 0, 0 });
+    write_chunk(output, "IHDR", header);
+
+    // Scanlines are flipped to top-down order and prefixed by filter
+    // type 0.
+    std::vector<unsigned char> raw;
+    raw.reserve((stride + 1) * height);
+    for (int y(height - 1); y >= 0; --y)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgba.begin() + y * stride,
+            rgba.begin() + (y + 1) * stride);
+    }
+
+    // The zlib stream uses stored (uncompressed) deflate blocks. This
+    // avoids a dependency on zlib at the cost of larger files.
+    std::vector<unsigned char> idat;
+    idat.reserve(raw.size() + raw.size() / 65535 * 5 + 11);
+    idat.push_back(0x78);
+    idat.push_back(0x01);
+
+    std::uint32_t a(1), b(0);
+    for (std::size_t i(0); i < raw.size(); i += 65535)
+    {
+        std::size_t n = std::min<std::size_t>(65535, raw.size() - i);
+
+        idat.push_back(i + n == raw.size() ? 1 : 0);
+        idat.push_back(static_cast<unsigned char>(n));
+        idat.push_back(static_cast<unsigned char>(n >> 8));
+        idat.push_back(static_cast<unsigned char>(~n));
+        idat.push_back(static_cast<unsigned char>(~n >> 8));
+        idat.insert(idat.end(), raw.begin() + i, raw.begin() + i + n);
+
+        for (std::size_t j(i); j < i + n; ++j)
+        {
+            a = (a + raw[j]) % 65521;
+            b = (b + a) % 65521;
+        }
+    }
+    append_u32(idat, (b << 16) | a);
+
+    // Large images are split into several IDAT chunks, which together
+    // hold the compressed stream.
+    for (std::size_t i(0); i < idat.size(); i += max_chunk_size)
+    {
+        write_chunk(output, "IDAT", idat.data() + i, std::min(
+            max_chunk_size, idat.size() - i));
+    }
+    write_chunk(output, "IEND", std::vector<unsigned char>());
+
+    if (!output.good())
+    {
+        throw std::runtime_error("Failed to write " + filename + ".");
+    }
+}
+
+void
+read_png(std::string const& filename, int& width, int& height,
+    std::vector<unsigned char>& rgba)
+{
+    std::ifstream input(filename, std::ios::binary);
+    if (!input.good())
+    {
+        throw std::runtime_error("Failed to open " + filename + ".");
+    }
+
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(input)),
+        std::istreambuf_iterator<char>());
+
+    unsigned char const signature[8] = {
+        0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'
+    };
+
+    if (data.size() < 8 || !std::equal(signature, signature + 8,
+        data.begin()))
+    {
+        throw std::runtime_error(filename + " is not a PNG file.");
+    }
+
+    // Collect the IHDR and IDAT chunks.
+    std::vector<unsigned char> header, idat;
+    for (std::size_t i(8); i + 12 <= data.size();)
+    {
+        std::size_t n = read_u32(&data[i]);
+        if (i + 12 + n > data.size())
+        {
+            throw std::runtime_error(filename + " is truncated.");
+        }
+
+        std::string type(data.begin() + i + 4, data.begin() + i + 8);
+        if (type == "IHDR")
+        {
+            header.assign(data.begin() + i + 8, data.begin() + i + 8 + n);
+        }
+        else if (type == "IDAT")
+        {
+            idat.insert(idat.end(), data.begin() + i + 8,
+                data.begin() + i + 8 + n);
+        }
+
+        i += 12 + n;
+    }
+
+    if (header.size() != 13 || header[8] != 8 || header[9] != 6
+        || header[12] != 0)
+    {
+        throw std::runtime_error(filename
+            + " is not a non-interlaced 8-bit RGBA PNG file.");
+    }
+
+    width = static_cast<int>(read_u32(&header[0]));
+    height = static_cast<int>(read_u32(&header[4]));
+
+    std::size_t const stride = 4 * static_cast<std::size_t>(width);
+
+    // Inflate the zlib stream, which must consist of stored blocks.
+    std::vector<unsigned char> raw;
+    raw.reserve((stride + 1) * height);
+
+    bool final_block(false);
+    for (std::size_t i(2); !final_block;)
+    {
+        if (i + 5 > idat.size() || (idat[i] & 0x06) != 0)
+        {
+            throw std::runtime_error(filename
+                + " uses compressed deflate blocks, which are not"
+                " supported.");
+        }
+
+        final_block = (idat[i] & 0x01) != 0;
+        std::size_t n = idat[i + 1] | (idat[i + 2] << 8);
+        if (i + 5 + n > idat.size())
+        {
+            throw std::runtime_error(filename + " is truncated.");
+        }
+
+        raw.insert(raw.end(), idat.begin() + i + 5, idat.begin() + i + 5 + n);
+        i += 5 + n;
+    }
+
+    if (raw.size() != (stride + 1) * height)
+    {
+        throw std::runtime_error(filename + " has an invalid size.");
+    }
+
+    // Undo the scanline filters and flip rows to bottom-up order.
+    rgba.resize(stride * height);
+
+    std::vector<unsigned char> prior(stride, 0), line(stride);
+    for (int y(0); y < height; ++y)
+    {
+        unsigned char const* src = &raw[y * (stride + 1)];
+        unsigned char const filter = src[0];
+        ++src;
+
+        for (std::size_t x(0); x < stride; ++x)
+        {
+            int a = x >= 4 ? line[x - 4] : 0;
+            int b = prior[x];
+            int c = x >= 4 ? prior[x - 4] : 0;
+
+            switch (filter)
+            {
+                case 0: line[x] = src[x]; break;
+                case 1: line[x] = static_cast<unsigned char>(src[x] + a); break;
+                case 2: line[x] = static_cast<unsigned char>(src[x] + b); break;
+                case 3: line[x] = static_cast<unsigned char>(src[x]
+                    + (a + b) / 2); break;
+                case 4: line[x] = static_cast<unsigned char>(src[x]
+                    + paeth(a, b, c)); break;
+                default:
+                    throw std::runtime_error(filename
+                        + " uses an invalid filter type.");
+            }
+        }
+
+        std::copy(line.begin(), line.end(),
+            rgba.begin() + (height - 1 - y) * stride);
+        std::swap(prior, line);
+    }
+}
+
+float
+perceptual_difference(int width, int height,
+    std::vector<unsigned char> const& rgba0,
+    std::vector<unsigned char> const& rgba1, float threshold)
+{
+    std::size_t const n = static_cast<std::size_t>(width) * height;
+
+    if (n == 0 || rgba0.size() < 4 * n || rgba1.size() < 4 * n)
+    {
+        throw std::runtime_error("Invalid image dimensions.");
+    }
+
+    std::size_t count(0);
+    for (std::size_t i(0); i < n; ++i)
+    {
+        if (std::equal(&rgba0[4 * i], &rgba0[4 * i] + 3, &rgba1[4 * i]))
+        {
+            continue;
+        }
+
+        std::array<float, 3> lab0 = srgb_to_lab(&rgba0[4 * i]);
+        std::array<float, 3> lab1 = srgb_to_lab(&rgba1[4 * i]);
+
+        float d = std::sqrt(
+            (lab0[0] - lab1[0]) * (lab0[0] - lab1[0]) +
+            (lab0[1] - lab1[1]) * (lab0[1] - lab1[1]) +
+            (lab0[2] - lab1[2]) * (lab0[2] - lab1[2]));
+
+        if (d > threshold)
+        {
+            ++count;
+        }
+    }
+
+    return static_cast<float>(count) / static_cast<float>(n);
+}
@@ -0,0 +1,47 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef IMAGE_HPP
+#define IMAGE_HPP
+
+#include <string>
+#include <vector>
+
+// Writes an 8-bit RGBA image to a PNG file. Rows are expected in bottom-up
+// order as returned by glReadPixels.
+void write_png(std::string const& filename, int width, int height,
+    std::vector<unsigned char> const& rgba);
+
+// Reads an 8-bit RGBA PNG file into rows in bottom-up order. Only the
+// uncompressed zlib streams produced by write_png are supported.
+void read_png(std::string const& filename, int& width, int& height,
+    std::vector<unsigned char>& rgba);
+
+// Returns the fraction of pixels whose color difference exceeds the given
+// threshold. The difference is measured as the Euclidean distance in CIE
+// L*a*b* space (CIE76), where a distance of about 2.3 corresponds to a just
+// noticeable difference. Both images must be of the same size.
+float perceptual_difference(int width, int height,
+    std::vector<unsigned char> const& rgba0,
+    std::vector<unsigned char> const& rgba1, float threshold = 2.3f);
+
+#endif // IMAGE_HPP
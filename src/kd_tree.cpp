@@ -0,0 +1,183 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "kd_tree.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <limits>
+
+using namespace Eigen;
+
+namespace
+{
+
+// Maximum number of points in a leaf.
+std::size_t const leaf_size = 8;
+
+}
+
+KdTree::KdTree(std::vector<Vector3f> const& points, unsigned int num_threads)
+    : m_points(points), m_depth(0)
+{
+    num_threads = hardware_threads(num_threads);
+
+    m_indices.resize(points.size());
+    for (std::size_t i(0); i < m_indices.size(); ++i)
+    {
+        m_indices[i] = static_cast<unsigned int>(i);
+    }
+
+    // All leaves are at the same depth, hence the inner nodes form a
+    // complete binary tree stored in level order and the point range of a
+    // node follows from halving the range of its parent.
+    while ((points.size() >> m_depth) > leaf_size)
+    {
+        ++m_depth;
+    }
+
+    m_nodes.resize((std::size_t(1) << m_depth) - 1);
+
+    // Subtrees are built in parallel up to the depth at which there is one
+    // subtree per thread.
+    unsigned int parallel_depth(0);
+    while ((1u << parallel_depth) < num_threads)
+    {
+        ++parallel_depth;
+    }
+
+    build(0, 0, points.size(), 0, parallel_depth);
+}
+
+void
+KdTree::build(std::size_t node, std::size_t b, std::size_t e,
+    unsigned int depth, unsigned int parallel_depth)
+{
+    if (depth == m_depth)
+    {
+        return;
+    }
+
+    Vector3f p_min = Vector3f::Constant(std::numeric_limits<float>::max());
+    Vector3f p_max = -p_min;
+
+    for (std::size_t i(b); i < e; ++i)
+    {
+        p_min = p_min.cwiseMin(m_points[m_indices[i]]);
+        p_max = p_max.cwiseMax(m_points[m_indices[i]]);
+    }
+
+    // Split at the median along the axis of largest extent.
+    unsigned int axis;
+    (p_max - p_min).maxCoeff(&axis);
+
+    std::size_t m = b + (e - b) / 2;
+    std::nth_element(m_indices.begin() + b, m_indices.begin() + m,
+        m_indices.begin() + e, [this, axis](unsigned int i, unsigned int j) {
+            return m_points[i][axis] < m_points[j][axis];
+        });
+
+    m_nodes[node].split = e > b ? m_points[m_indices[m]][axis] : 0.0f;
+    m_nodes[node].axis = axis;
+
+    // The children are built by two threads or by this one.
+    parallel_for(2, depth < parallel_depth ? 2 : 1, 1,
+        [&](std::size_t c0, std::size_t c1) {
+            for (std::size_t c = c0; c < c1; ++c)
+            {
+                build(2 * node + 1 + c, c == 0 ? b : m, c == 0 ? m : e,
+                    depth + 1, parallel_depth);
+            }
+        });
+}
+
+void
+KdTree::knn(Vector3f const& query, unsigned int k,
+    std::vector<std::pair<float, unsigned int>>& neighbors) const
+{
+    neighbors.clear();
+
+    if (k > 0)
+    {
+        search(0, 0, m_indices.size(), 0, query, k, neighbors);
+    }
+
+    std::sort_heap(neighbors.begin(), neighbors.end());
+}
+
+void
+KdTree::search(std::size_t node, std::size_t b, std::size_t e,
+    unsigned int depth, Vector3f const& query, unsigned int k,
+    std::vector<std::pair<float, unsigned int>>& heap) const
+{
+    if (depth == m_depth)
+    {
+        for (std::size_t i(b); i < e; ++i)
+        {
+            float d = (m_points[m_indices[i]] - query).squaredNorm();
+
+            if (heap.size() < k)
+            {
+                heap.emplace_back(d, m_indices[i]);
+                std::push_heap(heap.begin(), heap.end());
+            }
+            else if (d < heap.front().first)
+            {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.back() = std::make_pair(d, m_indices[i]);
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+
+        return;
+    }
+
+    std::size_t m = b + (e - b) / 2;
+    float diff = query[m_nodes[node].axis] - m_nodes[node].split;
+
+    // Visit the half containing the query point first, and the other half
+    // only if it may contain a closer point.
+    if (diff < 0.0f)
+    {
+        search(2 * node + 1, b, m, depth + 1, query, k, heap);
+
+        if (heap.size() < k || diff * diff < heap.front().first)
+        {
+            search(2 * node + 2, m, e, depth + 1, query, k, heap);
+        }
+    }
+    else
+    {
+        search(2 * node + 2, m, e, depth + 1, query, k, heap);
+
+        if (heap.size() < k || diff * diff < heap.front().first)
+        {
+            search(2 * node + 1, b, m, depth + 1, query, k, heap);
+        }
+    }
+}
+
+std::vector<unsigned int> const&
+KdTree::indices() const
+{
+    return m_indices;
+}
@@ -0,0 +1,71 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef KD_TREE_HPP
+#define KD_TREE_HPP
+
+#include <Eigen/Core>
+
+#include <utility>
+#include <vector>
+
+// Balanced kd-tree over a set of points for k-nearest-neighbor queries.
+// The tree stores a permutation of the point indices and one split plane
+// per inner node only, and refers to the points, which must outlive it.
+// It is built by a given number of threads, queries are thread-safe.
+class KdTree
+{
+
+public:
+    explicit KdTree(std::vector<Eigen::Vector3f> const& points,
+        unsigned int num_threads = 0);
+
+    // Finds the k nearest points to a query point. The neighbors are
+    // returned as pairs of squared distance and point index in ascending
+    // order of distance.
+    void knn(Eigen::Vector3f const& query, unsigned int k,
+        std::vector<std::pair<float, unsigned int>>& neighbors) const;
+
+    // Point indices in tree order, i.e. spatially coherent.
+    std::vector<unsigned int> const& indices() const;
+
+private:
+    struct Node
+    {
+        float split;
+        unsigned int axis;
+    };
+
+    void build(std::size_t node, std::size_t b, std::size_t e,
+        unsigned int depth, unsigned int parallel_depth);
+    void search(std::size_t node, std::size_t b, std::size_t e,
+        unsigned int depth, Eigen::Vector3f const& query, unsigned int k,
+        std::vector<std::pair<float, unsigned int>>& heap) const;
+
+private:
+    std::vector<Eigen::Vector3f> const& m_points;
+    std::vector<unsigned int> m_indices;
+    std::vector<Node> m_nodes;
+    unsigned int m_depth;
+};
+
+#endif // KD_TREE_HPP
@@ -24,8 +24,21 @@
 #include <GLviz/utility.hpp>
 
 #include "splat_renderer.hpp"
-
-#include "config.hpp"
+#include "cpu_renderer.hpp"
+#include "camera_path.hpp"
+#include "image.hpp"
+#include "preprocess.hpp"
+#include "ply.hpp"
+#include "point_cloud.hpp"
+#include "decimation.hpp"
+#include "spatial_sort.hpp"
+#include "procedural.hpp"
+#include "surfel_file.hpp"
+#include "memory_stats.hpp"
+#include "frame_pipeline.hpp"
+#include "frame_capture.hpp"
+#include "scenario.hpp"
+#include "telemetry.hpp"
 
 #include <Eigen/Core>
 
@@ -35,9 +48,18 @@
 #include <sstream>
 #include <vector>
 #include <array>
+#include <algorithm>
 #include <exception>
-
+#include <stdexcept>
+#include <chrono>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+#include <random>
 #include <thread>
+#include <mutex>
+#include <atomic>
 
 using namespace Eigen;
 
@@ -47,552 +69,907 @@ namespace
 GLviz::Camera g_camera;
 
 int g_model(1);
+std::string g_model_filename;
+std::size_t g_scene_size(1000000);
+std::string g_save_filename;
+std::size_t g_gpu_budget(0);
+std::size_t g_gpu_buffer_size(0);
+float g_decimation(0.0f);
+int g_reorder(0);
+bool g_animate(false);
 
 std::unique_ptr<SplatRenderer>  viz;
 std::vector<Surfel>             g_surfels;
 
-void load_triangle_mesh(std::string const& filename, std::vector<
-    Eigen::Vector3f>& vertices, std::vector<std::array<
-    unsigned int, 3>>& faces);
+// Frames of the viewer prepared one frame ahead on a worker thread: the
+// plan of the renderer for the camera of the previous frame, or the
+// deformed surfels while the model is animated.
+FramePipeline                   g_frames;
+bool                            g_frames_animated(false);
+SplatRenderer::FramePlan        g_frame_plans[FramePipeline::num_frames];
+std::vector<Surfel>             g_animation_frames[FramePipeline::num_frames];
 
-void mesh_to_surfel(std::vector<Eigen::Vector3f> const& vertices,
-    std::vector<std::array<unsigned int, 3>> const& faces,
-    std::vector<Surfel>& surfels);
+// Camera of the last frame of the viewer, read by the worker.
+std::mutex                      g_frame_camera_mutex;
+GLviz::Camera                   g_frame_camera;
 
-void
-load_plane(unsigned int n)
-{
-    const float d = 1.0f / static_cast<float>(2 * n);
+// Frames read back while capturing and written by its writer thread.
+std::unique_ptr<FrameCapture>   g_capture;
 
-    Surfel s(Vector3f::Zero(),
-             2.0f * d * Vector3f::UnitX(),
-             2.0f * d * Vector3f::UnitY(),
-             Vector3f::Zero(),
-             0);
+// Renderer identifiers of the surfels once the model is edited.
+std::vector<std::size_t>        g_surfel_ids;
 
-    g_surfels.resize(4 * n * n);
-    unsigned int m(0);
+// Per-frame telemetry, written to <prefix>.csv and <prefix>.json on close.
+std::string                     g_telemetry_prefix;
+std::unique_ptr<Telemetry>      g_telemetry;
 
-    for (unsigned int i(0); i <= 2 * n; ++i)
-    {
-        for (unsigned int j(0); j <= 2 * n; ++j)
-        {
-            unsigned int k(i * (2 * n + 1) + j);
+// Window size as of the last reshape.
+int g_window_width(0), g_window_height(0);
 
-            if (k % 2 == 1)
-            {
-                s.c = Vector3f(
-                    -1.0f + 2.0f * d * static_cast<float>(j),
-                    -1.0f + 2.0f * d * static_cast<float>(i),
-                    0.0f);
-                s.rgba = (((j / 2) % 2) == ((i / 2) % 2)) ? 0u : ~0u;
-                g_surfels[m] = s;
-
-                // Clip border surfels.
-                if (j == 2 * n)
-                {
-                    g_surfels[m].p = Vector3f(-1.0f, 0.0f, 0.0f);
-                    g_surfels[m].rgba = ~s.rgba;
-                }
-                else if (i == 2 * n)
-                {
-                    g_surfels[m].p = Vector3f(0.0f, -1.0f, 0.0f);
-                    g_surfels[m].rgba = ~s.rgba;
-                }
-                else if (j == 0)
-                {
-                    g_surfels[m].p = Vector3f(1.0f, 0.0f, 0.0f);
-                }
-                else if (i == 0)
-                {
-                    g_surfels[m].p = Vector3f(0.0f, 1.0f, 0.0f);
-                }
-                else
-                {
-                    // Duplicate and clip inner surfels.
-                    if (j % 2 == 0)
-                    {
-                        g_surfels[m].p = Vector3f(1.0, 0.0f, 0.0f);
+// Session recorded in the viewer and saved on close.
+std::string                     g_record_filename;
+Scenario                        g_record;
+std::chrono::steady_clock::time_point g_record_start;
 
-                        g_surfels[++m] = s;
-                        g_surfels[m].p = Vector3f(-1.0, 0.0f, 0.0f);
-                        g_surfels[m].rgba = ~s.rgba;
-                    }
+// Scenario replayed in the viewer, one frame per display.
+Scenario                        g_replay;
+std::size_t                     g_replay_frame(0), g_replay_frames(0);
+std::string                     g_replay_settings, g_report_filename;
+std::vector<FrameTiming>        g_replay_timings;
 
-                    if (i % 2 == 0)
-                    {
-                        g_surfels[m].p = Vector3f(0.0, 1.0f, 0.0f);
+// Prints the peak heap size during a stage and the current heap size.
+void
+print_memory(MemoryScope const& scope)
+{
+    std::cout << "  heap      " << std::fixed << std::setprecision(1)
+        << static_cast<double>(scope.peak_bytes()) / 1048576.0
+        << " MiB peak, " << static_cast<double>(
+            memory_stats().current_bytes) / 1048576.0 << " MiB current"
+        << std::endl;
+}
 
-                        g_surfels[++m] = s;
-                        g_surfels[m].p = Vector3f(0.0, -1.0f, 0.0f);
-                        g_surfels[m].rgba = ~s.rgba;
-                    }
-                }
+void
+load_dragon()
+{
+    std::vector<Eigen::Vector3f>              vertices;
+    std::vector<std::array<unsigned int, 3>>  faces;
 
-                ++m;
-            }
+    {
+        MemoryScope scope;
+
+        try
+        {
+            load_triangle_mesh("stanford_dragon_v344k_f688k.raw",
+                vertices, faces);
+        }
+        catch (std::runtime_error const& e)
+        {
+            std::cerr << e.what() << std::endl;
+            std::exit(EXIT_FAILURE);
         }
+
+        print_memory(scope);
     }
+
+    MemoryScope scope;
+    mesh_to_surfel(vertices, faces, g_surfels);
+
+    // Release the mesh before the surfels are processed further.
+    std::vector<Eigen::Vector3f>().swap(vertices);
+    std::vector<std::array<unsigned int, 3>>().swap(faces);
+
+    std::cout << "\nConvert to " << g_surfels.size() << " surfels."
+        << std::endl;
+    print_memory(scope);
 }
 
-void
-load_cube()
-{
-    Surfel cube[24];
-    unsigned int color = 0;
-
-    // Front.
-    cube[0].c  = Vector3f(-0.5f, 0.0f, 0.5f);
-    cube[0].u = 0.5f * Vector3f::UnitX();
-    cube[0].v = 0.5f * Vector3f::UnitY();
-    cube[0].p = Vector3f(1.0f, 0.0f, 0.0f);
-    cube[0].rgba  = color;
-
-    cube[1]   = cube[0];
-    cube[1].c = Vector3f(0.5f, 0.0f, 0.5f);
-    cube[1].p = Vector3f(-1.0f, 0.0f, 0.0f);
-    
-    cube[2]   = cube[0];
-    cube[2].c = Vector3f(0.0f, 0.5f, 0.5f);
-    cube[2].p = Vector3f(0.0f, -1.0f, 0.0f);
-    
-    cube[3]   = cube[0];
-    cube[3].c = Vector3f(0.0f, -0.5f, 0.5f);
-    cube[3].p = Vector3f(0.0f, 1.0f, 0.0f);
-
-    // Back.
-    cube[4].c = Vector3f(-0.5f, 0.0f, -0.5f);
-    cube[4].u = 0.5f * Vector3f::UnitX();
-    cube[4].v = -0.5f * Vector3f::UnitY();
-    cube[4].p = Vector3f(1.0f, 0.0f, 0.0f);
-    cube[4].rgba = color;
-
-    cube[5] = cube[4];
-    cube[5].c = Vector3f(0.5f, 0.0f, -0.5f);
-    cube[5].p = Vector3f(-1.0f, 0.0f, 0.0f);
-
-    cube[6] = cube[4];
-    cube[6].c = Vector3f(0.0f, 0.5f, -0.5f);
-    cube[6].p = Vector3f(0.0f, 1.0f, 0.0f);
-
-    cube[7] = cube[4];
-    cube[7].c = Vector3f(0.0f, -0.5f, -0.5f);
-    cube[7].p = Vector3f(0.0f, -1.0f, 0.0f);
-
-    // Top.
-    cube[8].c = Vector3f(-0.5f, 0.5f, 0.0f);
-    cube[8].u = 0.5f * Vector3f::UnitX();
-    cube[8].v = -0.5f * Vector3f::UnitZ();
-    cube[8].p = Vector3f(1.0f, 0.0f, 0.0f);
-    cube[8].rgba = color;
-
-    cube[9]    = cube[8];
-    cube[9].c  = Vector3f(0.5f, 0.5f, 0.0f);
-    cube[9].p = Vector3f(-1.0f, 0.0f, 0.0f);
-
-    cube[10]    = cube[8];
-    cube[10].c  = Vector3f(0.0f, 0.5f, 0.5f);
-    cube[10].p = Vector3f(0.0f, 1.0f, 0.0f);
-
-    cube[11] = cube[8];
-    cube[11].c = Vector3f(0.0f, 0.5f, -0.5f);
-    cube[11].p = Vector3f(0.0f, -1.0f, 0.0f);
-
-    // Bottom.
-    cube[12].c = Vector3f(-0.5f, -0.5f, 0.0f);
-    cube[12].u = 0.5f * Vector3f::UnitX();
-    cube[12].v = 0.5f * Vector3f::UnitZ();
-    cube[12].p = Vector3f(1.0f, 0.0f, 0.0f);
-    cube[12].rgba = color;
-
-    cube[13] = cube[12];
-    cube[13].c = Vector3f(0.5f, -0.5f, 0.0f);
-    cube[13].p = Vector3f(-1.0f, 0.0f, 0.0f);
-
-    cube[14] = cube[12];
-    cube[14].c = Vector3f(0.0f, -0.5f, 0.5f);
-    cube[14].p = Vector3f(0.0f, -1.0f, 0.0f);
-
-    cube[15] = cube[12];
-    cube[15].c = Vector3f(0.0f, -0.5f, -0.5f);
-    cube[15].p = Vector3f(0.0f, 1.0f, 0.0f);
-
-    // Left.
-    cube[16].c = Vector3f(-0.5f, -0.5f, 0.0f);
-    cube[16].u = 0.5f * Vector3f::UnitY();
-    cube[16].v = -0.5f * Vector3f::UnitZ();
-    cube[16].p = Vector3f(1.0f, 0.0f, 0.0f);
-    cube[16].rgba = color;
-
-    cube[17] = cube[16];
-    cube[17].c = Vector3f(-0.5f, 0.5f, 0.0f);
-    cube[17].p = Vector3f(-1.0f, 0.0f, 0.0f);
-
-    cube[18] = cube[16];
-    cube[18].c = Vector3f(-0.5f, 0.0f, 0.5f);
-    cube[18].p = Vector3f(0.0f, 1.0f, 0.0f);
-
-    cube[19] = cube[16];
-    cube[19].c = Vector3f(-0.5f, 0.0f, -0.5f);
-    cube[19].p = Vector3f(0.0f, -1.0f, 0.0f);
-
-    // Right.
-    cube[20].c = Vector3f(0.5f, -0.5f, 0.0f);
-    cube[20].u = 0.5f * Vector3f::UnitY();
-    cube[20].v = 0.5f * Vector3f::UnitZ();
-    cube[20].p = Vector3f(1.0f, 0.0f, 0.0f);
-    cube[20].rgba = color;
-
-    cube[21] = cube[20];
-    cube[21].c = Vector3f(0.5f, 0.5f, 0.0f);
-    cube[21].p = Vector3f(-1.0f, 0.0f, 0.0f);
-
-    cube[22] = cube[20];
-    cube[22].c = Vector3f(0.5f, 0.0f, 0.5f);
-    cube[22].p = Vector3f(0.0f, -1.0f, 0.0f);
-
-    cube[23] = cube[20];
-    cube[23].c = Vector3f(0.5f, 0.0f, -0.5f);
-    cube[23].p = Vector3f(0.0f, 1.0f, 0.0f);
-
-    g_surfels = std::vector<Surfel>(cube, cube + 24);
+bool
+has_extension(std::string const& filename, std::string const& extension)
+{
+    return filename.size() > extension.size() && filename.compare(
+        filename.size() - extension.size(), extension.size(),
+        extension) == 0;
 }
 
 void
-load_dragon()
+load_surfels(std::string const& filename)
 {
-    std::vector<Eigen::Vector3f>              vertices, normals;
-    std::vector<std::array<unsigned int, 3>>  faces;
-
     try
     {
-        load_triangle_mesh("stanford_dragon_v344k_f688k.raw",
-            vertices, faces);
+        std::cout << "\nRead " << filename << "." << std::endl;
+
+        MemoryScope scope;
+        auto begin = std::chrono::steady_clock::now();
+
+        SurfelFile file(filename);
+        file.decode(g_surfels);
+
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - begin;
+
+        std::cout << "  #surfels  " << file.size() << std::endl;
+        std::cout << "  #chunks   " << file.num_chunks() << std::endl;
+        std::cout << "  decoded in " << std::fixed << std::setprecision(2)
+            << elapsed.count() << " ms" << std::endl;
+        print_memory(scope);
     }
     catch (std::runtime_error const& e)
     {
         std::cerr << e.what() << std::endl;
         std::exit(EXIT_FAILURE);
     }
-
-    GLviz::set_vertex_normals_from_triangle_mesh(
-        vertices, faces, normals);
-
-    mesh_to_surfel(vertices, faces, g_surfels);
 }
 
 void
-load_model()
+load_mesh(std::string const& filename)
 {
-    switch (g_model)
+    std::vector<Eigen::Vector3f>              vertices, normals;
+    std::vector<std::array<unsigned int, 3>>  faces;
+    std::vector<unsigned int>                 colors;
+
+    MemoryScope read_scope;
+
+    try
     {
-        case 1:
-            load_plane(200);
-            break;
-        case 2:
-            load_cube();
-            break;
-        default:
-            load_dragon();
+        if (has_extension(filename, ".ply"))
+        {
+            std::cout << "\nRead " << filename << "." << std::endl;
+            load_ply(filename, vertices, faces, normals, colors);
+
+            std::cout << "  #vertices " << vertices.size() << std::endl;
+            std::cout << "  #faces    " << faces.size() << std::endl;
+        }
+        else
+        {
+            load_triangle_mesh(filename, vertices, faces);
+        }
+    }
+    catch (std::runtime_error const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::exit(EXIT_FAILURE);
     }
-}
 
-void
-load_triangle_mesh(std::string const& filename, std::vector<
-    Eigen::Vector3f>& vertices, std::vector<std::array<
-    unsigned int, 3>>& faces)
-{
-    std::cout << "\nRead " << filename << "." << std::endl;
-    std::ifstream input(filename);
+    print_memory(read_scope);
 
-    if (input.good())
+    MemoryScope scope;
+
+    if (faces.empty())
     {
-        input.close();
-        GLviz::load_raw(filename, vertices, faces);
+        point_cloud_to_surfel(vertices, normals, colors, g_surfels);
     }
     else
     {
-        input.close();
+        // Normals only orient the surfels of point clouds.
+        std::vector<Eigen::Vector3f>().swap(normals);
 
-        std::ostringstream fqfn;
-        fqfn << path_resources;
-        fqfn << filename;
-        GLviz::load_raw(fqfn.str(), vertices, faces);
+        mesh_to_surfel(vertices, colors, faces, g_surfels);
     }
 
-    std::cout << "  #vertices " << vertices.size() << std::endl;
-    std::cout << "  #faces    " << faces.size() << std::endl;
+    std::vector<Eigen::Vector3f>().swap(vertices);
+    std::vector<Eigen::Vector3f>().swap(normals);
+    std::vector<std::array<unsigned int, 3>>().swap(faces);
+    std::vector<unsigned int>().swap(colors);
+
+    std::cout << "\nConvert to " << g_surfels.size() << " surfels."
+        << std::endl;
+    print_memory(scope);
 }
 
+// Decimates the model with a geometric error bound relative to its
+// bounding box diagonal.
 void
-steiner_circumellipse(float const* v0_ptr, float const* v1_ptr,
-    float const* v2_ptr, float* p0_ptr, float* t1_ptr, float* t2_ptr)
+decimate_model()
 {
-    Matrix2f Q;
-    Vector3f d0, d1, d2;
+    Vector3f p_min = Vector3f::Constant(std::numeric_limits<float>::max());
+    Vector3f p_max = -p_min;
+
+    for (auto const& surfel : g_surfels)
     {
-        using Vec = Map<const Vector3f>;
-        Vec v[] = { Vec(v0_ptr), Vec(v1_ptr), Vec(v2_ptr) };
+        p_min = p_min.cwiseMin(surfel.c);
+        p_max = p_max.cwiseMax(surfel.c);
+    }
 
-        d0 = v[1] - v[0];
-        d0.normalize();
+    float max_distance = g_decimation * (p_max - p_min).norm();
+    float max_angle = 10.0f * 3.14159265f / 180.0f;
 
-        d1 = v[2] - v[0];
-        d1 = d1 - d0 * d0.dot(d1);
-        d1.normalize();
+    MemoryScope scope;
+    auto begin = std::chrono::steady_clock::now();
 
-        d2 = (1.0f / 3.0f) * (v[0] + v[1] + v[2]);
+    std::vector<Surfel> decimated;
+    decimate(g_surfels, decimated, max_distance, max_angle);
 
-        Vector2f p[3];
-        for (unsigned int j(0); j < 3; ++j)
-        {
-            p[j] = Vector2f(
-                d0.dot(v[j] - d2),
-                d1.dot(v[j] - d2)
-            );
-        }
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - begin;
 
-        Matrix3f A;
-        for (unsigned int j(0); j < 3; ++j)
-        {
-            A.row(j) = Vector3f(
-                p[j].x() * p[j].x(),
-                2.0f * p[j].x() * p[j].y(),
-                p[j].y() * p[j].y()
-            );
-        }
+    std::cout << "\nDecimate " << g_surfels.size() << " to "
+        << decimated.size() << " surfels (" << std::fixed
+        << std::setprecision(2) << static_cast<double>(g_surfels.size())
+            / static_cast<double>(std::max<std::size_t>(decimated.size(), 1))
+        << "x reduction) in " << elapsed.count() << " ms." << std::endl;
 
-        FullPivLU<Matrix3f> lu(A);
-        Vector3f res = lu.solve(Vector3f::Ones());
+    g_surfels.swap(decimated);
+    std::vector<Surfel>().swap(decimated);
 
-        Q(0, 0) = res(0);
-        Q(1, 1) = res(2);
-        Q(0, 1) = Q(1, 0) = res(1);
-    }
+    print_memory(scope);
+}
 
-    Map<Vector3f> p0(p0_ptr), t1(t1_ptr), t2(t2_ptr);
-    {
-        SelfAdjointEigenSolver<Matrix2f> es;
-        es.compute(Q);
+// Sorts the surfels along a Morton curve for memory and raster locality.
+void
+reorder_model()
+{
+    MemoryScope scope;
+    auto begin = std::chrono::steady_clock::now();
 
-        Vector2f const& l = es.eigenvalues();
-        Vector2f const& e0 = es.eigenvectors().col(0);
-        Vector2f const& e1 = es.eigenvectors().col(1);
+    morton_sort(g_surfels, g_reorder == 2);
 
-        p0 = d2;
-        t1 = (1.0f / std::sqrt(l.x())) * (d0 * e0.x() + d1 * e0.y());
-        t2 = (1.0f / std::sqrt(l.y())) * (d0 * e1.x() + d1 * e1.y());
-    }
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - begin;
+
+    std::cout << "\nReorder " << g_surfels.size() << " surfels in "
+        << std::fixed << std::setprecision(2) << elapsed.count() << " ms."
+        << std::endl;
+    print_memory(scope);
 }
 
+// Generates one of the procedural stress scenes of g_scene_size surfels.
 void
-hsv2rgb(float h, float s, float v, float& r, float& g, float& b)
+generate_scene()
 {
-    float h_i = std::floor(h / 60.0f);
-    float f = h / 60.0f - h_i;
+    std::vector<Surfel> model;
+    if (g_model == 5)
+    {
+        load_dragon();
+        model.swap(g_surfels);
+    }
 
-    float p = v * (1.0f - s);
-    float q = v * (1.0f - s * f);
-    float t = v * (1.0f - s * (1.0f - f));
+    MemoryScope scope;
+    auto begin = std::chrono::steady_clock::now();
 
-    switch (static_cast<int>(h_i))
+    switch (g_model)
     {
-        case 1:
-            r = q; g = v; b = p;
-            break;
-        case 2:
-            r = p; g = v; b = t;
-            break;
         case 3:
-            r = p; g = q; b = v;
+            generate_checkerboards(g_scene_size, g_surfels);
             break;
         case 4:
-            r = t; g = p; b = v;
-            break;
-        case 5:
-            r = v; g = p; b = q;
+            generate_terrain(g_scene_size, g_surfels);
             break;
         default:
-            r = v; g = t; b = p;
+            generate_replicas(model, g_scene_size, g_surfels);
     }
+
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - begin;
+
+    std::cout << "\nGenerate " << g_surfels.size() << " surfels in "
+        << std::fixed << std::setprecision(2) << elapsed.count() << " ms."
+        << std::endl;
+    print_memory(scope);
 }
 
 void
-face_to_surfel(std::vector<Eigen::Vector3f> const& vertices,
-    std::array<unsigned int, 3> const& face, Surfel& surfel)
+load_model(bool simplify = true)
 {
-    Vector3f v[3] = {
-        vertices[face[0]],
-        vertices[face[1]],
-        vertices[face[2]]
-    };
+    // The storage of the previous model is reused for the next one without
+    // copying its contents.
+    g_frames.stop();
+    g_surfels.clear();
+    g_surfel_ids.clear();
 
-    Vector3f p0, t1, t2;
-    steiner_circumellipse(
-        v[0].data(), v[1].data(), v[2].data(),
-        p0.data(), t1.data(), t2.data()
-    );
+    try
+    {
+        switch (g_model)
+        {
+            case 6:
+                if (has_extension(g_model_filename, ".srf"))
+                {
+                    load_surfels(g_model_filename);
+                }
+                else
+                {
+                    load_mesh(g_model_filename);
+                }
+                break;
+            case 3:
+            case 4:
+            case 5:
+                generate_scene();
+                break;
+            case 1:
+                load_plane(200, g_surfels);
+                break;
+            case 2:
+                load_cube(g_surfels);
+                break;
+            default:
+                load_dragon();
+        }
 
-    Vector3f n_s = t1.cross(t2);
-    Vector3f n_t = (v[1] - v[0]).cross(v[2] - v[0]);
+        if (simplify && g_decimation > 0.0f)
+        {
+            decimate_model();
+        }
 
-    if (n_t.dot(n_s) < 0.0f)
+        if (simplify && g_reorder > 0)
+        {
+            reorder_model();
+        }
+    }
+    catch (std::bad_alloc const&)
     {
-        t1.swap(t2);
+        std::cerr << "Error: Out of memory while loading the model";
+        if (memory_limit() > 0)
+        {
+            std::cerr << " with a heap limit of " << memory_limit() / 1048576
+                << " MiB";
+        }
+        std::cerr << "." << std::endl;
+        std::exit(EXIT_FAILURE);
     }
 
-    surfel.c = p0;
-    surfel.u = t1;
-    surfel.v = t2;
-    surfel.p = Vector3f::Zero();
+    if (g_surfels.capacity() > 2 * g_surfels.size())
+    {
+        g_surfels.shrink_to_fit();
+    }
 
-    float h = std::min((std::abs(p0.x()) / 0.45f) * 360.0f, 360.0f);
-    float r, g, b;
-    hsv2rgb(h, 1.0f, 1.0f, r, g, b);
-    surfel.rgba = static_cast<unsigned int>(r * 255.0f)
-        | (static_cast<unsigned int>(g * 255.0f) << 8)
-        | (static_cast<unsigned int>(b * 255.0f) << 16);
+    if (viz)
+    {
+        viz->set_geometry(g_surfels);
+    }
 }
 
+// Deforms the model by a ripple along the surfel normals into a slot of
+// the animation frames, while g_surfels is left unchanged.
 void
-mesh_to_surfel(std::vector<Eigen::Vector3f> const& vertices,
-    std::vector<std::array<unsigned int, 3>> const& faces,
-    std::vector<Surfel>& surfels)
+deform_model(unsigned int slot)
 {
-    surfels.resize(faces.size());
+    static auto const start = std::chrono::steady_clock::now();
+    std::chrono::duration<float> time = std::chrono::steady_clock::now()
+        - start;
 
-    std::vector<std::thread> threads(std::thread::hardware_concurrency());
+    std::vector<Surfel>& frame = g_animation_frames[slot];
+    if (frame.size() != g_surfels.size())
+    {
+        frame = g_surfels;
+    }
 
-    for (std::size_t i(0); i < threads.size(); ++i)
+    for (std::size_t i(0); i < g_surfels.size(); ++i)
     {
-        std::size_t b = i * faces.size() / threads.size();
-        std::size_t e = (i + 1) * faces.size() / threads.size();
+        Surfel const& rest = g_surfels[i];
+        Vector3f n = rest.u.cross(rest.v).normalized();
 
-        threads[i] = std::thread([b, e, &vertices, &faces, &surfels]() {
-            for (std::size_t j = b; j < e; ++j)
-            {
-                face_to_surfel(vertices, faces[j], surfels[j]);
-            }
-        });
+        frame[i].c = rest.c + 0.01f * std::sin(40.0f * rest.c.y()
+            - 4.0f * time.count()) * n;
     }
-
-    for (auto& t : threads) { t.join(); }
 }
 
+// Streams a deformed frame to the renderer.
 void
-display()
+animate_model(unsigned int slot)
 {
-    viz->render_frame(g_surfels);
+    try
+    {
+        viz->update_geometry(g_animation_frames[slot]);
+    }
+    catch (std::invalid_argument const& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        g_animate = false;
+    }
 }
 
+// Prepares a frame of the viewer on the worker thread of g_frames. The
+// bounds of an animated model change with each streamed frame, hence only
+// its deformation is prepared ahead and the renderer plans the frame.
 void
-reshape(int width, int height)
+prepare_frame(unsigned int slot, bool animated)
 {
-    const float aspect = static_cast<float>(width) /
-        static_cast<float>(height);
+    if (animated)
+    {
+        deform_model(slot);
+        return;
+    }
 
-    glViewport(0, 0, width, height);
-    g_camera.set_perspective(60.0f, aspect, 0.005f, 5.0f);
-}
+    GLviz::Camera camera;
+    {
+        std::lock_guard<std::mutex> lock(g_frame_camera_mutex);
+        camera = g_frame_camera;
+    }
 
-void
-close()
-{
-    viz = nullptr;
+    viz->plan_frame(camera, g_frame_plans[slot]);
 }
 
+// Removes, recolors or inserts a random tenth of the surfels.
 void
-gui()
+edit_model(int operation)
 {
-    ImGui::Begin("Surface Splatting", nullptr);
-    ImGui::SetWindowPos(ImVec2(3.0f, 3.0f), ImGuiCond_Once);
-    ImGui::SetWindowSize(ImVec2(350.0f, 415.0f), ImGuiCond_Once);
-
-    ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x * 0.55f);
+    static std::mt19937 generator;
+    std::bernoulli_distribution select(0.1);
 
-    ImGui::Text("fps \t %.1f fps", ImGui::GetIO().Framerate);
-
-    ImGui::SetNextItemOpen(true, ImGuiCond_Once);
-    if (ImGui::CollapsingHeader("Scene"))
+    // The animation worker reads the surfels.
+    if (g_frames.running() && g_frames_animated)
     {
-        if (ImGui::Combo("Models", &g_model, "Dragon\0Plane\0Cube\0"))
-        {
-            load_model();
-        }
+        std::cerr << "Error: Animated geometry cannot be edited."
+            << std::endl;
+        return;
     }
 
-    ImGui::SetNextItemOpen(true, ImGuiCond_Once);
-    if (ImGui::CollapsingHeader("Surface Splatting"))
+    if (g_surfel_ids.empty())
     {
-        int shading_method = viz->smooth() ? 1 : 0;
-        if (ImGui::Combo("Shading", &shading_method, "Flat\0Smooth\0"))
+        g_surfel_ids.resize(g_surfels.size());
+        for (std::size_t i(0); i < g_surfels.size(); ++i)
         {
-            viz->set_smooth(shading_method > 0 ? true : false);
+            g_surfel_ids[i] = i;
         }
+    }
 
-        ImGui::Separator();
+    std::vector<std::size_t> ids;
+    std::vector<Surfel> surfels;
 
-        int color_material = viz->color_material() ? 1 : 0;
-        if (ImGui::Combo("Color", &color_material, "Surfel\0Material\0"))
+    try
+    {
+        switch (operation)
         {
-            viz->set_color_material(color_material > 0 ? true : false);
-        }
+            case 0:
+            {
+                std::vector<char> removed(g_surfels.size(), 0);
+                for (std::size_t i(0); i < g_surfels.size(); ++i)
+                {
+                    if (select(generator))
+                    {
+                        removed[i] = 1;
+                        ids.push_back(g_surfel_ids[i]);
+                    }
+                }
 
-        float material_color[3];
-        std::copy(viz->material_color(), viz->material_color() + 3,
-            material_color);
-        if (ImGui::ColorEdit3("Material color", material_color))
-        {
-            viz->set_material_color(material_color);
-        }
+                viz->remove_surfels(ids);
 
-        float material_shininess = viz->material_shininess();
-        if (ImGui::DragFloat("Material shininess",
-            &material_shininess, 0.05f, 1e-12f, 1000.0f))
-        {
-            viz->set_material_shininess(std::min(std::max(
-                1e-12f, material_shininess), 1000.0f));
-        }
+                std::size_t j(0);
+                for (std::size_t i(0); i < g_surfels.size(); ++i)
+                {
+                    if (!removed[i])
+                    {
+                        g_surfels[j] = g_surfels[i];
+                        g_surfel_ids[j++] = g_surfel_ids[i];
+                    }
+                }
 
-        ImGui::Separator();
+                g_surfels.resize(j);
+                g_surfel_ids.resize(j);
+                break;
+            }
+            case 1:
+            {
+                unsigned int rgba = generator() | 0xff000000;
+                std::vector<std::size_t> recolored;
+                for (std::size_t i(0); i < g_surfels.size(); ++i)
+                {
+                    if (select(generator))
+                    {
+                        recolored.push_back(i);
+                        ids.push_back(g_surfel_ids[i]);
+                        surfels.push_back(g_surfels[i]);
+                        surfels.back().rgba = rgba;
+                    }
+                }
 
-        bool soft_zbuffer = viz->soft_zbuffer();
-        if (ImGui::Checkbox("Soft z-buffer", &soft_zbuffer))
-        {
-            viz->set_soft_zbuffer(soft_zbuffer);
-        }
+                viz->replace_surfels(ids, surfels);
 
-        float soft_zbuffer_epsilon = viz->soft_zbuffer_epsilon();
-        if (ImGui::DragFloat("Soft z-buffer epsilon",
-            &soft_zbuffer_epsilon, 1e-5f, 1e-5f, 1.0f, "%.5f"))
-        {
-            viz->set_soft_zbuffer_epsilon(std::min(std::max(
-                1e-5f, soft_zbuffer_epsilon), 1.0f));
-        }
+                for (std::size_t i : recolored)
+                {
+                    g_surfels[i].rgba = rgba;
+                }
+                break;
+            }
+            case 2:
+            {
+                // Copies are shifted along the normal to stand out.
+                for (Surfel const& surfel : g_surfels)
+                {
+                    if (select(generator))
+                    {
+                        Vector3f n = surfel.u.cross(surfel.v).normalized();
+                        surfels.push_back(surfel);
+                        surfels.back().c += 0.01f * n;
+                    }
+                }
 
-        ImGui::Separator();
+                ids = viz->insert_surfels(surfels);
 
-        bool ewa_filter = viz->ewa_filter();
-        if (ImGui::Checkbox("EWA filter", &ewa_filter))
-        {
-            viz->set_ewa_filter(ewa_filter);
+                g_surfels.insert(g_surfels.end(), surfels.begin(),
+                    surfels.end());
+                g_surfel_ids.insert(g_surfel_ids.end(), ids.begin(),
+                    ids.end());
+                break;
+            }
         }
+    }
+    catch (std::invalid_argument const& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+}
 
-        float ewa_radius = viz->ewa_radius();
-        if (ImGui::DragFloat("EWA radius",
-            &ewa_radius, 1e-3f, 0.1f, 4.0f))
-        {
-            viz->set_ewa_radius(ewa_radius);
-        }
+// Renders a frame from the given plan, or planned for the current camera.
+void
+render_display(SplatRenderer::FramePlan const* plan)
+{
+    if (g_telemetry)
+    {
+        g_telemetry->begin_frame();
+    }
 
-        ImGui::Separator();
+    if (plan)
+    {
+        viz->render_frame(*plan);
+    }
+    else
+    {
+        viz->render_frame();
+    }
 
-        int point_size = viz->pointsize_method();
-        if (ImGui::Combo("Point size", &point_size,
-            "PBP\0BHZK05\0WHA+07\0ZRB+04\0"))
-        {
-            viz->set_pointsize_method(point_size);
-        }
+    if (g_telemetry)
+    {
+        g_telemetry->end_frame(*viz);
+    }
+
+    if (g_capture)
+    {
+        viz->capture_frame(*g_capture);
+    }
+}
+
+// Renders a frame for the current camera, e.g. of a batch or a replay.
+void
+display()
+{
+    g_frames.stop();
+
+    if (g_animate)
+    {
+        deform_model(0);
+        animate_model(0);
+    }
+
+    render_display(nullptr);
+}
+
+// Renders the frame of the viewer prepared while the previous frame was
+// rendered, and prepares the next frame for the current camera meanwhile.
+void
+display_prepared()
+{
+    {
+        std::lock_guard<std::mutex> lock(g_frame_camera_mutex);
+        g_frame_camera = g_camera;
+    }
+
+    if (!g_frames.running() || g_frames_animated != g_animate)
+    {
+        bool animated = g_animate;
+        g_frames.start([animated](unsigned int slot) {
+            prepare_frame(slot, animated);
+        }, 1);
+
+        g_frames_animated = animated;
+    }
+
+    unsigned int slot = g_frames.acquire();
+
+    if (g_frames_animated)
+    {
+        animate_model(slot);
+        render_display(nullptr);
+    }
+    else
+    {
+        render_display(&g_frame_plans[slot]);
+    }
+
+    g_frames.release();
+}
+
+// Starts writing each frame to capture_<index>.png on a writer thread.
+void
+start_capture()
+{
+    g_capture = std::unique_ptr<FrameCapture>(new FrameCapture());
+    g_capture->set_consumer([](FrameCapture::Frame& frame) {
+        std::ostringstream filename;
+        filename << "capture_" << std::setw(5) << std::setfill('0')
+            << frame.index << ".png";
+
+        try
+        {
+            write_png(filename.str(), frame.width, frame.height,
+                frame.rgba);
+        }
+        catch (std::runtime_error const& e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+    }, true);
+}
+
+void
+set_viewport(int width, int height)
+{
+    const float aspect = static_cast<float>(width) /
+        static_cast<float>(height);
+
+    glViewport(0, 0, width, height);
+    g_camera.set_perspective(60.0f, aspect, 0.005f, 5.0f);
+}
+
+void
+reshape(int width, int height)
+{
+    g_window_width = width;
+    g_window_height = height;
+
+    set_viewport(width, height);
+}
+
+// Prints the frame time percentiles of the telemetry and writes it.
+void
+write_telemetry()
+{
+    if (g_telemetry->frames().empty())
+    {
+        return;
+    }
+
+    if (viz)
+    {
+        g_telemetry->finish(*viz);
+    }
+
+    std::cout << "Frame time " << std::fixed << std::setprecision(2)
+        << g_telemetry->percentile(0.5) << " ms p50, "
+        << g_telemetry->percentile(0.95) << " ms p95, "
+        << g_telemetry->percentile(0.99) << " ms p99 of "
+        << g_telemetry->frames().size() << " frames." << std::endl;
+
+    try
+    {
+        g_telemetry->write_csv(g_telemetry_prefix + ".csv");
+        g_telemetry->write_trace(g_telemetry_prefix + ".json");
+
+        std::cout << "Write telemetry to " << g_telemetry_prefix
+            << ".csv and " << g_telemetry_prefix << ".json." << std::endl;
+    }
+    catch (std::runtime_error const& e)
+    {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+void
+close()
+{
+    if (g_telemetry)
+    {
+        write_telemetry();
+        g_telemetry = nullptr;
+    }
+
+    g_frames.stop();
+    g_capture = nullptr;
+    viz = nullptr;
+}
+
+void
+gui()
+{
+    ImGui::Begin("Surface Splatting", nullptr);
+    ImGui::SetWindowPos(ImVec2(3.0f, 3.0f), ImGuiCond_Once);
+    ImGui::SetWindowSize(ImVec2(350.0f, 415.0f), ImGuiCond_Once);
+
+    ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x * 0.55f);
+
+    ImGui::Text("fps \t %.1f fps", ImGui::GetIO().Framerate);
+
+    bool capture = g_capture != nullptr;
+    if (ImGui::Checkbox("Capture frames", &capture))
+    {
+        if (capture)
+        {
+            start_capture();
+        }
+        else
+        {
+            g_capture = nullptr;
+        }
+    }
+
+    if (g_capture)
+    {
+        ImGui::Text("Captured \t %zu frames, %zu stalls",
+            g_capture->captured_frames(), g_capture->stalls());
+        ImGui::Text("Writer stalls \t %zu", g_capture->writer_stalls());
+    }
+
+    if (g_telemetry && !g_telemetry->frames().empty())
+    {
+        Telemetry::Frame const& frame = g_telemetry->frames().back();
+        Telemetry::Frame const* timed = g_telemetry->last_timed_frame();
+
+        ImGui::Text("Frame \t %.1f ms CPU, %.1f ms GPU", frame.cpu_ms,
+            timed ? timed->gpu_ms[0] + timed->gpu_ms[1] + timed->gpu_ms[2]
+            : 0.0f);
+    }
+
+    if (!g_record_filename.empty())
+    {
+        ImGui::Text("Recorded \t %zu events", g_record.num_events());
+    }
+
+    if (g_replay_frame < g_replay_frames)
+    {
+        ImGui::Text("Replay \t frame %zu of %zu", g_replay_frame,
+            g_replay_frames);
+    }
+
+    ImGui::SetNextItemOpen(true, ImGuiCond_Once);
+    if (ImGui::CollapsingHeader("Scene"))
+    {
+        if (ImGui::Combo("Models", &g_model, g_model_filename.empty()
+            ? "Dragon\0Plane\0Cube\0Checkerboards\0Terrain\0Replicas\0"
+            : "Dragon\0Plane\0Cube\0Checkerboards\0Terrain\0Replicas\0"
+              "File\0"))
+        {
+            load_model();
+        }
+
+        SplatRenderer::PagingStatistics const& paging =
+            viz->paging_statistics();
+
+        if (viz->memory_budget() > 0)
+        {
+            ImGui::Text("Pages \t %zu resident, %zu drawn of %zu",
+                paging.resident_pages, paging.drawn_pages, paging.num_pages);
+            ImGui::Text("Uploads \t %zu pages, %.1f MiB", paging.uploaded_pages,
+                static_cast<double>(paging.uploaded_bytes) / 1048576.0);
+        }
+
+        if (paging.num_buffers > 1)
+        {
+            ImGui::Text("Buffers \t %zu", paging.num_buffers);
+        }
+
+        if (ImGui::Checkbox("Animate", &g_animate) && !g_animate
+            && g_frames_animated)
+        {
+            g_frames.stop();
+            viz->update_geometry(g_surfels);
+        }
+
+        if (g_animate)
+        {
+            ImGui::Text("Stream stalls \t %zu", viz->stream_stalls());
+        }
+
+        FramePipeline::Statistics frames = g_frames.statistics();
+
+        ImGui::Text("Frame latency \t %.1f ms, %zu queued",
+            frames.latency_ms, frames.queue_depth);
+        ImGui::Text("Frame waits \t %zu of %zu", frames.waits,
+            frames.consumed_frames);
+
+        if (ImGui::Button("Remove"))
+        {
+            edit_model(0);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Recolor"))
+        {
+            edit_model(1);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Insert"))
+        {
+            edit_model(2);
+        }
+
+        SplatRenderer::EditingStatistics editing =
+            viz->editing_statistics();
+
+        if (editing.free_slots > 0 || editing.moved_surfels > 0)
+        {
+            ImGui::Text("Slots \t %zu used, %zu free of %zu",
+                editing.used_slots, editing.free_slots, editing.capacity);
+            ImGui::Text("Compaction \t %zu surfels moved",
+                editing.moved_surfels);
+        }
+
+        bool occlusion_culling = viz->occlusion_culling();
+        if (ImGui::Checkbox("Occlusion culling", &occlusion_culling))
+        {
+            viz->set_occlusion_culling(occlusion_culling);
+        }
+
+        if (occlusion_culling)
+        {
+            SplatRenderer::CullingStatistics const& culling =
+                viz->culling_statistics();
+
+            ImGui::Text("Occluded \t %zu of %zu clusters",
+                culling.occluded_clusters, culling.tested_clusters);
+        }
+    }
+
+    ImGui::SetNextItemOpen(true, ImGuiCond_Once);
+    if (ImGui::CollapsingHeader("Surface Splatting"))
+    {
+        int shading_method = viz->smooth() ? 1 : 0;
+        if (ImGui::Combo("Shading", &shading_method, "Flat\0Smooth\0"))
+        {
+            viz->set_smooth(shading_method > 0 ? true : false);
+        }
+
+        ImGui::Separator();
+
+        int color_material = viz->color_material() ? 1 : 0;
+        if (ImGui::Combo("Color", &color_material, "Surfel\0Material\0"))
+        {
+            viz->set_color_material(color_material > 0 ? true : false);
+        }
+
+        float material_color[3];
+        std::copy(viz->material_color(), viz->material_color() + 3,
+            material_color);
+        if (ImGui::ColorEdit3("Material color", material_color))
+        {
+            viz->set_material_color(material_color);
+        }
+
+        float material_shininess = viz->material_shininess();
+        if (ImGui::DragFloat("Material shininess",
+            &material_shininess, 0.05f, 1e-12f, 1000.0f))
+        {
+            viz->set_material_shininess(std::min(std::max(
+                1e-12f, material_shininess), 1000.0f));
+        }
+
+        ImGui::Separator();
+
+        bool soft_zbuffer = viz->soft_zbuffer();
+        if (ImGui::Checkbox("Soft z-buffer", &soft_zbuffer))
+        {
+            viz->set_soft_zbuffer(soft_zbuffer);
+        }
+
+        float soft_zbuffer_epsilon = viz->soft_zbuffer_epsilon();
+        if (ImGui::DragFloat("Soft z-buffer epsilon",
+            &soft_zbuffer_epsilon, 1e-5f, 1e-5f, 1.0f, "%.5f"))
+        {
+            viz->set_soft_zbuffer_epsilon(std::min(std::max(
+                1e-5f, soft_zbuffer_epsilon), 1.0f));
+        }
+
+        ImGui::Separator();
+
+        bool ewa_filter = viz->ewa_filter();
+        if (ImGui::Checkbox("EWA filter", &ewa_filter))
+        {
+            viz->set_ewa_filter(ewa_filter);
+        }
+
+        float ewa_radius = viz->ewa_radius();
+        if (ImGui::DragFloat("EWA radius",
+            &ewa_radius, 1e-3f, 0.1f, 4.0f))
+        {
+            viz->set_ewa_radius(ewa_radius);
+        }
+
+        ImGui::Separator();
+
+        int point_size = viz->pointsize_method();
+        if (ImGui::Combo("Point size", &point_size,
+            "PBP\0BHZK05\0WHA+07\0ZRB+04\0"))
+        {
+            viz->set_pointsize_method(point_size);
+        }
 
         float radius_scale = viz->radius_scale();
         if (ImGui::DragFloat("Radius scale",
@@ -602,6 +979,20 @@ gui()
                 1e-6f, radius_scale), 2.0f));
         }
 
+        float subpixel_size = viz->subpixel_size();
+        if (ImGui::DragFloat("Sub-pixel size",
+            &subpixel_size, 0.01f, 0.0f, 2.0f))
+        {
+            viz->set_subpixel_size(std::min(std::max(
+                0.0f, subpixel_size), 2.0f));
+        }
+
+        int hole_filling = viz->hole_filling();
+        if (ImGui::SliderInt("Hole filling", &hole_filling, 0, 4))
+        {
+            viz->set_hole_filling(hole_filling);
+        }
+
         ImGui::Separator();
 
         bool multisample_4x = viz->multisample();
@@ -643,23 +1034,1434 @@ keyboard(SDL_Keycode key)
     }
 }
 
-}
+struct BatchOptions
+{
+    BatchOptions()
+        : output_prefix("frame"), views("mono"), renderer("gl"),
+          replay_mode("window"), report_filename("replay.csv"),
+          width(960), height(540), tile_size(0), threads(0), jobs(1),
+          frames(0), eye_separation(0.06f),
+          tolerance(1e-3f), time_tolerance(0.25f)
+    {
+    }
 
-int
-main(int argc, char* argv[])
+    std::string poses_filename, output_prefix, views, renderer, settings;
+    std::string reference_prefix, baseline_filename, save_baseline_filename;
+    std::string scenario_filename, replay_mode, report_filename;
+    int width, height, tile_size;
+    unsigned int threads, jobs;
+    std::size_t frames;
+    float eye_separation, tolerance, time_tolerance;
+};
+
+struct RenderSettings
 {
-    GLviz::GLviz();
+    RenderSettings()
+        : smooth(false), color_material(true), soft_zbuffer(true),
+          ewa_filter(false), backface_culling(false), multisample(false),
+          occlusion_culling(false), pointsize_method(0), hole_filling(0),
+          subpixel_size(0.0f)
+    {
+    }
 
-    g_camera.translate(Eigen::Vector3f(0.0f, 0.0f, -2.0f));
-    viz = std::unique_ptr<SplatRenderer>(new SplatRenderer(g_camera));
+    bool smooth, color_material, soft_zbuffer, ewa_filter,
+        backface_culling, multisample, occlusion_culling;
+    unsigned int pointsize_method, hole_filling;
+    float subpixel_size;
+};
 
-    load_model();
+// Parses a comma-separated list of renderer settings, e.g.
+// "smooth,ewa,pointsize=2,fill=3".
+bool
+parse_settings(std::string const& list, RenderSettings& settings)
+{
+    std::istringstream input(list);
+    std::string token;
 
-    GLviz::display_callback(display);
-    GLviz::reshape_callback(reshape);
-    GLviz::close_callback(close);
-    GLviz::gui_callback(gui);
-    GLviz::keyboard_callback(keyboard);
+    while (std::getline(input, token, ','))
+    {
+        if (token == "smooth")                settings.smooth = true;
+        else if (token == "surfel-color")     settings.color_material = false;
+        else if (token == "hard-zbuffer")     settings.soft_zbuffer = false;
+        else if (token == "ewa")              settings.ewa_filter = true;
+        else if (token == "backface-culling") settings.backface_culling = true;
+        else if (token == "multisample")      settings.multisample = true;
+        else if (token == "occlusion")        settings.occlusion_culling = true;
+        else if (token.size() == 11 && token.compare(0, 10, "pointsize=") == 0
+            && token[10] >= '0' && token[10] <= '3')
+        {
+            settings.pointsize_method = static_cast<unsigned int>(
+                token[10] - '0');
+        }
+        else if (token.size() == 6 && token.compare(0, 5, "fill=") == 0
+            && token[5] >= '0' && token[5] <= '4')
+        {
+            settings.hole_filling = static_cast<unsigned int>(
+                token[5] - '0');
+        }
+        else if (token.compare(0, 9, "subpixel=") == 0)
+        {
+            std::istringstream value(token.substr(9));
+            if (!(value >> settings.subpixel_size) || !value.eof()
+                || settings.subpixel_size < 0.0f)
+            {
+                return false;
+            }
+        }
+        else if (!token.empty())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template <typename Renderer>
+void
+apply_settings(RenderSettings const& settings, Renderer& renderer)
+{
+    renderer.set_smooth(settings.smooth);
+    renderer.set_color_material(settings.color_material);
+    renderer.set_soft_zbuffer(settings.soft_zbuffer);
+    renderer.set_ewa_filter(settings.ewa_filter);
+    renderer.set_backface_culling(settings.backface_culling);
+}
+
+// Applies the settings specific to the OpenGL renderer as well.
+void
+apply_gl_settings(RenderSettings const& settings, SplatRenderer& renderer)
+{
+    apply_settings(settings, renderer);
+
+    renderer.set_multisample(settings.multisample);
+    renderer.set_pointsize_method(settings.pointsize_method);
+    renderer.set_hole_filling(settings.hole_filling);
+    renderer.set_subpixel_size(settings.subpixel_size);
+    renderer.set_occlusion_culling(settings.occlusion_culling);
+    renderer.set_memory_budget(g_gpu_budget);
+
+    if (g_gpu_buffer_size > 0)
+    {
+        renderer.set_max_buffer_size(g_gpu_buffer_size);
+    }
+}
+
+// Returns the settings of the OpenGL renderer as a list read by
+// parse_settings().
+std::string
+settings_list(SplatRenderer const& renderer)
+{
+    std::ostringstream list;
+
+    if (renderer.smooth())              list << "smooth,";
+    if (!renderer.color_material())     list << "surfel-color,";
+    if (!renderer.soft_zbuffer())       list << "hard-zbuffer,";
+    if (renderer.ewa_filter())          list << "ewa,";
+    if (renderer.backface_culling())    list << "backface-culling,";
+    if (renderer.multisample())         list << "multisample,";
+    if (renderer.occlusion_culling())   list << "occlusion,";
+
+    list << "pointsize=" << renderer.pointsize_method() << ",fill="
+        << renderer.hole_filling() << ",subpixel=" << std::setprecision(
+        std::numeric_limits<float>::max_digits10) << renderer.subpixel_size();
+
+    return list.str();
+}
+
+std::string
+frame_filename(std::string const& prefix, std::size_t i)
+{
+    std::ostringstream filename;
+    filename << prefix << "_" << std::setw(4) << std::setfill('0') << i
+        << ".png";
+
+    return filename.str();
+}
+
+double
+read_baseline(std::string const& filename)
+{
+    std::ifstream input(filename);
+    if (!input.good())
+    {
+        throw std::runtime_error("Failed to open " + filename + ".");
+    }
+
+    double baseline;
+    if (!(input >> baseline) || !(baseline > 0.0))
+    {
+        throw std::runtime_error("Invalid frame time baseline in "
+            + filename + ".");
+    }
+
+    return baseline;
+}
+
+void
+write_baseline(std::string const& filename, double baseline)
+{
+    std::ofstream output(filename);
+    if (!output.good())
+    {
+        throw std::runtime_error("Failed to open " + filename + ".");
+    }
+
+    output << std::fixed << std::setprecision(3) << baseline << std::endl;
+}
+
+// The median is robust against outliers caused by other processes.
+double
+median(std::vector<double> values)
+{
+    std::nth_element(values.begin(), values.begin() + values.size() / 2,
+        values.end());
+
+    return values[values.size() / 2];
+}
+
+// Parses a count with an optional k, M or G suffix, e.g. 10M.
+bool
+parse_count(std::string const& text, std::size_t& count)
+{
+    std::istringstream input(text);
+
+    double value;
+    if (!(input >> value) || !(value >= 1.0))
+    {
+        return false;
+    }
+
+    char suffix;
+    if (input >> suffix)
+    {
+        if (suffix == 'k')      value *= 1e3;
+        else if (suffix == 'M') value *= 1e6;
+        else if (suffix == 'G') value *= 1e9;
+        else
+        {
+            return false;
+        }
+
+        if (input >> suffix)
+        {
+            return false;
+        }
+    }
+
+    count = static_cast<std::size_t>(value);
+
+    return true;
+}
+
+// Returns the number of frames to replay a scenario with, by default 60
+// frames per second of the scenario.
+std::size_t
+replay_frame_count(Scenario const& scenario, std::size_t frames)
+{
+    if (frames > 0)
+    {
+        return frames;
+    }
+
+    return static_cast<std::size_t>(scenario.duration_ms() * 0.06) + 1;
+}
+
+// Renders frame i of a replay and returns its timing. The settings hold
+// the list applied to the renderer so far, and the window size stands in
+// for a viewport missing from the scenario.
+FrameTiming
+replay_frame(Scenario const& scenario, std::size_t i, std::size_t num_frames,
+    std::string& settings)
+{
+    FrameTiming timing;
+    timing.frame = i;
+    timing.time_ms = scenario.frame_time(i, num_frames);
+
+    Scenario::State state = scenario.state(timing.time_ms);
+
+    if (i == 0 || state.settings != settings)
+    {
+        RenderSettings render_settings;
+        if (!parse_settings(state.settings, render_settings))
+        {
+            throw std::runtime_error("Invalid renderer settings '"
+                + state.settings + "' in the scenario.");
+        }
+
+        apply_gl_settings(render_settings, *viz);
+        settings = state.settings;
+    }
+
+    timing.width = state.width > 0 ? state.width : g_window_width;
+    timing.height = state.height > 0 ? state.height : g_window_height;
+
+    set_camera_pose(g_camera, state.pose);
+    set_viewport(timing.width, timing.height);
+
+    viz->set_pass_timing();
+
+    auto begin = std::chrono::steady_clock::now();
+
+    display();
+    glFinish();
+
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - begin;
+
+    timing.frame_ms = elapsed.count();
+    viz->pass_times(timing.pass_ms);
+
+    return timing;
+}
+
+// Prints a summary of the frame times of a replay and writes them to a
+// report.
+void
+report_replay(std::string const& filename,
+    std::vector<FrameTiming> const& timings)
+{
+    std::vector<double> frame_times;
+    std::size_t slowest(0);
+
+    for (std::size_t i(0); i < timings.size(); ++i)
+    {
+        frame_times.push_back(timings[i].frame_ms);
+
+        if (timings[i].frame_ms > timings[slowest].frame_ms)
+        {
+            slowest = i;
+        }
+    }
+
+    std::cout << "Replayed " << timings.size() << " frames, median frame "
+        "time " << std::fixed << std::setprecision(2) << median(frame_times)
+        << " ms, slowest " << timings[slowest].frame_ms << " ms at frame "
+        << timings[slowest].frame << "." << std::endl;
+
+    write_frame_report(filename, timings);
+
+    std::cout << "Write frame report to " << filename << "." << std::endl;
+}
+
+// Ends the replay in the viewer, with a report of the frames replayed so
+// far, and returns the viewport to the window.
+void
+finish_replay()
+{
+    if (g_replay_frames == 0)
+    {
+        return;
+    }
+
+    g_replay_frame = g_replay_frames = 0;
+
+    viz->set_pass_timing(g_telemetry != nullptr);
+    set_viewport(g_window_width, g_window_height);
+
+    if (!g_replay_timings.empty())
+    {
+        try
+        {
+            report_replay(g_report_filename, g_replay_timings);
+        }
+        catch (std::runtime_error const& e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+
+        g_replay_timings.clear();
+    }
+}
+
+// Records the frames of the viewer or replaces them with those of a
+// replay.
+void
+display_scenario()
+{
+    if (!g_record_filename.empty())
+    {
+        std::chrono::duration<double, std::milli> time =
+            std::chrono::steady_clock::now() - g_record_start;
+
+        g_record.record_viewport(time.count(), g_window_width,
+            g_window_height);
+        g_record.record_settings(time.count(), settings_list(*viz));
+        g_record.record_pose(time.count(), camera_pose(g_camera));
+    }
+
+    if (g_replay_frame >= g_replay_frames)
+    {
+        display_prepared();
+        return;
+    }
+
+    try
+    {
+        g_replay_timings.push_back(replay_frame(g_replay, g_replay_frame,
+            g_replay_frames, g_replay_settings));
+
+        if (++g_replay_frame == g_replay_frames)
+        {
+            finish_replay();
+        }
+    }
+    catch (std::runtime_error const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        finish_replay();
+    }
+}
+
+void
+close_viewer()
+{
+    if (!g_record_filename.empty())
+    {
+        try
+        {
+            g_record.save(g_record_filename);
+
+            std::cout << "Recorded " << g_record.num_events()
+                << " events to " << g_record_filename << "." << std::endl;
+        }
+        catch (std::runtime_error const& e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
+    finish_replay();
+    close();
+}
+
+// Replays the scenario offscreen with a fixed number of frames.
+int
+replay(BatchOptions const& options)
+{
+    int width, height;
+    g_replay.max_viewport(width, height);
+
+    // Render to an offscreen surface large enough for all viewports.
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
+    GLviz::GLviz(std::max(width, options.width),
+        std::max(height, options.height));
+
+    viz = std::unique_ptr<SplatRenderer>(new SplatRenderer(g_camera));
+    apply_gl_settings(RenderSettings(), *viz);
+    load_model(false);
+
+    reshape(options.width, options.height);
+
+    std::size_t const num_frames = replay_frame_count(g_replay,
+        options.frames);
+    std::vector<FrameTiming> timings;
+    std::string settings;
+
+    std::cout << "\nReplay " << num_frames << " frames of "
+        << options.scenario_filename << "." << std::endl;
+
+    try
+    {
+        // An untimed first frame excludes one-time driver costs.
+        replay_frame(g_replay, 0, num_frames, settings);
+
+        for (std::size_t i(0); i < num_frames; ++i)
+        {
+            timings.push_back(replay_frame(g_replay, i, num_frames,
+                settings));
+
+            FrameTiming const& timing = timings.back();
+
+            std::cout << "  frame " << i << " at " << std::fixed
+                << std::setprecision(2) << timing.time_ms << " ms, "
+                << timing.width << "x" << timing.height << ", "
+                << timing.frame_ms << " ms (" << timing.pass_ms[0]
+                << " visibility, " << timing.pass_ms[1] << " attribute, "
+                << timing.pass_ms[2] << " finalization)" << std::endl;
+        }
+    }
+    catch (std::runtime_error const& e)
+    {
+        close();
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    close();
+
+    try
+    {
+        report_replay(options.report_filename, timings);
+    }
+    catch (std::runtime_error const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// Renders the poses with one renderer per job, each on its own thread and
+// OpenGL context. A surface may only be current on one thread, hence each
+// job binds its context to a hidden window of its own and renders into a
+// framebuffer object. All jobs read the same surfels, which stay unchanged
+// until the jobs have finished.
+int
+render_jobs(BatchOptions const& options, RenderSettings const& settings,
+    std::vector<CameraPose> const& poses)
+{
+    int const width = options.width, height = options.height;
+
+    SDL_Window* window = SDL_GL_GetCurrentWindow();
+    SDL_GLContext context = SDL_GL_GetCurrentContext();
+
+    // Windows and contexts are created on the main thread, which makes
+    // each context current and releases it before the jobs start.
+    std::vector<SDL_Window*> windows;
+    std::vector<SDL_GLContext> contexts;
+    for (unsigned int i(0); i < options.jobs; ++i)
+    {
+        SDL_Window* job_window = SDL_CreateWindow("surface_splatting",
+            SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 1, 1,
+            SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+        if (!job_window)
+        {
+            std::cerr << "Error: Failed to create a window for job " << i
+                << ". " << SDL_GetError() << std::endl;
+            break;
+        }
+
+        SDL_GLContext job_context = SDL_GL_CreateContext(job_window);
+        if (!job_context)
+        {
+            std::cerr << "Error: Failed to create an OpenGL context for job "
+                << i << ". " << SDL_GetError() << std::endl;
+            SDL_DestroyWindow(job_window);
+            break;
+        }
+
+        windows.push_back(job_window);
+        contexts.push_back(job_context);
+    }
+
+    SDL_GL_MakeCurrent(window, nullptr);
+
+    if (contexts.empty())
+    {
+        SDL_GL_MakeCurrent(window, context);
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "\nRender " << poses.size() << " poses at " << width
+        << "x" << height << " in " << contexts.size() << " jobs."
+        << std::endl;
+
+    std::mutex output_mutex;
+    std::atomic<unsigned int> failures(0);
+
+    // A job failing, e.g. to compile the shaders or to allocate the buffer
+    // objects, counts as a failure and leaves its poses unrendered.
+    auto job = [&](std::size_t index) {
+        if (SDL_GL_MakeCurrent(windows[index], contexts[index]) != 0)
+        {
+            std::lock_guard<std::mutex> lock(output_mutex);
+            std::cerr << "Error: Job " << index << " failed to make its "
+                "OpenGL context current. " << SDL_GetError() << std::endl;
+            ++failures;
+            return;
+        }
+
+        GLuint fbo(0), color(0);
+
+        try
+        {
+            GLviz::Camera camera;
+            SplatRenderer renderer(camera);
+            apply_gl_settings(settings, renderer);
+            renderer.set_geometry(g_surfels);
+
+            glGenRenderbuffers(1, &color);
+            glBindRenderbuffer(GL_RENDERBUFFER, color);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+            glGenFramebuffers(1, &fbo);
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                GL_RENDERBUFFER, color);
+
+            glViewport(0, 0, width, height);
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+            std::vector<unsigned char> rgba(4 * static_cast<std::size_t>(
+                width) * static_cast<std::size_t>(height));
+
+            for (std::size_t i(index); i < poses.size();
+                i += contexts.size())
+            {
+                set_camera_pose(camera, poses[i]);
+                camera.set_perspective(60.0f, static_cast<float>(width) /
+                    static_cast<float>(height), 0.005f, 5.0f);
+
+                auto begin = std::chrono::steady_clock::now();
+
+                renderer.render_frame();
+                glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                    rgba.data());
+
+                std::chrono::duration<double, std::milli> elapsed =
+                    std::chrono::steady_clock::now() - begin;
+
+                std::string filename = frame_filename(options.output_prefix,
+                    i);
+
+                try
+                {
+                    write_png(filename, width, height, rgba);
+                }
+                catch (std::runtime_error const& e)
+                {
+                    std::lock_guard<std::mutex> lock(output_mutex);
+                    std::cerr << e.what() << std::endl;
+                    ++failures;
+                }
+
+                std::lock_guard<std::mutex> lock(output_mutex);
+                std::cout << "  " << filename << " " << std::fixed
+                    << std::setprecision(2) << elapsed.count() << " ms, job "
+                    << index << "." << std::endl;
+            }
+        }
+        catch (std::exception const& e)
+        {
+            std::lock_guard<std::mutex> lock(output_mutex);
+            std::cerr << "Error: Job " << index << " failed. " << e.what()
+                << std::endl;
+            ++failures;
+        }
+
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &color);
+
+        SDL_GL_MakeCurrent(windows[index], nullptr);
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (std::size_t i(0); i < contexts.size(); ++i)
+    {
+        threads.push_back(std::thread(job, i));
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - begin;
+
+    for (std::size_t i(0); i < contexts.size(); ++i)
+    {
+        SDL_GL_DeleteContext(contexts[i]);
+        SDL_DestroyWindow(windows[i]);
+    }
+
+    SDL_GL_MakeCurrent(window, context);
+
+    std::cout << "Rendered " << poses.size() << " poses in " << std::fixed
+        << std::setprecision(2) << elapsed.count() << " ms, "
+        << static_cast<double>(poses.size()) * 1000.0 / elapsed.count()
+        << " poses per second." << std::endl;
+
+    return failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int
+batch(BatchOptions const& options)
+{
+    int const width = options.width, height = options.height;
+
+    std::vector<CameraPose> poses;
+    RenderSettings settings;
+    double baseline(0.0);
+
+    if (!parse_settings(options.settings, settings))
+    {
+        std::cerr << "Error: Invalid renderer settings '" << options.settings
+            << "'." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        poses = load_camera_poses(options.poses_filename);
+
+        if (!options.baseline_filename.empty())
+        {
+            baseline = read_baseline(options.baseline_filename);
+        }
+    }
+    catch (std::runtime_error const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (poses.empty())
+    {
+        std::cerr << "Error: No camera poses in " << options.poses_filename
+            << "." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<unsigned char> rgba(4 * static_cast<std::size_t>(width)
+        * static_cast<std::size_t>(height));
+
+    // The CPU reference renderer neither needs nor creates an OpenGL
+    // context.
+    std::unique_ptr<CpuSplatRenderer> cpu;
+
+    if (options.tile_size > 0 && (options.renderer != "gl"
+        || options.views != "mono"))
+    {
+        std::cerr << "Error: Tiled rendering supports mono views with the "
+            "OpenGL renderer only." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (options.jobs > 1 && (options.renderer != "gl"
+        || options.views != "mono" || options.tile_size > 0
+        || !options.reference_prefix.empty()
+        || !options.baseline_filename.empty()
+        || !options.save_baseline_filename.empty()))
+    {
+        std::cerr << "Error: Parallel jobs support untiled mono views with "
+            "the OpenGL renderer and no regression checks only."
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (options.renderer == "cpu")
+    {
+        if (options.views != "mono" || settings.multisample
+            || settings.pointsize_method != 0 || settings.hole_filling != 0
+            || settings.subpixel_size != 0.0f)
+        {
+            std::cerr << "Error: The CPU renderer supports mono views and "
+                "the PBP point size method without multisampling, hole "
+                "filling and the sub-pixel fast path only." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        cpu = std::unique_ptr<CpuSplatRenderer>(new CpuSplatRenderer());
+        cpu->reshape(width, height);
+        apply_settings(settings, *cpu);
+
+        if (options.threads > 0)
+        {
+            cpu->set_threads(options.threads);
+        }
+
+        load_model(false);
+    }
+    else
+    {
+        // Render to an offscreen surface. Together with Mesa's llvmpipe
+        // driver this requires neither a display nor a GPU.
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
+
+        // Tiles are rendered offscreen, hence the window need not exceed
+        // the tile size.
+        if (options.tile_size > 0)
+        {
+            GLviz::GLviz(std::min(width, options.tile_size),
+                std::min(height, options.tile_size));
+        }
+        else
+        {
+            GLviz::GLviz(width, height);
+        }
+
+        // Model upload and shader compilation happen once for all poses.
+        viz = std::unique_ptr<SplatRenderer>(new SplatRenderer(g_camera));
+        apply_gl_settings(settings, *viz);
+        viz->set_pass_timing(options.views == "mono"
+            && options.tile_size == 0);
+        load_model(false);
+
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadBuffer(GL_BACK);
+    }
+
+    // GPU times of the visibility, attribute and finalization passes of
+    // the last mono frame rendered with OpenGL.
+    float pass_ms[3] = { 0.0f, 0.0f, 0.0f };
+
+    // Clusters tested and skipped by occlusion culling over all frames.
+    std::size_t tested_clusters(0), occluded_clusters(0);
+
+    // Renders a pose into rgba and returns the elapsed time in
+    // milliseconds.
+    auto render = [&](CameraPose const& pose) {
+        set_camera_pose(g_camera, pose);
+
+        if (cpu)
+        {
+            g_camera.set_perspective(60.0f, static_cast<float>(width) /
+                static_cast<float>(height), 0.005f, 5.0f);
+
+            auto begin = std::chrono::steady_clock::now();
+
+            cpu->render_frame(g_surfels, g_camera.get_modelview_matrix(),
+                g_camera.get_projection_matrix());
+            cpu->finalize(rgba);
+
+            std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - begin;
+
+            return elapsed.count();
+        }
+
+        // Images larger than the framebuffer limits are rendered in tiles.
+        if (options.tile_size > 0)
+        {
+            g_camera.set_perspective(60.0f, static_cast<float>(width) /
+                static_cast<float>(height), 0.005f, 5.0f);
+
+            auto begin = std::chrono::steady_clock::now();
+
+            viz->render_tiled(width, height, options.tile_size, rgba);
+
+            std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - begin;
+
+            tested_clusters += viz->culling_statistics().tested_clusters;
+            occluded_clusters += viz->culling_statistics().occluded_clusters;
+
+            return elapsed.count();
+        }
+
+        reshape(width, height);
+
+        // Multiple views are rendered side by side into one image.
+        std::vector<CameraPose> view_poses;
+        if (options.views == "stereo")
+        {
+            view_poses = stereo_poses(pose, options.eye_separation);
+        }
+        else if (options.views == "cube")
+        {
+            view_poses = cube_map_poses(pose);
+        }
+
+        std::vector<GLviz::Camera> view_cameras(view_poses.size());
+        for (std::size_t j(0); j < view_poses.size(); ++j)
+        {
+            set_camera_pose(view_cameras[j], view_poses[j]);
+            view_cameras[j].set_perspective(
+                options.views == "cube" ? 90.0f : 60.0f,
+                static_cast<float>(width) / static_cast<float>(
+                view_poses.size() * height), 0.005f, 5.0f);
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+
+        if (view_cameras.empty())
+        {
+            display();
+        }
+        else
+        {
+            viz->render_frame(view_cameras);
+        }
+
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+            rgba.data());
+
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - begin;
+
+        // The frame has completed with the read back, hence the query
+        // results are available without further waiting.
+        if (viz->pass_timing())
+        {
+            viz->pass_times(pass_ms);
+        }
+
+        tested_clusters += viz->culling_statistics().tested_clusters;
+        occluded_clusters += viz->culling_statistics().occluded_clusters;
+
+        return elapsed.count();
+    };
+
+    // An untimed first frame excludes one-time driver costs, e.g. deferred
+    // shader compilation, from the frame times.
+    render(poses.front());
+
+    // With decimation, the poses are rendered with the original model first
+    // to measure the speedup.
+    double original_median(0.0);
+
+    if (g_decimation > 0.0f)
+    {
+        std::vector<double> original_times;
+        for (auto const& pose : poses)
+        {
+            original_times.push_back(render(pose));
+        }
+
+        original_median = median(original_times);
+
+        decimate_model();
+    }
+
+    if (g_reorder > 0)
+    {
+        reorder_model();
+    }
+
+    if (g_decimation > 0.0f || g_reorder > 0)
+    {
+        if (viz)
+        {
+            viz->set_geometry(g_surfels);
+        }
+
+        render(poses.front());
+    }
+
+    if (options.jobs > 1)
+    {
+        return render_jobs(options, settings, poses);
+    }
+
+    std::cout << "\nRender " << poses.size() << " poses at " << width
+        << "x" << height << "." << std::endl;
+
+    std::vector<double> frame_times, pass_times[3];
+    unsigned int failures(0);
+
+    bool const timed_passes = viz && viz->pass_timing();
+
+    for (std::size_t i(0); i < poses.size(); ++i)
+    {
+        frame_times.push_back(render(poses[i]));
+
+        std::string filename = frame_filename(options.output_prefix, i);
+
+        std::cout << "  " << filename << " " << std::fixed
+            << std::setprecision(2) << frame_times.back() << " ms";
+
+        if (timed_passes)
+        {
+            std::cout << " (" << pass_ms[0] << " visibility, " << pass_ms[1]
+                << " attribute, " << pass_ms[2] << " finalization)";
+
+            for (unsigned int j(0); j < 3; ++j)
+            {
+                pass_times[j].push_back(pass_ms[j]);
+            }
+        }
+
+        try
+        {
+            write_png(filename, width, height, rgba);
+
+            if (!options.reference_prefix.empty())
+            {
+                int reference_width, reference_height;
+                std::vector<unsigned char> reference;
+
+                read_png(frame_filename(options.reference_prefix, i),
+                    reference_width, reference_height, reference);
+
+                float difference(1.0f);
+                if (reference_width == width && reference_height == height)
+                {
+                    difference = perceptual_difference(width, height, rgba,
+                        reference);
+                }
+
+                std::cout << ", " << std::setprecision(3)
+                    << 100.0f * difference << "% pixels differ";
+
+                if (difference > options.tolerance)
+                {
+                    std::cout << " (FAILED)";
+                    ++failures;
+                }
+            }
+        }
+        catch (std::runtime_error const& e)
+        {
+            std::cout << std::endl;
+            std::cerr << e.what() << std::endl;
+            close();
+            return EXIT_FAILURE;
+        }
+
+        std::cout << std::endl;
+    }
+
+    SplatRenderer::PagingStatistics paging;
+    if (viz)
+    {
+        paging = viz->paging_statistics();
+    }
+
+    close();
+
+    double frame_time = median(frame_times);
+
+    std::cout << "Median frame time " << std::setprecision(2) << frame_time
+        << " ms";
+
+    if (original_median > 0.0)
+    {
+        std::cout << ", " << original_median << " ms without decimation ("
+            << original_median / frame_time << "x speedup)";
+    }
+
+    if (baseline > 0.0)
+    {
+        std::cout << ", baseline " << baseline << " ms";
+
+        if (frame_time > baseline * (1.0 + options.time_tolerance))
+        {
+            std::cout << " (FAILED)";
+            ++failures;
+        }
+    }
+
+    std::cout << "." << std::endl;
+
+    if (timed_passes)
+    {
+        std::cout << "Median pass times " << median(pass_times[0])
+            << " ms visibility, " << median(pass_times[1]) << " ms attribute, "
+            << median(pass_times[2]) << " ms finalization." << std::endl;
+    }
+
+    if (g_gpu_budget > 0 && !cpu)
+    {
+        std::cout << "Paged " << paging.num_pages << " pages, "
+            << paging.resident_pages << " resident in " << std::setprecision(1)
+            << static_cast<double>(paging.budget_bytes) / 1048576.0
+            << " MiB, " << paging.uploaded_pages << " uploaded, "
+            << paging.evicted_pages << " evicted." << std::endl;
+    }
+
+    if (paging.num_buffers > 1 && !cpu)
+    {
+        std::cout << "Split " << paging.num_pages << " pages into "
+            << paging.num_buffers << " buffer objects." << std::endl;
+    }
+
+    if (settings.occlusion_culling && !cpu)
+    {
+        std::cout << "Occlusion culling skipped " << occluded_clusters
+            << " of " << tested_clusters << " clusters." << std::endl;
+    }
+
+    if (!options.save_baseline_filename.empty())
+    {
+        try
+        {
+            write_baseline(options.save_baseline_filename, frame_time);
+        }
+        catch (std::runtime_error const& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " regression(s) detected." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+void
+usage(char const* name)
+{
+    std::cerr << "Usage: " << name << " [options]" << std::endl
+        << "  --model <dragon|plane|cube>  Model to load, or the filename"
+        << std::endl
+        << "                               of a .ply or .raw mesh or a .srf"
+        << std::endl
+        << "                               surfel file."
+        << std::endl
+        << "  --model <checkerboards|terrain|replicas>[:<count>]"
+        << std::endl
+        << "                               Procedural scene of about <count>"
+        << std::endl
+        << "                               surfels, e.g. terrain:10M."
+        << std::endl
+        << "  --batch <file>               Render the camera poses listed in"
+        << std::endl
+        << "                               <file> offscreen and exit."
+        << std::endl
+        << "  --output <prefix>            Output file prefix in batch mode."
+        << std::endl
+        << "  --size <width>x<height>      Image size in batch mode."
+        << std::endl
+        << "  --views <mono|stereo|cube>   Views per pose in batch mode."
+        << std::endl
+        << "  --eye-separation <distance>  Eye separation of stereo views."
+        << std::endl
+        << "  --renderer <gl|cpu>          Renderer in batch mode." << std::endl
+        << "  --threads <n>                Threads of the CPU renderer."
+        << std::endl
+        << "  --jobs <n>                   Render poses in parallel, each job"
+        << std::endl
+        << "                               with its own OpenGL context."
+        << std::endl
+        << "  --tile <pixels>              Render in tiles of at most this"
+        << std::endl
+        << "                               size in batch mode."
+        << std::endl
+        << "  --settings <list>            Renderer settings in batch mode,"
+        << std::endl
+        << "                               e.g. smooth,ewa,pointsize=2,fill=3."
+        << std::endl
+        << "  --reference <prefix>         Compare to reference images."
+        << std::endl
+        << "  --tolerance <fraction>       Fraction of pixels allowed to"
+        << std::endl
+        << "                               differ noticeably from the"
+        << std::endl
+        << "                               reference images."
+        << std::endl
+        << "  --baseline <file>            Compare the median frame time"
+        << std::endl
+        << "                               to the baseline in <file>."
+        << std::endl
+        << "  --time-tolerance <fraction>  Allowed frame time increase."
+        << std::endl
+        << "  --save-baseline <file>       Save the median frame time."
+        << std::endl
+        << "  --decimate <error>           Merge surfels up to a geometric"
+        << std::endl
+        << "                               error relative to the bounding"
+        << std::endl
+        << "                               box diagonal, e.g. 0.0005."
+        << std::endl
+        << "  --reorder <none|morton|morton-normal>"
+        << std::endl
+        << "                               Sort surfels along a Morton curve,"
+        << std::endl
+        << "                               optionally grouped by normal."
+        << std::endl
+        << "  --memory-limit <MiB>         Fail instead of exceeding a heap"
+        << std::endl
+        << "                               size."
+        << std::endl
+        << "  --gpu-budget <MiB>           GPU memory for surfels, beyond"
+        << std::endl
+        << "                               which they are paged on demand."
+        << std::endl
+        << "  --gpu-buffer-size <MiB>      Largest buffer object for surfels,"
+        << std::endl
+        << "                               beyond which they are split."
+        << std::endl
+        << "  --record <file>              Record camera poses, viewports and"
+        << std::endl
+        << "                               renderer settings in the viewer."
+        << std::endl
+        << "  --replay <file>              Replay a recorded scenario."
+        << std::endl
+        << "  --replay-mode <window|offscreen>"
+        << std::endl
+        << "                               Replay in the viewer or headless."
+        << std::endl
+        << "  --frames <n>                 Frames to replay the scenario with,"
+        << std::endl
+        << "                               by default 60 per second."
+        << std::endl
+        << "  --report <file>              Frame time report of the replay."
+        << std::endl
+        << "  --telemetry <prefix>         Write per-frame timings to"
+        << std::endl
+        << "                               <prefix>.csv and <prefix>.json."
+        << std::endl
+        << "  --save <file>                Save the surfels of the model as"
+        << std::endl
+        << "                               a .srf surfel file and exit."
+        << std::endl;
+}
+
+}
+
+int
+main(int argc, char* argv[])
+{
+    BatchOptions options;
+
+    for (int i(1); i < argc; ++i)
+    {
+        std::string arg(argv[i]);
+
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        std::string value(argv[++i]);
+
+        if (arg == "--model")
+        {
+            // Procedural scenes take an optional surfel count, e.g.
+            // terrain:10M.
+            std::string scene = value.substr(0, value.find(':'));
+            bool procedural = scene == "checkerboards"
+                || scene == "terrain" || scene == "replicas";
+
+            if (procedural && scene != value && !parse_count(value.substr(
+                scene.size() + 1), g_scene_size))
+            {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+
+            if (value == "dragon")              g_model = 0;
+            else if (value == "plane")          g_model = 1;
+            else if (value == "cube")           g_model = 2;
+            else if (scene == "checkerboards")  g_model = 3;
+            else if (scene == "terrain")        g_model = 4;
+            else if (scene == "replicas")       g_model = 5;
+            else
+            {
+                g_model = 6;
+                g_model_filename = value;
+            }
+        }
+        else if (arg == "--batch")
+        {
+            options.poses_filename = value;
+        }
+        else if (arg == "--output")
+        {
+            options.output_prefix = value;
+        }
+        else if (arg == "--size")
+        {
+            char x;
+            std::istringstream size(value);
+            if (!(size >> options.width >> x >> options.height) || x != 'x'
+                || options.width <= 0 || options.height <= 0)
+            {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (arg == "--views" && (value == "mono"
+            || value == "stereo" || value == "cube"))
+        {
+            options.views = value;
+        }
+        else if (arg == "--eye-separation")
+        {
+            options.eye_separation = static_cast<float>(
+                std::atof(value.c_str()));
+        }
+        else if (arg == "--renderer" && (value == "gl" || value == "cpu"))
+        {
+            options.renderer = value;
+        }
+        else if (arg == "--tile")
+        {
+            options.tile_size = std::atoi(value.c_str());
+        }
+        else if (arg == "--jobs")
+        {
+            options.jobs = static_cast<unsigned int>(std::max(1,
+                std::atoi(value.c_str())));
+        }
+        else if (arg == "--threads")
+        {
+            options.threads = static_cast<unsigned int>(
+                std::atoi(value.c_str()));
+        }
+        else if (arg == "--settings")
+        {
+            options.settings = value;
+        }
+        else if (arg == "--reference")
+        {
+            options.reference_prefix = value;
+        }
+        else if (arg == "--tolerance")
+        {
+            options.tolerance = static_cast<float>(std::atof(value.c_str()));
+        }
+        else if (arg == "--baseline")
+        {
+            options.baseline_filename = value;
+        }
+        else if (arg == "--time-tolerance")
+        {
+            options.time_tolerance = static_cast<float>(
+                std::atof(value.c_str()));
+        }
+        else if (arg == "--save-baseline")
+        {
+            options.save_baseline_filename = value;
+        }
+        else if (arg == "--decimate")
+        {
+            g_decimation = static_cast<float>(std::atof(value.c_str()));
+        }
+        else if (arg == "--reorder" && (value == "none"
+            || value == "morton" || value == "morton-normal"))
+        {
+            g_reorder = value == "none" ? 0 : (value == "morton" ? 1 : 2);
+        }
+        else if (arg == "--memory-limit")
+        {
+            set_memory_limit(static_cast<std::size_t>(std::atof(
+                value.c_str()) * 1048576.0));
+        }
+        else if (arg == "--gpu-budget")
+        {
+            g_gpu_budget = static_cast<std::size_t>(std::atof(
+                value.c_str()) * 1048576.0);
+        }
+        else if (arg == "--gpu-buffer-size")
+        {
+            g_gpu_buffer_size = static_cast<std::size_t>(std::atof(
+                value.c_str()) * 1048576.0);
+        }
+        else if (arg == "--record")
+        {
+            g_record_filename = value;
+        }
+        else if (arg == "--replay")
+        {
+            options.scenario_filename = value;
+        }
+        else if (arg == "--replay-mode" && (value == "window"
+            || value == "offscreen"))
+        {
+            options.replay_mode = value;
+        }
+        else if (arg == "--frames")
+        {
+            options.frames = static_cast<std::size_t>(std::max(0,
+                std::atoi(value.c_str())));
+        }
+        else if (arg == "--report")
+        {
+            options.report_filename = value;
+        }
+        else if (arg == "--telemetry")
+        {
+            g_telemetry_prefix = value;
+        }
+        else if (arg == "--save")
+        {
+            g_save_filename = value;
+        }
+        else
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!g_telemetry_prefix.empty())
+    {
+        g_telemetry = std::unique_ptr<Telemetry>(new Telemetry());
+    }
+
+    if (!g_save_filename.empty())
+    {
+        load_model();
+
+        try
+        {
+            write_surfels(g_save_filename, g_surfels);
+        }
+        catch (std::runtime_error const& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::cout << "\nWrite " << g_surfels.size() << " surfels to "
+            << g_save_filename << "." << std::endl;
+
+        return EXIT_SUCCESS;
+    }
+
+    if (!options.poses_filename.empty())
+    {
+        return batch(options);
+    }
+
+    if (!options.scenario_filename.empty())
+    {
+        if (!g_record_filename.empty())
+        {
+            std::cerr << "Error: A scenario cannot be recorded while "
+                "replaying one." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        try
+        {
+            g_replay.load(options.scenario_filename);
+        }
+        catch (std::runtime_error const& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if (g_replay.empty())
+        {
+            std::cerr << "Error: No camera poses in "
+                << options.scenario_filename << "." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if (options.replay_mode == "offscreen")
+        {
+            return replay(options);
+        }
+
+        g_replay_frames = replay_frame_count(g_replay, options.frames);
+        g_report_filename = options.report_filename;
+    }
+
+    GLviz::GLviz();
+
+    g_camera.translate(Eigen::Vector3f(0.0f, 0.0f, -2.0f));
+    viz = std::unique_ptr<SplatRenderer>(new SplatRenderer(g_camera));
+    viz->set_pass_timing(g_telemetry != nullptr);
+    viz->set_memory_budget(g_gpu_budget);
+    if (g_gpu_buffer_size > 0)
+    {
+        viz->set_max_buffer_size(g_gpu_buffer_size);
+    }
+
+    load_model();
+
+    GLviz::display_callback(display_scenario);
+    GLviz::reshape_callback(reshape);
+    GLviz::close_callback(close_viewer);
+    GLviz::gui_callback(gui);
+    GLviz::keyboard_callback(keyboard);
+
+    g_record_start = std::chrono::steady_clock::now();
 
     return GLviz::exec(g_camera);
 }
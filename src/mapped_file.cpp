@@ -0,0 +1,154 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "mapped_file.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(std::string const& filename)
+    : m_data(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE),
+      m_mapping(nullptr)
+{
+    m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("Failed to open " + filename + ".");
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size))
+    {
+        CloseHandle(m_file);
+        throw std::runtime_error("Failed to stat " + filename + ".");
+    }
+
+    m_size = static_cast<std::size_t>(size.QuadPart);
+
+    if (m_size > 0)
+    {
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0,
+            nullptr);
+
+        if (m_mapping != nullptr)
+        {
+            m_data = static_cast<unsigned char const*>(MapViewOfFile(
+                m_mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+
+        if (m_data == nullptr)
+        {
+            if (m_mapping != nullptr)
+            {
+                CloseHandle(m_mapping);
+            }
+
+            CloseHandle(m_file);
+            throw std::runtime_error("Failed to map " + filename + ".");
+        }
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data != nullptr)
+    {
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mapping);
+    }
+
+    CloseHandle(m_file);
+}
+
+#else
+
+MappedFile::MappedFile(std::string const& filename)
+    : m_data(nullptr), m_size(0)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        throw std::runtime_error("Failed to open " + filename + ".");
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("Failed to stat " + filename + ".");
+    }
+
+    m_size = static_cast<std::size_t>(st.st_size);
+
+    if (m_size > 0)
+    {
+        void* ptr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (ptr == MAP_FAILED)
+        {
+            close(fd);
+            throw std::runtime_error("Failed to map " + filename + ".");
+        }
+
+        m_data = static_cast<unsigned char const*>(ptr);
+    }
+
+    // The mapping remains valid after closing the file descriptor.
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data != nullptr)
+    {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+}
+
+#endif
+
+unsigned char const*
+MappedFile::data() const
+{
+    return m_data;
+}
+
+std::size_t
+MappedFile::size() const
+{
+    return m_size;
+}
@@ -0,0 +1,225 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "memory_stats.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+std::atomic<std::size_t> g_allocations(0);
+std::atomic<std::size_t> g_allocated_bytes(0);
+std::atomic<std::size_t> g_current_bytes(0);
+std::atomic<std::size_t> g_peak_bytes(0);
+std::atomic<std::size_t> g_limit_bytes(0);
+
+// Each allocation is preceded by its size, padded to keep the alignment
+// of malloc.
+std::size_t const header_size(alignof(std::max_align_t));
+
+void
+raise_peak(std::size_t bytes)
+{
+    std::size_t peak = g_peak_bytes.load(std::memory_order_relaxed);
+
+    while (peak < bytes && !g_peak_bytes.compare_exchange_weak(peak, bytes,
+        std::memory_order_relaxed))
+    {
+    }
+}
+
+void*
+allocate(std::size_t size) noexcept
+{
+    std::size_t current = g_current_bytes.fetch_add(size,
+        std::memory_order_relaxed) + size;
+    std::size_t limit = g_limit_bytes.load(std::memory_order_relaxed);
+
+    unsigned char* ptr = nullptr;
+
+    if ((limit == 0 || current <= limit) && size <= static_cast<std::size_t>(
+        -1) - header_size)
+    {
+        ptr = static_cast<unsigned char*>(std::malloc(header_size + size));
+    }
+
+    if (ptr == nullptr)
+    {
+        g_current_bytes.fetch_sub(size, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    raise_peak(current);
+
+    *reinterpret_cast<std::size_t*>(ptr) = size;
+
+    return ptr + header_size;
+}
+
+void*
+allocate_or_throw(std::size_t size)
+{
+    void* ptr = allocate(size);
+
+    while (ptr == nullptr)
+    {
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+
+        handler();
+        ptr = allocate(size);
+    }
+
+    return ptr;
+}
+
+void
+deallocate(void* ptr) noexcept
+{
+    if (ptr != nullptr)
+    {
+        unsigned char* base = static_cast<unsigned char*>(ptr) - header_size;
+
+        g_current_bytes.fetch_sub(*reinterpret_cast<std::size_t*>(base),
+            std::memory_order_relaxed);
+        std::free(base);
+    }
+}
+
+}
+
+void*
+operator new(std::size_t size)
+{
+    return allocate_or_throw(size);
+}
+
+void*
+operator new[](std::size_t size)
+{
+    return allocate_or_throw(size);
+}
+
+void*
+operator new(std::size_t size, std::nothrow_t const&) noexcept
+{
+    return allocate(size);
+}
+
+void*
+operator new[](std::size_t size, std::nothrow_t const&) noexcept
+{
+    return allocate(size);
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+    deallocate(ptr);
+}
+
+void
+operator delete[](void* ptr) noexcept
+{
+    deallocate(ptr);
+}
+
+void
+operator delete(void* ptr, std::size_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void
+operator delete[](void* ptr, std::size_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void
+operator delete(void* ptr, std::nothrow_t const&) noexcept
+{
+    deallocate(ptr);
+}
+
+void
+operator delete[](void* ptr, std::nothrow_t const&) noexcept
+{
+    deallocate(ptr);
+}
+
+MemoryStats
+memory_stats()
+{
+    MemoryStats stats;
+    stats.allocations = g_allocations.load(std::memory_order_relaxed);
+    stats.allocated_bytes = g_allocated_bytes.load(
+        std::memory_order_relaxed);
+    stats.current_bytes = g_current_bytes.load(std::memory_order_relaxed);
+    stats.peak_bytes = g_peak_bytes.load(std::memory_order_relaxed);
+
+    return stats;
+}
+
+void
+set_memory_limit(std::size_t bytes)
+{
+    g_limit_bytes = bytes;
+}
+
+std::size_t
+memory_limit()
+{
+    return g_limit_bytes;
+}
+
+MemoryScope::MemoryScope()
+    : m_begin_bytes(g_current_bytes.load()),
+      m_outer_peak_bytes(g_peak_bytes.exchange(m_begin_bytes))
+{
+}
+
+MemoryScope::~MemoryScope()
+{
+    raise_peak(m_outer_peak_bytes);
+}
+
+std::size_t
+MemoryScope::begin_bytes() const
+{
+    return m_begin_bytes;
+}
+
+std::size_t
+MemoryScope::peak_bytes() const
+{
+    return g_peak_bytes.load();
+}
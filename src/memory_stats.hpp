@@ -0,0 +1,63 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef MEMORY_STATS_HPP
+#define MEMORY_STATS_HPP
+
+#include <cstddef>
+
+// Heap statistics of the process. They are collected by the replaced global
+// operator new and delete, which are linked into every program that uses
+// this module.
+struct MemoryStats
+{
+    std::size_t allocations, allocated_bytes;   // Totals since start.
+    std::size_t current_bytes, peak_bytes;
+};
+
+MemoryStats memory_stats();
+
+// Limits the heap size of the process in bytes, zero removes the limit.
+// Allocations beyond the limit throw std::bad_alloc.
+void set_memory_limit(std::size_t bytes);
+std::size_t memory_limit();
+
+// Tracks the peak heap size during its lifetime, e.g. of one stage of the
+// load pipeline. Scopes may be nested but must not overlap across threads.
+class MemoryScope
+{
+
+public:
+    MemoryScope();
+    ~MemoryScope();
+
+    MemoryScope(MemoryScope const&) = delete;
+    MemoryScope& operator=(MemoryScope const&) = delete;
+
+    std::size_t begin_bytes() const;
+    std::size_t peak_bytes() const;
+
+private:
+    std::size_t m_begin_bytes, m_outer_peak_bytes;
+};
+
+#endif // MEMORY_STATS_HPP
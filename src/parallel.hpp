@@ -0,0 +1,109 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Returns the given number of threads, or the number of hardware threads
+// for zero.
+unsigned int hardware_threads(unsigned int num_threads = 0);
+
+// Calls function(b, e) for the ranges [b, e) of grain elements that
+// partition [0, n). The ranges are taken in order by the given number of
+// threads, zero uses all hardware threads, one of which is the calling
+// thread. An exception thrown by function, e.g. std::bad_alloc beyond the
+// memory limit, stops the threads from taking further ranges and the first
+// one is rethrown on the calling thread once all threads have finished.
+template <typename Function>
+void
+parallel_for(std::size_t n, unsigned int num_threads, std::size_t grain,
+    Function const& function)
+{
+    if (n == 0)
+    {
+        return;
+    }
+
+    grain = std::max<std::size_t>(grain, 1);
+
+    std::size_t num_workers = std::min<std::size_t>(
+        hardware_threads(num_threads), (n + grain - 1) / grain);
+
+    std::atomic<std::size_t> next(0);
+    std::atomic<bool> failed(false);
+
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&]() {
+        try
+        {
+            for (std::size_t b = next.fetch_add(grain); b < n && !failed;
+                b = next.fetch_add(grain))
+            {
+                function(b, std::min(b + grain, n));
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+
+            failed = true;
+        }
+    };
+
+    std::vector<std::thread> threads(num_workers - 1);
+    for (auto& t : threads) { t = std::thread(worker); }
+    worker();
+    for (auto& t : threads) { t.join(); }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+// Calls function(b, e) for one range [b, e) of about n / num_threads
+// elements per thread.
+template <typename Function>
+void
+parallel_for(std::size_t n, unsigned int num_threads,
+    Function const& function)
+{
+    std::size_t threads = hardware_threads(num_threads);
+    parallel_for(n, num_threads, (n + threads - 1) / threads, function);
+}
+
+#endif // PARALLEL_HPP
@@ -0,0 +1,764 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "ply.hpp"
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+
+using namespace Eigen;
+
+namespace
+{
+
+enum class PlyType
+{
+    Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64
+};
+
+struct PlyProperty
+{
+    std::string name;
+    PlyType type, count_type;
+    bool list;
+
+    // Byte offset within an element, valid only for elements without
+    // lists.
+    std::size_t offset;
+};
+
+struct PlyElement
+{
+    std::string name;
+    std::size_t count;
+    std::vector<PlyProperty> properties;
+
+    // Size of an element in bytes, zero for elements containing lists.
+    std::size_t stride;
+};
+
+bool
+parse_type(std::string const& name, PlyType& type)
+{
+    if (name == "char" || name == "int8")          type = PlyType::Int8;
+    else if (name == "uchar" || name == "uint8")   type = PlyType::UInt8;
+    else if (name == "short" || name == "int16")   type = PlyType::Int16;
+    else if (name == "ushort" || name == "uint16") type = PlyType::UInt16;
+    else if (name == "int" || name == "int32")     type = PlyType::Int32;
+    else if (name == "uint" || name == "uint32")   type = PlyType::UInt32;
+    else if (name == "float" || name == "float32") type = PlyType::Float32;
+    else if (name == "double" || name == "float64") type = PlyType::Float64;
+    else return false;
+
+    return true;
+}
+
+std::size_t
+type_size(PlyType type)
+{
+    switch (type)
+    {
+        case PlyType::Int8:
+        case PlyType::UInt8:
+            return 1;
+        case PlyType::Int16:
+        case PlyType::UInt16:
+            return 2;
+        case PlyType::Float64:
+            return 8;
+        default:
+            return 4;
+    }
+}
+
+template <typename T, typename S>
+T
+read_as(unsigned char const* ptr)
+{
+    S x;
+    std::memcpy(&x, ptr, sizeof(S));
+    return static_cast<T>(x);
+}
+
+template <typename T>
+T
+read_value(unsigned char const* ptr, PlyType type)
+{
+    switch (type)
+    {
+        case PlyType::Int8:    return read_as<T, std::int8_t>(ptr);
+        case PlyType::UInt8:   return read_as<T, std::uint8_t>(ptr);
+        case PlyType::Int16:   return read_as<T, std::int16_t>(ptr);
+        case PlyType::UInt16:  return read_as<T, std::uint16_t>(ptr);
+        case PlyType::Int32:   return read_as<T, std::int32_t>(ptr);
+        case PlyType::UInt32:  return read_as<T, std::uint32_t>(ptr);
+        case PlyType::Float32: return read_as<T, float>(ptr);
+        default:               return read_as<T, double>(ptr);
+    }
+}
+
+bool
+host_little_endian()
+{
+    std::uint16_t const x(1);
+    unsigned char c;
+    std::memcpy(&c, &x, 1);
+
+    return c == 1;
+}
+
+int
+find_property(PlyElement const& element, char const* name)
+{
+    for (std::size_t i(0); i < element.properties.size(); ++i)
+    {
+        if (element.properties[i].name == name)
+        {
+            return static_cast<int>(i);
+        }
+    }
+
+    return -1;
+}
+
+// Parses the header and returns its size in bytes.
+std::size_t
+parse_header(unsigned char const* data, std::size_t size,
+    std::string const& filename, std::vector<PlyElement>& elements)
+{
+    std::size_t pos(0);
+    bool format(false);
+
+    for (unsigned int n(0); ; ++n)
+    {
+        unsigned char const* nl = static_cast<unsigned char const*>(
+            std::memchr(data + pos, '\n', size - pos));
+
+        if (nl == nullptr)
+        {
+            throw std::runtime_error(filename
+                + " has an incomplete PLY header.");
+        }
+
+        std::string line(data + pos, nl);
+        pos = nl - data + 1;
+
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+
+        std::istringstream tokens(line);
+        std::string keyword;
+        tokens >> keyword;
+
+        if (n == 0)
+        {
+            if (keyword != "ply")
+            {
+                throw std::runtime_error(filename + " is not a PLY file.");
+            }
+        }
+        else if (keyword == "end_header")
+        {
+            break;
+        }
+        else if (keyword == "format")
+        {
+            std::string type, version;
+            tokens >> type >> version;
+
+            if (type != "binary_little_endian")
+            {
+                throw std::runtime_error(filename
+                    + " is not a binary little-endian PLY file.");
+            }
+
+            format = true;
+        }
+        else if (keyword == "element")
+        {
+            PlyElement element;
+            if (!(tokens >> element.name >> element.count))
+            {
+                throw std::runtime_error(filename
+                    + " has an invalid element in its PLY header.");
+            }
+
+            element.stride = 0;
+            elements.push_back(element);
+        }
+        else if (keyword == "property")
+        {
+            PlyProperty property;
+            std::string type;
+
+            property.list = false;
+            property.offset = 0;
+            property.count_type = PlyType::UInt8;
+
+            tokens >> type;
+            if (type == "list")
+            {
+                std::string count_type;
+                tokens >> count_type >> type;
+
+                property.list = parse_type(count_type, property.count_type);
+                if (!property.list)
+                {
+                    type.clear();
+                }
+            }
+
+            if (elements.empty() || !parse_type(type, property.type)
+                || !(tokens >> property.name))
+            {
+                throw std::runtime_error(filename
+                    + " has an invalid property in its PLY header.");
+            }
+
+            elements.back().properties.push_back(property);
+        }
+        else if (keyword != "comment" && keyword != "obj_info")
+        {
+            throw std::runtime_error(filename
+                + " has an invalid PLY header.");
+        }
+    }
+
+    if (!format)
+    {
+        throw std::runtime_error(filename
+            + " has no format in its PLY header.");
+    }
+
+    for (auto& element : elements)
+    {
+        std::size_t offset(0);
+        bool list(false);
+
+        for (auto& property : element.properties)
+        {
+            property.offset = offset;
+            offset += type_size(property.type);
+            list = list || property.list;
+        }
+
+        element.stride = list ? 0 : offset;
+    }
+
+    return pos;
+}
+
+void
+check_size(unsigned char const* ptr, unsigned char const* end,
+    std::size_t size, std::string const& filename)
+{
+    if (static_cast<std::size_t>(end - ptr) < size)
+    {
+        throw std::runtime_error(filename + " is truncated.");
+    }
+}
+
+// Returns a pointer past the data of an element. Elements containing lists
+// need to be scanned sequentially.
+unsigned char const*
+skip_element(PlyElement const& element, unsigned char const* ptr,
+    unsigned char const* end, std::string const& filename)
+{
+    if (element.stride > 0)
+    {
+        if (static_cast<std::size_t>(end - ptr) / element.stride
+            < element.count)
+        {
+            throw std::runtime_error(filename + " is truncated.");
+        }
+
+        return ptr + element.count * element.stride;
+    }
+
+    for (std::size_t i(0); i < element.count; ++i)
+    {
+        for (auto const& property : element.properties)
+        {
+            std::size_t size = type_size(property.type);
+
+            if (property.list)
+            {
+                std::size_t count_size = type_size(property.count_type);
+                check_size(ptr, end, count_size, filename);
+
+                size *= read_value<std::size_t>(ptr, property.count_type);
+                ptr += count_size;
+            }
+
+            check_size(ptr, end, size, filename);
+            ptr += size;
+        }
+    }
+
+    return ptr;
+}
+
+unsigned char
+read_color(unsigned char const* ptr, PlyProperty const& property)
+{
+    if (property.type == PlyType::Float32 || property.type == PlyType::Float64)
+    {
+        float x = read_value<float>(ptr + property.offset, property.type);
+        return static_cast<unsigned char>(255.0f * std::min(std::max(x,
+            0.0f), 1.0f) + 0.5f);
+    }
+
+    return static_cast<unsigned char>(std::min(read_value<unsigned int>(
+        ptr + property.offset, property.type), 255u));
+}
+
+unsigned char const*
+read_vertices(PlyElement const& element, unsigned char const* ptr,
+    unsigned char const* end, std::string const& filename,
+    std::vector<Vector3f>& vertices, std::vector<Vector3f>& normals,
+    std::vector<unsigned int>& colors)
+{
+    if (element.stride == 0)
+    {
+        throw std::runtime_error(filename
+            + " has lists in its vertex element, which are not supported.");
+    }
+
+    unsigned char const* next = skip_element(element, ptr, end, filename);
+
+    int const x = find_property(element, "x");
+    int const y = find_property(element, "y");
+    int const z = find_property(element, "z");
+
+    if (x < 0 || y < 0 || z < 0)
+    {
+        throw std::runtime_error(filename + " has no vertex positions.");
+    }
+
+    int const nx = find_property(element, "nx");
+    int const ny = find_property(element, "ny");
+    int const nz = find_property(element, "nz");
+
+    int const red = find_property(element, "red");
+    int const green = find_property(element, "green");
+    int const blue = find_property(element, "blue");
+    int const alpha = find_property(element, "alpha");
+
+    bool const has_normals = nx >= 0 && ny >= 0 && nz >= 0;
+    bool const has_colors = red >= 0 && green >= 0 && blue >= 0;
+
+    auto const& properties = element.properties;
+
+    // Positions are usually stored as three consecutive floats and copied
+    // as a whole.
+    bool const packed = y == x + 1 && z == x + 2
+        && properties[x].type == PlyType::Float32
+        && properties[y].type == PlyType::Float32
+        && properties[z].type == PlyType::Float32;
+
+    vertices.resize(element.count);
+    normals.resize(has_normals ? element.count : 0);
+    colors.resize(has_colors ? element.count : 0);
+
+    parallel_for(element.count, 0, [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; ++i)
+        {
+            unsigned char const* p = ptr + i * element.stride;
+
+            if (packed)
+            {
+                std::memcpy(vertices[i].data(), p + properties[x].offset,
+                    3 * sizeof(float));
+            }
+            else
+            {
+                vertices[i] = Vector3f(
+                    read_value<float>(p + properties[x].offset,
+                        properties[x].type),
+                    read_value<float>(p + properties[y].offset,
+                        properties[y].type),
+                    read_value<float>(p + properties[z].offset,
+                        properties[z].type));
+            }
+
+            if (has_normals)
+            {
+                normals[i] = Vector3f(
+                    read_value<float>(p + properties[nx].offset,
+                        properties[nx].type),
+                    read_value<float>(p + properties[ny].offset,
+                        properties[ny].type),
+                    read_value<float>(p + properties[nz].offset,
+                        properties[nz].type));
+            }
+
+            if (has_colors)
+            {
+                colors[i] = static_cast<unsigned int>(read_color(p,
+                        properties[red]))
+                    | (static_cast<unsigned int>(read_color(p,
+                        properties[green])) << 8)
+                    | (static_cast<unsigned int>(read_color(p,
+                        properties[blue])) << 16)
+                    | (static_cast<unsigned int>(alpha >= 0 ? read_color(p,
+                        properties[alpha]) : 255) << 24);
+            }
+        }
+    });
+
+    return next;
+}
+
+unsigned char const*
+read_faces(PlyElement const& element, unsigned char const* ptr,
+    unsigned char const* end, std::string const& filename,
+    std::size_t num_vertices, std::vector<std::array<unsigned int, 3>>& faces)
+{
+    int list = find_property(element, "vertex_indices");
+    if (list < 0)
+    {
+        list = find_property(element, "vertex_index");
+    }
+
+    if (list < 0 || !element.properties[list].list)
+    {
+        throw std::runtime_error(filename + " has no face vertex indices.");
+    }
+
+    PlyProperty const& indices = element.properties[list];
+    std::size_t const count_size = type_size(indices.count_type);
+    std::size_t const index_size = type_size(indices.type);
+
+    // If the index list is the only list and all faces are triangles, the
+    // faces have a fixed size and are decoded in parallel.
+    std::size_t prefix(0), stride(count_size + 3 * index_size);
+    unsigned int lists(0);
+
+    for (std::size_t i(0); i < element.properties.size(); ++i)
+    {
+        PlyProperty const& property = element.properties[i];
+
+        if (property.list)
+        {
+            ++lists;
+        }
+        else
+        {
+            stride += type_size(property.type);
+            prefix += static_cast<int>(i) < list ? type_size(property.type)
+                : 0;
+        }
+    }
+
+    std::atomic<bool> polygons(false), invalid(false);
+
+    // Signed indices are copied as well, negative ones become invalid.
+    bool const packed = indices.type == PlyType::Int32
+        || indices.type == PlyType::UInt32;
+
+    if (lists == 1 && static_cast<std::size_t>(end - ptr) / stride
+        >= element.count)
+    {
+        faces.resize(element.count);
+
+        parallel_for(element.count, 0, [&](std::size_t b, std::size_t e) {
+            // Once a polygon is found, the remaining faces are read at the
+            // wrong stride, hence all threads stop.
+            for (std::size_t i = b; i < e && !polygons; ++i)
+            {
+                unsigned char const* p = ptr + i * stride + prefix;
+
+                if (read_value<unsigned int>(p, indices.count_type) != 3)
+                {
+                    polygons = true;
+                    return;
+                }
+
+                p += count_size;
+
+                if (packed)
+                {
+                    std::memcpy(faces[i].data(), p, 3 * sizeof(unsigned int));
+                }
+                else
+                {
+                    for (unsigned int k(0); k < 3; ++k)
+                    {
+                        faces[i][k] = read_value<unsigned int>(
+                            p + k * index_size, indices.type);
+                    }
+                }
+
+                if (faces[i][0] >= num_vertices || faces[i][1] >= num_vertices
+                    || faces[i][2] >= num_vertices)
+                {
+                    invalid = true;
+                }
+            }
+        });
+
+        if (!polygons)
+        {
+            if (invalid)
+            {
+                throw std::runtime_error(filename
+                    + " has invalid vertex indices.");
+            }
+
+            return ptr + element.count * stride;
+        }
+    }
+
+    // Otherwise the faces are decoded sequentially. Indices found invalid
+    // at the wrong stride do not count.
+    invalid = false;
+    faces.clear();
+    faces.reserve(element.count);
+
+    for (std::size_t i(0); i < element.count && !invalid; ++i)
+    {
+        for (auto const& property : element.properties)
+        {
+            std::size_t size = type_size(property.type);
+            std::size_t n(1);
+
+            if (property.list)
+            {
+                check_size(ptr, end, type_size(property.count_type),
+                    filename);
+
+                n = read_value<std::size_t>(ptr, property.count_type);
+                ptr += type_size(property.count_type);
+            }
+
+            check_size(ptr, end, n * size, filename);
+
+            if (&property == &indices)
+            {
+                for (std::size_t k(2); k < n; ++k)
+                {
+                    std::array<unsigned int, 3> face = {{
+                        read_value<unsigned int>(ptr, property.type),
+                        read_value<unsigned int>(ptr + (k - 1) * size,
+                            property.type),
+                        read_value<unsigned int>(ptr + k * size,
+                            property.type)
+                    }};
+
+                    invalid = invalid || face[0] >= num_vertices
+                        || face[1] >= num_vertices
+                        || face[2] >= num_vertices;
+
+                    faces.push_back(face);
+                }
+            }
+
+            ptr += n * size;
+        }
+    }
+
+    if (invalid)
+    {
+        throw std::runtime_error(filename + " has invalid vertex indices.");
+    }
+
+    return ptr;
+}
+
+void
+append_property(std::ostringstream& header, char const* type,
+    char const* name)
+{
+    header << "property " << type << " " << name << "\n";
+}
+
+}
+
+void
+load_ply(std::string const& filename, std::vector<Vector3f>& vertices,
+    std::vector<std::array<unsigned int, 3>>& faces,
+    std::vector<Vector3f>& normals, std::vector<unsigned int>& colors)
+{
+    if (!host_little_endian())
+    {
+        throw std::runtime_error("Reading PLY files requires a "
+            "little-endian host.");
+    }
+
+    MappedFile file(filename);
+
+    std::vector<PlyElement> elements;
+    unsigned char const* ptr = file.data() + parse_header(file.data(),
+        file.size(), filename, elements);
+    unsigned char const* end = file.data() + file.size();
+
+    vertices.clear();
+    faces.clear();
+    normals.clear();
+    colors.clear();
+
+    auto vertex = std::find_if(elements.begin(), elements.end(),
+        [](PlyElement const& element) { return element.name == "vertex"; });
+
+    if (vertex == elements.end())
+    {
+        throw std::runtime_error(filename + " has no vertex element.");
+    }
+
+    for (auto const& element : elements)
+    {
+        if (&element == &*vertex)
+        {
+            ptr = read_vertices(element, ptr, end, filename, vertices,
+                normals, colors);
+        }
+        else if (element.name == "face")
+        {
+            ptr = read_faces(element, ptr, end, filename, vertex->count,
+                faces);
+        }
+        else
+        {
+            ptr = skip_element(element, ptr, end, filename);
+        }
+    }
+}
+
+void
+write_ply(std::string const& filename,
+    std::vector<Vector3f> const& vertices,
+    std::vector<std::array<unsigned int, 3>> const& faces,
+    std::vector<Vector3f> const& normals,
+    std::vector<unsigned int> const& colors)
+{
+    if (!host_little_endian())
+    {
+        throw std::runtime_error("Writing PLY files requires a "
+            "little-endian host.");
+    }
+
+    std::ofstream output(filename, std::ios::binary);
+    if (!output.good())
+    {
+        throw std::runtime_error("Failed to open " + filename + ".");
+    }
+
+    bool const has_normals = !normals.empty();
+    bool const has_colors = !colors.empty();
+
+    std::ostringstream header;
+    header << "ply\nformat binary_little_endian 1.0\n";
+    header << "element vertex " << vertices.size() << "\n";
+    append_property(header, "float", "x");
+    append_property(header, "float", "y");
+    append_property(header, "float", "z");
+
+    if (has_normals)
+    {
+        append_property(header, "float", "nx");
+        append_property(header, "float", "ny");
+        append_property(header, "float", "nz");
+    }
+
+    if (has_colors)
+    {
+        append_property(header, "uchar", "red");
+        append_property(header, "uchar", "green");
+        append_property(header, "uchar", "blue");
+        append_property(header, "uchar", "alpha");
+    }
+
+    if (!faces.empty())
+    {
+        header << "element face " << faces.size() << "\n";
+        append_property(header, "list uchar uint", "vertex_indices");
+    }
+
+    header << "end_header\n";
+    output << header.str();
+
+    // Elements are written in blocks through a buffer.
+    std::size_t const block_size(1 << 16);
+    std::vector<unsigned char> buffer;
+
+    std::size_t const vertex_size = 12 + (has_normals ? 12 : 0)
+        + (has_colors ? 4 : 0);
+
+    for (std::size_t b(0); b < vertices.size(); b += block_size)
+    {
+        std::size_t e = std::min(b + block_size, vertices.size());
+        buffer.resize((e - b) * vertex_size);
+
+        unsigned char* p = buffer.data();
+        for (std::size_t i(b); i < e; ++i)
+        {
+            std::memcpy(p, vertices[i].data(), 12);
+            p += 12;
+
+            if (has_normals)
+            {
+                std::memcpy(p, normals[i].data(), 12);
+                p += 12;
+            }
+
+            if (has_colors)
+            {
+                std::memcpy(p, &colors[i], 4);
+                p += 4;
+            }
+        }
+
+        output.write(reinterpret_cast<char const*>(buffer.data()),
+            buffer.size());
+    }
+
+    for (std::size_t b(0); b < faces.size(); b += block_size)
+    {
+        std::size_t e = std::min(b + block_size, faces.size());
+        buffer.resize((e - b) * 13);
+
+        unsigned char* p = buffer.data();
+        for (std::size_t i(b); i < e; ++i)
+        {
+            *p = 3;
+            std::memcpy(p + 1, faces[i].data(), 12);
+            p += 13;
+        }
+
+        output.write(reinterpret_cast<char const*>(buffer.data()),
+            buffer.size());
+    }
+
+    if (!output.good())
+    {
+        throw std::runtime_error("Failed to write " + filename + ".");
+    }
+}
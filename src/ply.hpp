@@ -0,0 +1,51 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef PLY_HPP
+#define PLY_HPP
+
+#include <Eigen/Core>
+
+#include <array>
+#include <string>
+#include <vector>
+
+// Reads a binary little-endian PLY file through a memory mapping. Vertex
+// positions are required, faces, normals (nx, ny, nz) and colors (red,
+// green, blue and optionally alpha) are read if present and left empty
+// otherwise. Polygons are triangulated as fans. Colors are packed in the
+// same way as Surfel::rgba. Elements are decoded by all hardware threads.
+void load_ply(std::string const& filename,
+    std::vector<Eigen::Vector3f>& vertices,
+    std::vector<std::array<unsigned int, 3>>& faces,
+    std::vector<Eigen::Vector3f>& normals,
+    std::vector<unsigned int>& colors);
+
+// Writes a binary little-endian PLY file. Normals and colors are written if
+// not empty.
+void write_ply(std::string const& filename,
+    std::vector<Eigen::Vector3f> const& vertices,
+    std::vector<std::array<unsigned int, 3>> const& faces,
+    std::vector<Eigen::Vector3f> const& normals,
+    std::vector<unsigned int> const& colors);
+
+#endif // PLY_HPP
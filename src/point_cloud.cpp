@@ -0,0 +1,157 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "point_cloud.hpp"
+#include "kd_tree.hpp"
+#include "parallel.hpp"
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+
+using namespace Eigen;
+
+namespace
+{
+
+// Number of nearest neighbors a splat is scaled to reach, which roughly
+// corresponds to the first ring of neighbors on a regularly sampled
+// surface.
+std::size_t const ring_size = 6;
+
+// Upper bound on the ratio of the semi-axes of a splat.
+float const max_anisotropy = 4.0f;
+
+void
+point_to_surfel(std::vector<Vector3f> const& points,
+    std::vector<std::pair<float, unsigned int>> const& neighbors,
+    Vector3f const& c, Surfel& surfel)
+{
+    surfel.c = c;
+    surfel.p = Vector3f::Zero();
+
+    Vector3f centroid = Vector3f::Zero();
+    for (auto const& neighbor : neighbors)
+    {
+        centroid += points[neighbor.second];
+    }
+    centroid /= static_cast<float>(neighbors.size());
+
+    Matrix3f C = Matrix3f::Zero();
+    for (auto const& neighbor : neighbors)
+    {
+        Vector3f d = points[neighbor.second] - centroid;
+        C += d * d.transpose();
+    }
+
+    // Eigenvalues are sorted in increasing order, the eigenvector of the
+    // smallest one is the normal.
+    SelfAdjointEigenSolver<Matrix3f> es;
+    es.computeDirect(C);
+
+    Vector3f t1 = es.eigenvectors().col(2);
+    Vector3f t2 = es.eigenvectors().col(1);
+
+    float l1 = std::max(es.eigenvalues()(2), 0.0f);
+    float l2 = std::max(es.eigenvalues()(1), l1 / (max_anisotropy
+        * max_anisotropy));
+
+    if (!(l1 > 0.0f))
+    {
+        // All neighbors coincide.
+        surfel.u = surfel.v = Vector3f::Zero();
+        return;
+    }
+
+    // Scale the ellipse with semi-axes proportional to the square roots of
+    // the eigenvalues until it contains the nearest neighbors. Only the
+    // nearest neighbors by Euclidean distance are considered.
+    float s[4 * ring_size];
+    std::size_t n(0);
+
+    for (auto const& neighbor : neighbors)
+    {
+        Vector3f d = points[neighbor.second] - c;
+
+        float x = t1.dot(d), y = t2.dot(d);
+        float r2 = x * x / l1 + y * y / l2;
+
+        if (r2 > 0.0f && n < sizeof(s) / sizeof(float))
+        {
+            s[n++] = r2;
+        }
+    }
+
+    float scale(0.0f);
+    if (n > 0)
+    {
+        std::size_t m = std::min(ring_size, n) - 1;
+        std::nth_element(s, s + m, s + n);
+        scale = std::sqrt(s[m]);
+    }
+
+    surfel.u = scale * std::sqrt(l1) * t1;
+    surfel.v = scale * std::sqrt(l2) * t2;
+}
+
+}
+
+void
+point_cloud_to_surfel(std::vector<Vector3f> const& points,
+    std::vector<Vector3f> const& normals,
+    std::vector<unsigned int> const& colors,
+    std::vector<Surfel>& surfels, unsigned int k, unsigned int num_threads)
+{
+    num_threads = hardware_threads(num_threads);
+
+    k = std::max(k, 3u);
+
+    KdTree tree(points, num_threads);
+    std::vector<unsigned int> const& indices = tree.indices();
+
+    surfels.resize(points.size());
+
+    // Points are processed in tree order such that consecutive queries
+    // access nearby points.
+    parallel_for(points.size(), num_threads,
+        [&](std::size_t b, std::size_t e) {
+            std::vector<std::pair<float, unsigned int>> neighbors;
+            neighbors.reserve(k);
+
+            for (std::size_t j = b; j < e; ++j)
+            {
+                unsigned int index = indices[j];
+                Surfel& surfel = surfels[index];
+
+                tree.knn(points[index], k, neighbors);
+                point_to_surfel(points, neighbors, points[index], surfel);
+
+                if (!normals.empty() && surfel.u.cross(surfel.v).dot(
+                    normals[index]) < 0.0f)
+                {
+                    surfel.u.swap(surfel.v);
+                }
+
+                surfel.rgba = colors.empty() ? 0 : colors[index];
+            }
+        });
+}
@@ -0,0 +1,45 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef POINT_CLOUD_HPP
+#define POINT_CLOUD_HPP
+
+#include "surfel.hpp"
+
+#include <Eigen/Core>
+
+#include <vector>
+
+// Converts an unorganized point cloud to surfels. The tangent axes of a
+// surfel are the principal axes of the covariance of its k nearest
+// neighbors, scaled such that the elliptical splat reaches its nearest
+// neighbors in all directions and neighboring splats overlap without
+// holes. If normals are given, they orient the surfels, and if colors
+// packed as in Surfel::rgba are given, they are assigned to the surfels.
+// A thread count of zero uses all hardware threads.
+void point_cloud_to_surfel(std::vector<Eigen::Vector3f> const& points,
+    std::vector<Eigen::Vector3f> const& normals,
+    std::vector<unsigned int> const& colors,
+    std::vector<Surfel>& surfels, unsigned int k = 16,
+    unsigned int num_threads = 0);
+
+#endif // POINT_CLOUD_HPP
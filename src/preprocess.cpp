@@ -0,0 +1,449 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "preprocess.hpp"
+#include "parallel.hpp"
+
+#include <GLviz/utility.hpp>
+
+#include "config.hpp"
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace Eigen;
+
+namespace
+{
+
+unsigned int
+average_color(unsigned int c0, unsigned int c1, unsigned int c2)
+{
+    unsigned int rgba(0);
+
+    for (unsigned int i(0); i < 32; i += 8)
+    {
+        unsigned int sum = ((c0 >> i) & 0xff) + ((c1 >> i) & 0xff)
+            + ((c2 >> i) & 0xff);
+        rgba |= ((sum + 1) / 3) << i;
+    }
+
+    return rgba;
+}
+
+}
+
+void
+load_triangle_mesh(std::string const& filename, std::vector<
+    Eigen::Vector3f>& vertices, std::vector<std::array<
+    unsigned int, 3>>& faces)
+{
+    std::cout << "\nRead " << filename << "." << std::endl;
+    std::ifstream input(filename);
+
+    if (input.good())
+    {
+        input.close();
+        GLviz::load_raw(filename, vertices, faces);
+    }
+    else
+    {
+        input.close();
+
+        std::ostringstream fqfn;
+        fqfn << path_resources;
+        fqfn << filename;
+        GLviz::load_raw(fqfn.str(), vertices, faces);
+    }
+
+    std::cout << "  #vertices " << vertices.size() << std::endl;
+    std::cout << "  #faces    " << faces.size() << std::endl;
+}
+
+void
+load_plane(unsigned int n, std::vector<Surfel>& surfels)
+{
+    const float d = 1.0f / static_cast<float>(2 * n);
+
+    Surfel s(Vector3f::Zero(),
+             2.0f * d * Vector3f::UnitX(),
+             2.0f * d * Vector3f::UnitY(),
+             Vector3f::Zero(),
+             0);
+
+    surfels.resize(4 * n * n);
+    unsigned int m(0);
+
+    for (unsigned int i(0); i <= 2 * n; ++i)
+    {
+        for (unsigned int j(0); j <= 2 * n; ++j)
+        {
+            unsigned int k(i * (2 * n + 1) + j);
+
+            if (k % 2 == 1)
+            {
+                s.c = Vector3f(
+                    -1.0f + 2.0f * d * static_cast<float>(j),
+                    -1.0f + 2.0f * d * static_cast<float>(i),
+                    0.0f);
+                s.rgba = (((j / 2) % 2) == ((i / 2) % 2)) ? 0u : ~0u;
+                surfels[m] = s;
+
+                // Clip border surfels.
+                if (j == 2 * n)
+                {
+                    surfels[m].p = Vector3f(-1.0f, 0.0f, 0.0f);
+                    surfels[m].rgba = ~s.rgba;
+                }
+                else if (i == 2 * n)
+                {
+                    surfels[m].p = Vector3f(0.0f, -1.0f, 0.0f);
+                    surfels[m].rgba = ~s.rgba;
+                }
+                else if (j == 0)
+                {
+                    surfels[m].p = Vector3f(1.0f, 0.0f, 0.0f);
+                }
+                else if (i == 0)
+                {
+                    surfels[m].p = Vector3f(0.0f, 1.0f, 0.0f);
+                }
+                else
+                {
+                    // Duplicate and clip inner surfels.
+                    if (j % 2 == 0)
+                    {
+                        surfels[m].p = Vector3f(1.0, 0.0f, 0.0f);
+
+                        surfels[++m] = s;
+                        surfels[m].p = Vector3f(-1.0, 0.0f, 0.0f);
+                        surfels[m].rgba = ~s.rgba;
+                    }
+
+                    if (i % 2 == 0)
+                    {
+                        surfels[m].p = Vector3f(0.0, 1.0f, 0.0f);
+
+                        surfels[++m] = s;
+                        surfels[m].p = Vector3f(0.0, -1.0f, 0.0f);
+                        surfels[m].rgba = ~s.rgba;
+                    }
+                }
+
+                ++m;
+            }
+        }
+    }
+}
+
+void
+load_cube(std::vector<Surfel>& surfels)
+{
+    Surfel cube[24];
+    unsigned int color = 0;
+
+    // Front.
+    cube[0].c  = Vector3f(-0.5f, 0.0f, 0.5f);
+    cube[0].u = 0.5f * Vector3f::UnitX();
+    cube[0].v = 0.5f * Vector3f::UnitY();
+    cube[0].p = Vector3f(1.0f, 0.0f, 0.0f);
+    cube[0].rgba  = color;
+
+    cube[1]   = cube[0];
+    cube[1].c = Vector3f(0.5f, 0.0f, 0.5f);
+    cube[1].p = Vector3f(-1.0f, 0.0f, 0.0f);
+    
+    cube[2]   = cube[0];
+    cube[2].c = Vector3f(0.0f, 0.5f, 0.5f);
+    cube[2].p = Vector3f(0.0f, -1.0f, 0.0f);
+    
+    cube[3]   = cube[0];
+    cube[3].c = Vector3f(0.0f, -0.5f, 0.5f);
+    cube[3].p = Vector3f(0.0f, 1.0f, 0.0f);
+
+    // Back.
+    cube[4].c = Vector3f(-0.5f, 0.0f, -0.5f);
+    cube[4].u = 0.5f * Vector3f::UnitX();
+    cube[4].v = -0.5f * Vector3f::UnitY();
+    cube[4].p = Vector3f(1.0f, 0.0f, 0.0f);
+    cube[4].rgba = color;
+
+    cube[5] = cube[4];
+    cube[5].c = Vector3f(0.5f, 0.0f, -0.5f);
+    cube[5].p = Vector3f(-1.0f, 0.0f, 0.0f);
+
+    cube[6] = cube[4];
+    cube[6].c = Vector3f(0.0f, 0.5f, -0.5f);
+    cube[6].p = Vector3f(0.0f, 1.0f, 0.0f);
+
+    cube[7] = cube[4];
+    cube[7].c = Vector3f(0.0f, -0.5f, -0.5f);
+    cube[7].p = Vector3f(0.0f, -1.0f, 0.0f);
+
+    // Top.
+    cube[8].c = Vector3f(-0.5f, 0.5f, 0.0f);
+    cube[8].u = 0.5f * Vector3f::UnitX();
+    cube[8].v = -0.5f * Vector3f::UnitZ();
+    cube[8].p = Vector3f(1.0f, 0.0f, 0.0f);
+    cube[8].rgba = color;
+
+    cube[9]    = cube[8];
+    cube[9].c  = Vector3f(0.5f, 0.5f, 0.0f);
+    cube[9].p = Vector3f(-1.0f, 0.0f, 0.0f);
+
+    cube[10]    = cube[8];
+    cube[10].c  = Vector3f(0.0f, 0.5f, 0.5f);
+    cube[10].p = Vector3f(0.0f, 1.0f, 0.0f);
+
+    cube[11] = cube[8];
+    cube[11].c = Vector3f(0.0f, 0.5f, -0.5f);
+    cube[11].p = Vector3f(0.0f, -1.0f, 0.0f);
+
+    // Bottom.
+    cube[12].c = Vector3f(-0.5f, -0.5f, 0.0f);
+    cube[12].u = 0.5f * Vector3f::UnitX();
+    cube[12].v = 0.5f * Vector3f::UnitZ();
+    cube[12].p = Vector3f(1.0f, 0.0f, 0.0f);
+    cube[12].rgba = color;
+
+    cube[13] = cube[12];
+    cube[13].c = Vector3f(0.5f, -0.5f, 0.0f);
+    cube[13].p = Vector3f(-1.0f, 0.0f, 0.0f);
+
+    cube[14] = cube[12];
+    cube[14].c = Vector3f(0.0f, -0.5f, 0.5f);
+    cube[14].p = Vector3f(0.0f, -1.0f, 0.0f);
+
+    cube[15] = cube[12];
+    cube[15].c = Vector3f(0.0f, -0.5f, -0.5f);
+    cube[15].p = Vector3f(0.0f, 1.0f, 0.0f);
+
+    // Left.
+    cube[16].c = Vector3f(-0.5f, -0.5f, 0.0f);
+    cube[16].u = 0.5f * Vector3f::UnitY();
+    cube[16].v = -0.5f * Vector3f::UnitZ();
+    cube[16].p = Vector3f(1.0f, 0.0f, 0.0f);
+    cube[16].rgba = color;
+
+    cube[17] = cube[16];
+    cube[17].c = Vector3f(-0.5f, 0.5f, 0.0f);
+    cube[17].p = Vector3f(-1.0f, 0.0f, 0.0f);
+
+    cube[18] = cube[16];
+    cube[18].c = Vector3f(-0.5f, 0.0f, 0.5f);
+    cube[18].p = Vector3f(0.0f, 1.0f, 0.0f);
+
+    cube[19] = cube[16];
+    cube[19].c = Vector3f(-0.5f, 0.0f, -0.5f);
+    cube[19].p = Vector3f(0.0f, -1.0f, 0.0f);
+
+    // Right.
+    cube[20].c = Vector3f(0.5f, -0.5f, 0.0f);
+    cube[20].u = 0.5f * Vector3f::UnitY();
+    cube[20].v = 0.5f * Vector3f::UnitZ();
+    cube[20].p = Vector3f(1.0f, 0.0f, 0.0f);
+    cube[20].rgba = color;
+
+    cube[21] = cube[20];
+    cube[21].c = Vector3f(0.5f, 0.5f, 0.0f);
+    cube[21].p = Vector3f(-1.0f, 0.0f, 0.0f);
+
+    cube[22] = cube[20];
+    cube[22].c = Vector3f(0.5f, 0.0f, 0.5f);
+    cube[22].p = Vector3f(0.0f, -1.0f, 0.0f);
+
+    cube[23] = cube[20];
+    cube[23].c = Vector3f(0.5f, 0.0f, -0.5f);
+    cube[23].p = Vector3f(0.0f, 1.0f, 0.0f);
+
+    surfels = std::vector<Surfel>(cube, cube + 24);
+}
+
+void
+steiner_circumellipse(float const* v0_ptr, float const* v1_ptr,
+    float const* v2_ptr, float* p0_ptr, float* t1_ptr, float* t2_ptr)
+{
+    Matrix2f Q;
+    Vector3f d0, d1, d2;
+    {
+        using Vec = Map<const Vector3f>;
+        Vec v[] = { Vec(v0_ptr), Vec(v1_ptr), Vec(v2_ptr) };
+
+        d0 = v[1] - v[0];
+        d0.normalize();
+
+        d1 = v[2] - v[0];
+        d1 = d1 - d0 * d0.dot(d1);
+        d1.normalize();
+
+        d2 = (1.0f / 3.0f) * (v[0] + v[1] + v[2]);
+
+        Vector2f p[3];
+        for (unsigned int j(0); j < 3; ++j)
+        {
+            p[j] = Vector2f(
+                d0.dot(v[j] - d2),
+                d1.dot(v[j] - d2)
+            );
+        }
+
+        Matrix3f A;
+        for (unsigned int j(0); j < 3; ++j)
+        {
+            A.row(j) = Vector3f(
+                p[j].x() * p[j].x(),
+                2.0f * p[j].x() * p[j].y(),
+                p[j].y() * p[j].y()
+            );
+        }
+
+        FullPivLU<Matrix3f> lu(A);
+        Vector3f res = lu.solve(Vector3f::Ones());
+
+        Q(0, 0) = res(0);
+        Q(1, 1) = res(2);
+        Q(0, 1) = Q(1, 0) = res(1);
+    }
+
+    Map<Vector3f> p0(p0_ptr), t1(t1_ptr), t2(t2_ptr);
+    {
+        SelfAdjointEigenSolver<Matrix2f> es;
+        es.compute(Q);
+
+        Vector2f const& l = es.eigenvalues();
+        Vector2f const& e0 = es.eigenvectors().col(0);
+        Vector2f const& e1 = es.eigenvectors().col(1);
+
+        p0 = d2;
+        t1 = (1.0f / std::sqrt(l.x())) * (d0 * e0.x() + d1 * e0.y());
+        t2 = (1.0f / std::sqrt(l.y())) * (d0 * e1.x() + d1 * e1.y());
+    }
+}
+
+void
+hsv2rgb(float h, float s, float v, float& r, float& g, float& b)
+{
+    float h_i = std::floor(h / 60.0f);
+    float f = h / 60.0f - h_i;
+
+    float p = v * (1.0f - s);
+    float q = v * (1.0f - s * f);
+    float t = v * (1.0f - s * (1.0f - f));
+
+    switch (static_cast<int>(h_i))
+    {
+        case 1:
+            r = q; g = v; b = p;
+            break;
+        case 2:
+            r = p; g = v; b = t;
+            break;
+        case 3:
+            r = p; g = q; b = v;
+            break;
+        case 4:
+            r = t; g = p; b = v;
+            break;
+        case 5:
+            r = v; g = p; b = q;
+            break;
+        default:
+            r = v; g = t; b = p;
+    }
+}
+
+void
+face_to_surfel(std::vector<Eigen::Vector3f> const& vertices,
+    std::array<unsigned int, 3> const& face, Surfel& surfel)
+{
+    Vector3f v[3] = {
+        vertices[face[0]],
+        vertices[face[1]],
+        vertices[face[2]]
+    };
+
+    Vector3f p0, t1, t2;
+    steiner_circumellipse(
+        v[0].data(), v[1].data(), v[2].data(),
+        p0.data(), t1.data(), t2.data()
+    );
+
+    Vector3f n_s = t1.cross(t2);
+    Vector3f n_t = (v[1] - v[0]).cross(v[2] - v[0]);
+
+    if (n_t.dot(n_s) < 0.0f)
+    {
+        t1.swap(t2);
+    }
+
+    surfel.c = p0;
+    surfel.u = t1;
+    surfel.v = t2;
+    surfel.p = Vector3f::Zero();
+
+    float h = std::min((std::abs(p0.x()) / 0.45f) * 360.0f, 360.0f);
+    float r, g, b;
+    hsv2rgb(h, 1.0f, 1.0f, r, g, b);
+    surfel.rgba = static_cast<unsigned int>(r * 255.0f)
+        | (static_cast<unsigned int>(g * 255.0f) << 8)
+        | (static_cast<unsigned int>(b * 255.0f) << 16);
+}
+
+void
+mesh_to_surfel(std::vector<Eigen::Vector3f> const& vertices,
+    std::vector<std::array<unsigned int, 3>> const& faces,
+    std::vector<Surfel>& surfels, unsigned int num_threads)
+{
+    mesh_to_surfel(vertices, std::vector<unsigned int>(), faces, surfels,
+        num_threads);
+}
+
+void
+mesh_to_surfel(std::vector<Eigen::Vector3f> const& vertices,
+    std::vector<unsigned int> const& colors,
+    std::vector<std::array<unsigned int, 3>> const& faces,
+    std::vector<Surfel>& surfels, unsigned int num_threads)
+{
+    // Growing the storage does not copy the previous surfels. The elements
+    // are not initialized, each thread touches its own range first.
+    surfels.clear();
+    surfels.resize(faces.size());
+
+    parallel_for(faces.size(), num_threads,
+        [&](std::size_t b, std::size_t e) {
+            for (std::size_t j = b; j < e; ++j)
+            {
+                face_to_surfel(vertices, faces[j], surfels[j]);
+
+                if (!colors.empty())
+                {
+                    surfels[j].rgba = average_color(colors[faces[j][0]],
+                        colors[faces[j][1]], colors[faces[j][2]]);
+                }
+            }
+        });
+}
@@ -0,0 +1,70 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef PREPROCESS_HPP
+#define PREPROCESS_HPP
+
+#include "surfel.hpp"
+
+#include <Eigen/Core>
+
+#include <array>
+#include <string>
+#include <vector>
+
+// Reads a triangle mesh in raw format. If the file does not exist, it is
+// looked up in the resources directory.
+void load_triangle_mesh(std::string const& filename, std::vector<
+    Eigen::Vector3f>& vertices, std::vector<std::array<
+    unsigned int, 3>>& faces);
+
+// Creates a checkerboard plane of 4 n^2 surfels, where surfels on the edges
+// between two checkers are duplicated and clipped.
+void load_plane(unsigned int n, std::vector<Surfel>& surfels);
+
+// Creates a cube of 24 clipped surfels.
+void load_cube(std::vector<Surfel>& surfels);
+
+// Computes the Steiner circumellipse of a triangle given by its center p0
+// and its principal semi-axes t1 and t2.
+void steiner_circumellipse(float const* v0_ptr, float const* v1_ptr,
+    float const* v2_ptr, float* p0_ptr, float* t1_ptr, float* t2_ptr);
+
+void hsv2rgb(float h, float s, float v, float& r, float& g, float& b);
+
+void face_to_surfel(std::vector<Eigen::Vector3f> const& vertices,
+    std::array<unsigned int, 3> const& face, Surfel& surfel);
+
+// Converts each face of a triangle mesh to a surfel. A thread count of zero
+// uses all hardware threads.
+void mesh_to_surfel(std::vector<Eigen::Vector3f> const& vertices,
+    std::vector<std::array<unsigned int, 3>> const& faces,
+    std::vector<Surfel>& surfels, unsigned int num_threads = 0);
+
+// As above, but the color of a surfel is the average of the colors of the
+// face's vertices, packed as in Surfel::rgba.
+void mesh_to_surfel(std::vector<Eigen::Vector3f> const& vertices,
+    std::vector<unsigned int> const& colors,
+    std::vector<std::array<unsigned int, 3>> const& faces,
+    std::vector<Surfel>& surfels, unsigned int num_threads = 0);
+
+#endif // PREPROCESS_HPP
@@ -0,0 +1,282 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "procedural.hpp"
+#include "parallel.hpp"
+#include "preprocess.hpp"
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+using namespace Eigen;
+
+namespace
+{
+
+// Number of grid cells per side such that a square grid of elements of
+// the given size holds approximately num_surfels surfels.
+std::size_t
+grid_size(std::size_t num_surfels, std::size_t element_size)
+{
+    double n = std::sqrt(static_cast<double>(num_surfels)
+        / static_cast<double>(element_size));
+
+    return std::max<std::size_t>(1, static_cast<std::size_t>(
+        std::round(n)));
+}
+
+float
+lattice(std::int32_t x, std::int32_t y, unsigned int seed)
+{
+    std::uint32_t h = static_cast<std::uint32_t>(x) * 0x8da6b343u
+        ^ static_cast<std::uint32_t>(y) * 0xd8163841u ^ seed * 0xcb1ab31fu;
+
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+
+    return static_cast<float>(h & 0xffffff) / static_cast<float>(0xffffff);
+}
+
+// Smooth value noise in [0, 1] and its gradient.
+float
+value_noise(float x, float y, unsigned int seed, Vector2f& gradient)
+{
+    float fx = std::floor(x), fy = std::floor(y);
+    std::int32_t ix = static_cast<std::int32_t>(fx);
+    std::int32_t iy = static_cast<std::int32_t>(fy);
+
+    float tx = x - fx, ty = y - fy;
+    float sx = tx * tx * (3.0f - 2.0f * tx);
+    float sy = ty * ty * (3.0f - 2.0f * ty);
+    float dsx = 6.0f * tx * (1.0f - tx);
+    float dsy = 6.0f * ty * (1.0f - ty);
+
+    float v00 = lattice(ix, iy, seed), v10 = lattice(ix + 1, iy, seed);
+    float v01 = lattice(ix, iy + 1, seed);
+    float v11 = lattice(ix + 1, iy + 1, seed);
+
+    float a = v10 - v00, b = v01 - v00, c = v00 - v10 - v01 + v11;
+
+    gradient = Vector2f(dsx * (a + c * sy), dsy * (b + c * sx));
+
+    return v00 + a * sx + b * sy + c * sx * sy;
+}
+
+// Fractal sum of value noise octaves.
+float
+terrain_height(float x, float y, unsigned int seed, Vector2f& gradient)
+{
+    float height(0.0f), amplitude(0.12f), frequency(2.0f);
+    gradient.setZero();
+
+    for (unsigned int i(0); i < 6; ++i)
+    {
+        Vector2f g;
+        height += amplitude * value_noise(frequency * x, frequency * y,
+            seed + i, g);
+        gradient += amplitude * frequency * g;
+
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+    }
+
+    return height;
+}
+
+unsigned int
+height_color(float height)
+{
+    float r, g, b;
+    hsv2rgb(std::min(std::max(120.0f - 400.0f * height, 0.0f), 120.0f),
+        0.6f, 0.8f, r, g, b);
+
+    return static_cast<unsigned int>(255.0f * r)
+        | static_cast<unsigned int>(255.0f * g) << 8
+        | static_cast<unsigned int>(255.0f * b) << 16
+        | 0xff000000u;
+}
+
+}
+
+void
+generate_checkerboards(std::size_t num_surfels, std::vector<Surfel>& surfels,
+    unsigned int num_threads)
+{
+    std::vector<Surfel> tile;
+    load_plane(50, tile);
+
+    std::size_t const n = grid_size(num_surfels, tile.size());
+    std::size_t const m = tile.size();
+
+    // Tiles are separated by a gap of a tenth of their size.
+    float const pitch = 2.0f / static_cast<float>(n);
+    float const scale = 0.45f * pitch;
+
+    surfels.resize(n * n * m);
+
+    parallel_for(n * n, num_threads,
+        [&](std::size_t b, std::size_t e) {
+            for (std::size_t i = b; i < e; ++i)
+            {
+                Vector3f offset(
+                    -1.0f + pitch * (static_cast<float>(i % n) + 0.5f),
+                    -1.0f + pitch * (static_cast<float>(i / n) + 0.5f),
+                    0.0f);
+
+                for (std::size_t j(0); j < m; ++j)
+                {
+                    Surfel& s = surfels[i * m + j];
+
+                    s = tile[j];
+                    s.c = offset + scale * tile[j].c;
+                    s.u = scale * tile[j].u;
+                    s.v = scale * tile[j].v;
+                }
+            }
+        });
+}
+
+void
+generate_terrain(std::size_t num_surfels, std::vector<Surfel>& surfels,
+    unsigned int seed, unsigned int num_threads)
+{
+    std::size_t const n = std::max<std::size_t>(2,
+        grid_size(num_surfels, 1));
+    std::size_t const valley = n / 2;
+
+    float const spacing = 2.0f / static_cast<float>(n - 1);
+    float const radius = spacing;
+    float const slope = 0.25f;
+
+    float const x0 = -1.0f + spacing * static_cast<float>(valley);
+
+    // Each row holds n surfels plus the duplicate on the valley floor.
+    surfels.resize(n * (n + 1));
+
+    parallel_for(n, num_threads,
+        [&](std::size_t b, std::size_t e) {
+            for (std::size_t i = b; i < e; ++i)
+            {
+                float y = -1.0f + spacing * static_cast<float>(i);
+                Surfel* row = &surfels[i * (n + 1)];
+
+                for (std::size_t j(0); j < n; ++j)
+                {
+                    float x = -1.0f + spacing * static_cast<float>(j);
+
+                    Vector2f gradient;
+                    float z = terrain_height(x, y, seed, gradient) - 0.1f
+                        + slope * std::abs(x - x0);
+
+                    // The tangent v follows the y-axis, such that the line
+                    // u = 0 through surfels on the valley floor is the
+                    // crease.
+                    Vector3f v = radius * Vector3f(0.0f, 1.0f,
+                        gradient.y()).normalized();
+
+                    unsigned int rgba = height_color(z);
+
+                    // Sides of the valley, both for its floor.
+                    int first = j > valley ? 1 : -1;
+                    int last = j < valley ? -1 : 1;
+
+                    for (int side(first); side <= last; side += 2)
+                    {
+                        float hx = gradient.x() + slope
+                            * static_cast<float>(side);
+
+                        Vector3f normal = Vector3f(-hx, -gradient.y(),
+                            1.0f).normalized();
+                        Vector3f u = radius * v.cross(normal).normalized();
+
+                        Surfel& s = row[j + (j > valley || side > 0
+                            ? 1 : 0)];
+
+                        s.c = Vector3f(x, y, z);
+                        s.u = u;
+                        s.v = v;
+                        s.p = Vector3f::Zero();
+                        s.rgba = rgba;
+
+                        if (j == valley)
+                        {
+                            s.p = Vector3f(static_cast<float>(side), 0.0f,
+                                0.0f);
+                        }
+                    }
+                }
+            }
+        });
+}
+
+void
+generate_replicas(std::vector<Surfel> const& model, std::size_t num_surfels,
+    std::vector<Surfel>& surfels, unsigned int num_threads)
+{
+    surfels.clear();
+
+    if (model.empty())
+    {
+        return;
+    }
+
+    AlignedBox3f box;
+    for (auto const& s : model)
+    {
+        box.extend(s.c);
+    }
+
+    std::size_t const n = grid_size(num_surfels, model.size());
+    std::size_t const m = model.size();
+
+    // Copies are placed on a grid in the xz-plane.
+    float const pitch = 2.0f / static_cast<float>(n);
+    float const scale = 0.9f * pitch / std::max(box.sizes().maxCoeff(),
+        1e-12f);
+
+    surfels.resize(n * n * m);
+
+    parallel_for(n * n, num_threads,
+        [&](std::size_t b, std::size_t e) {
+            for (std::size_t i = b; i < e; ++i)
+            {
+                Vector3f offset(
+                    -1.0f + pitch * (static_cast<float>(i % n) + 0.5f),
+                    0.0f,
+                    -1.0f + pitch * (static_cast<float>(i / n) + 0.5f));
+
+                for (std::size_t j(0); j < m; ++j)
+                {
+                    Surfel& s = surfels[i * m + j];
+
+                    s = model[j];
+                    s.c = offset + scale * (model[j].c - box.center());
+                    s.u = scale * model[j].u;
+                    s.v = scale * model[j].v;
+                }
+            }
+        });
+}
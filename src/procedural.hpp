@@ -0,0 +1,50 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef PROCEDURAL_HPP
+#define PROCEDURAL_HPP
+
+#include "surfel.hpp"
+
+#include <cstddef>
+#include <vector>
+
+// Procedural stress scenes of a configurable size for scaling tests. The
+// scenes fit into [-1, 1]^3 and approximate the requested number of
+// surfels. A thread count of zero uses all hardware threads.
+
+// Creates a grid of checkerboard tiles as in load_plane(), including the
+// clipped surfels on the edges between two checkers.
+void generate_checkerboards(std::size_t num_surfels,
+    std::vector<Surfel>& surfels, unsigned int num_threads = 0);
+
+// Creates a noise-displaced terrain with a sharp valley along the y-axis.
+// Surfels on the valley floor are duplicated and clipped.
+void generate_terrain(std::size_t num_surfels, std::vector<Surfel>& surfels,
+    unsigned int seed = 0, unsigned int num_threads = 0);
+
+// Replicates a model in a grid of scaled copies.
+void generate_replicas(std::vector<Surfel> const& model,
+    std::size_t num_surfels, std::vector<Surfel>& surfels,
+    unsigned int num_threads = 0);
+
+#endif // PROCEDURAL_HPP
@@ -32,7 +32,7 @@ extern unsigned char const lighting_glsl[];
 ProgramAttribute::ProgramAttribute()
     : m_ewa_filter(false), m_backface_culling(false),
       m_visibility_pass(true), m_smooth(false), m_color_material(false),
-      m_pointsize_method(0)
+      m_multiview(false), m_pointsize_method(0), m_splat_class(0)
 {
     initialize_shader_obj();
     initialize_program_obj();
@@ -98,6 +98,26 @@ ProgramAttribute::set_color_material(bool enable)
     }
 }
 
+void
+ProgramAttribute::set_multiview(bool enable)
+{
+    if (m_multiview != enable)
+    {
+        m_multiview = enable;
+        initialize_program_obj();
+    }
+}
+
+void
+ProgramAttribute::set_splat_class(unsigned int splat_class)
+{
+    if (m_splat_class != splat_class)
+    {
+        m_splat_class = splat_class;
+        initialize_program_obj();
+    }
+}
+
 void
 ProgramAttribute::initialize_shader_obj()
 {
@@ -106,6 +126,12 @@ ProgramAttribute::initialize_shader_obj()
     m_lighting_vs_obj.load_from_cstr(
         reinterpret_cast<char const*>(lighting_glsl));
 
+    // Multiview programs splat the surfels in the geometry shader.
+    m_attribute_gs_obj.load_from_cstr(
+        reinterpret_cast<char const*>(attribute_vs_glsl));
+    m_lighting_gs_obj.load_from_cstr(
+        reinterpret_cast<char const*>(lighting_glsl));
+
     m_attribute_fs_obj.load_from_cstr(
         reinterpret_cast<char const*>(attribute_fs_glsl));
 }
@@ -119,7 +145,16 @@ ProgramAttribute::initialize_program_obj()
 
         attach_shader(m_attribute_vs_obj);
         attach_shader(m_attribute_fs_obj);
-        attach_shader(m_lighting_vs_obj);
+
+        if (m_multiview)
+        {
+            attach_shader(m_attribute_gs_obj);
+            attach_shader(m_lighting_gs_obj);
+        }
+        else
+        {
+            attach_shader(m_lighting_vs_obj);
+        }
 
         std::map<std::string, int> defines;
         
@@ -135,10 +170,26 @@ ProgramAttribute::initialize_program_obj()
             m_smooth ? 1 : 0));
         defines.insert(std::make_pair("COLOR_MATERIAL",
             m_color_material ? 1 : 0));
+        defines.insert(std::make_pair("MULTIVIEW",
+            m_multiview ? 1 : 0));
+        defines.insert(std::make_pair("SPLAT_CLASS",
+            static_cast<int>(m_splat_class)));
+        defines.insert(std::make_pair("GEOMETRY_SHADER", 0));
 
         m_attribute_vs_obj.compile(defines);
         m_attribute_fs_obj.compile(defines);
-        m_lighting_vs_obj.compile(defines);
+
+        if (m_multiview)
+        {
+            defines["GEOMETRY_SHADER"] = 1;
+
+            m_attribute_gs_obj.compile(defines);
+            m_lighting_gs_obj.compile(defines);
+        }
+        else
+        {
+            m_lighting_vs_obj.compile(defines);
+        }
     }
     catch (shader_compilation_error const& e)
     {
@@ -164,6 +215,11 @@ ProgramAttribute::initialize_program_obj()
         set_uniform_block_binding("Raycast", 1);
         set_uniform_block_binding("Frustum", 2);
         set_uniform_block_binding("Parameter", 3);
+
+        if (m_multiview)
+        {
+            set_uniform_block_binding("MultiView", 4);
+        }
     }
     catch (uniform_not_found_error const& e)
     {
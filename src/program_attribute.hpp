@@ -37,6 +37,12 @@ public:
     void set_visibility_pass(bool enable = true);
     void set_smooth(bool enable = true);
     void set_color_material(bool enable = true);
+    void set_multiview(bool enable = true);
+
+    // Restricts the program to splats larger than the sub-pixel size (1),
+    // or to sub-pixel splats (2), which are rendered without ray casting.
+    // Zero renders all splats.
+    void set_splat_class(unsigned int splat_class);
 
 private:
     void initialize_shader_obj();
@@ -44,11 +50,12 @@ private:
 
 private:
     glVertexShader m_attribute_vs_obj, m_lighting_vs_obj;
+    glGeometryShader m_attribute_gs_obj, m_lighting_gs_obj;
     glFragmentShader m_attribute_fs_obj;
 
     bool m_ewa_filter, m_backface_culling,
-         m_visibility_pass, m_smooth, m_color_material;
-    unsigned int m_pointsize_method;
+         m_visibility_pass, m_smooth, m_color_material, m_multiview;
+    unsigned int m_pointsize_method, m_splat_class;
 };
 
 #endif // PROGRAM_RENDER_HPP
@@ -30,7 +30,7 @@ extern unsigned char const finalization_fs_glsl[];
 extern unsigned char const lighting_glsl[];
 
 ProgramFinalization::ProgramFinalization()
-    : m_smooth(false), m_multisampling(false)
+    : m_smooth(false), m_multisampling(false), m_layered(false)
 {
     initialize_shader_obj();
     initialize_program_obj();
@@ -56,6 +56,16 @@ ProgramFinalization::set_smooth(bool enable)
     }
 }
 
+void
+ProgramFinalization::set_layered(bool enable)
+{
+    if (m_layered != enable)
+    {
+        m_layered = enable;
+        initialize_program_obj();
+    }
+}
+
 void
 ProgramFinalization::initialize_shader_obj()
 {
@@ -80,6 +90,7 @@ ProgramFinalization::initialize_program_obj()
         defines.insert(std::make_pair("SMOOTH", m_smooth ? 1 : 0));
         defines.insert(std::make_pair("MULTISAMPLING",
             m_multisampling ? 1 : 0));
+        defines.insert(std::make_pair("LAYERED", m_layered ? 1 : 0));
 
         m_finalization_vs_obj.compile(defines);
         m_finalization_fs_obj.compile(defines);
@@ -33,6 +33,7 @@ public:
 
     void set_multisampling(bool enable);
     void set_smooth(bool enable);
+    void set_layered(bool enable);
 
 private:
     void initialize_shader_obj();
@@ -42,7 +43,7 @@ private:
     glVertexShader    m_finalization_vs_obj;
     glFragmentShader  m_finalization_fs_obj, m_lighting_fs_obj;
 
-    bool m_smooth, m_multisampling;
+    bool m_smooth, m_multisampling, m_layered;
 };
 
 #endif // PROGRAM_FINALIZATION_HPP
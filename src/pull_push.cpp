@@ -0,0 +1,360 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "pull_push.hpp"
+
+#include <GLviz/utility.hpp>
+
+#include <iostream>
+#include <algorithm>
+
+namespace
+{
+
+GLuint
+create_texture(GLenum internalformat, GLsizei width, GLsizei height)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalformat, width, height, 0,
+        internalformat == GL_R32F ? GL_RED : GL_RGBA, GL_FLOAT, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return texture;
+}
+
+GLuint
+create_framebuffer(GLuint color, GLuint normal, GLuint depth)
+{
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+        GL_TEXTURE_2D, color, 0);
+
+    GLenum buffers[3] = { GL_COLOR_ATTACHMENT0, GL_NONE, GL_NONE };
+    GLsizei num_buffers(1);
+
+    if (normal)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1,
+            GL_TEXTURE_2D, normal, 0);
+        buffers[num_buffers++] = GL_COLOR_ATTACHMENT1;
+    }
+
+    if (depth)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2,
+            GL_TEXTURE_2D, depth, 0);
+        buffers[num_buffers++] = GL_COLOR_ATTACHMENT2;
+    }
+
+    glDrawBuffers(num_buffers, buffers);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Warning: Incomplete pull-push framebuffer."
+            << std::endl;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    return fbo;
+}
+
+}
+
+PullPush::PullPush()
+    : m_levels(3), m_min_coverage(0.5f), m_smooth(false),
+      m_allocated_smooth(false)
+{
+    m_push.set_push(true);
+}
+
+PullPush::~PullPush()
+{
+    release();
+}
+
+unsigned int
+PullPush::levels() const
+{
+    return m_levels;
+}
+
+void
+PullPush::set_levels(unsigned int levels)
+{
+    m_levels = levels;
+}
+
+float
+PullPush::min_coverage() const
+{
+    return m_min_coverage;
+}
+
+void
+PullPush::set_min_coverage(float coverage)
+{
+    m_min_coverage = coverage;
+}
+
+void
+PullPush::set_smooth(bool enable)
+{
+    m_smooth = enable;
+
+    m_pull.set_smooth(enable);
+    m_push.set_smooth(enable);
+}
+
+GLuint
+PullPush::color_texture() const
+{
+    return m_pyramid.empty() ? 0 : m_pyramid.front().push_color;
+}
+
+GLuint
+PullPush::normal_texture() const
+{
+    return m_pyramid.empty() ? 0 : m_pyramid.front().push_normal;
+}
+
+GLuint
+PullPush::depth_texture() const
+{
+    return m_pyramid.empty() ? 0 : m_pyramid.front().push_depth;
+}
+
+void
+PullPush::allocate(GLsizei width, GLsizei height)
+{
+    release();
+
+    m_pyramid.resize(m_levels + 1);
+    m_allocated_smooth = m_smooth;
+
+    for (unsigned int i(0); i <= m_levels; ++i)
+    {
+        Level& level = m_pyramid[i];
+        level = Level();
+
+        level.width = std::max(1, (width + (1 << i) - 1) >> i);
+        level.height = std::max(1, (height + (1 << i) - 1) >> i);
+
+        // The finest level is pulled from the attribute pass.
+        if (i > 0)
+        {
+            level.pull_color = create_texture(GL_RGBA16F,
+                level.width, level.height);
+
+            if (m_smooth)
+            {
+                level.pull_normal = create_texture(GL_RGBA32F,
+                    level.width, level.height);
+            }
+
+            level.pull_fbo = create_framebuffer(level.pull_color,
+                level.pull_normal, 0);
+        }
+
+        level.push_color = create_texture(GL_RGBA16F,
+            level.width, level.height);
+
+        if (m_smooth)
+        {
+            level.push_normal = create_texture(GL_RGBA32F,
+                level.width, level.height);
+            level.push_depth = create_texture(GL_R32F,
+                level.width, level.height);
+        }
+
+        level.push_fbo = create_framebuffer(level.push_color,
+            level.push_normal, level.push_depth);
+    }
+}
+
+void
+PullPush::release()
+{
+    for (Level const& level : m_pyramid)
+    {
+        GLuint textures[5] = { level.pull_color, level.pull_normal,
+            level.push_color, level.push_normal, level.push_depth };
+        GLuint fbos[2] = { level.pull_fbo, level.push_fbo };
+
+        glDeleteTextures(5, textures);
+        glDeleteFramebuffers(2, fbos);
+    }
+
+    m_pyramid.clear();
+}
+
+void
+PullPush::bind_input(GLuint color, GLuint normal, GLuint depth)
+{
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, color);
+
+    if (m_smooth)
+    {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, normal);
+
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, depth);
+    }
+}
+
+void
+PullPush::draw(GLuint quad_vao)
+{
+    glBindVertexArray(quad_vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+}
+
+void
+PullPush::apply(GLsizei width, GLsizei height, GLuint color_texture,
+    GLuint normal_texture, GLuint depth_texture, GLuint quad_vao)
+{
+    if (m_pyramid.size() != m_levels + 1 || m_allocated_smooth != m_smooth
+        || m_pyramid.front().width != width
+        || m_pyramid.front().height != height)
+    {
+        allocate(width, height);
+    }
+
+    try
+    {
+        // Pull: average the finer level into each coarser level.
+        m_pull.use();
+        m_pull.set_uniform_1i("color_texture", 0);
+
+        if (m_smooth)
+        {
+            m_pull.set_uniform_1i("normal_texture", 1);
+            m_pull.set_uniform_1i("depth_texture", 2);
+        }
+
+        for (unsigned int i(1); i <= m_levels; ++i)
+        {
+            Level const& finer = m_pyramid[i - 1];
+            Level const& level = m_pyramid[i];
+
+            if (i == 1)
+            {
+                bind_input(color_texture, normal_texture, depth_texture);
+            }
+            else
+            {
+                bind_input(finer.pull_color, finer.pull_normal, 0);
+            }
+
+            m_pull.set_uniform_1i("first_level", i == 1);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, level.pull_fbo);
+            glViewport(0, 0, level.width, level.height);
+            draw(quad_vao);
+        }
+
+        m_pull.unuse();
+
+        // Push: fill the holes of each level from the next coarser level.
+        m_push.use();
+        m_push.set_uniform_1i("color_texture", 0);
+        m_push.set_uniform_1i("coarse_color_texture", 3);
+        m_push.set_uniform_1i("coarse_coverage_texture", 4);
+        m_push.set_uniform_1f("min_coverage", m_min_coverage);
+
+        if (m_smooth)
+        {
+            m_push.set_uniform_1i("normal_texture", 1);
+            m_push.set_uniform_1i("depth_texture", 2);
+            m_push.set_uniform_1i("coarse_normal_texture", 5);
+        }
+
+        for (unsigned int i(m_levels + 1); i-- > 0;)
+        {
+            Level const& level = m_pyramid[i];
+
+            if (i == 0)
+            {
+                bind_input(color_texture, normal_texture, depth_texture);
+            }
+            else
+            {
+                bind_input(level.pull_color, level.pull_normal, 0);
+            }
+
+            if (i < m_levels)
+            {
+                Level const& coarser = m_pyramid[i + 1];
+
+                glActiveTexture(GL_TEXTURE3);
+                glBindTexture(GL_TEXTURE_2D, coarser.push_color);
+
+                glActiveTexture(GL_TEXTURE4);
+                glBindTexture(GL_TEXTURE_2D, coarser.pull_color);
+
+                if (m_smooth)
+                {
+                    glActiveTexture(GL_TEXTURE5);
+                    glBindTexture(GL_TEXTURE_2D, coarser.push_normal);
+                }
+            }
+
+            m_push.set_uniform_1i("first_level", i == 0);
+            m_push.set_uniform_1i("last_level", i == m_levels);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, level.push_fbo);
+            glViewport(0, 0, level.width, level.height);
+            draw(quad_vao);
+        }
+
+        m_push.unuse();
+    }
+    catch (uniform_not_found_error const& e)
+    {
+        std::cerr << "Warning: Failed to set a uniform variable." << std::endl
+            << e.what() << std::endl;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    for (GLenum i(0); i < 6; ++i)
+    {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,93 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef PULL_PUSH_HPP
+#define PULL_PUSH_HPP
+
+#include "program_pull_push.hpp"
+
+#include <GL/glew.h>
+#include <vector>
+
+// Fills holes between splats in the attachments of the attribute pass
+// with a pull-push pyramid. The filled color, normal and depth textures
+// have the layout the finalization pass expects.
+class PullPush
+{
+
+public:
+    PullPush();
+    ~PullPush();
+
+    // Number of coarser levels used to fill holes. A hole of up to
+    // about 2^levels pixels in diameter is closed.
+    unsigned int levels() const;
+    void set_levels(unsigned int levels);
+
+    // Pixels are only filled from a coarser level whose coverage is at
+    // least the given fraction. Lower values also grow silhouettes.
+    float min_coverage() const;
+    void set_min_coverage(float coverage);
+
+    // Also fills the normal and depth textures for deferred shading.
+    void set_smooth(bool enable);
+
+    // Runs the pull and push passes on the given single-sampled textures
+    // and leaves the viewport and the framebuffer binding in an undefined
+    // state. The quad is the vertex array of the finalization pass.
+    void apply(GLsizei width, GLsizei height, GLuint color_texture,
+        GLuint normal_texture, GLuint depth_texture, GLuint quad_vao);
+
+    GLuint color_texture() const;
+    GLuint normal_texture() const;
+    GLuint depth_texture() const;
+
+private:
+    struct Level
+    {
+        GLsizei width, height;
+
+        // Premultiplied averages of the pull pass.
+        GLuint pull_fbo, pull_color, pull_normal;
+
+        // Filled values of the push pass.
+        GLuint push_fbo, push_color, push_normal, push_depth;
+    };
+
+    void allocate(GLsizei width, GLsizei height);
+    void release();
+
+    void bind_input(GLuint color, GLuint normal, GLuint depth);
+    void draw(GLuint quad_vao);
+
+private:
+    ProgramPullPush m_pull, m_push;
+
+    unsigned int m_levels;
+    float m_min_coverage;
+    bool m_smooth;
+
+    bool m_allocated_smooth;
+    std::vector<Level> m_pyramid;
+};
+
+#endif // PULL_PUSH_HPP
@@ -0,0 +1,376 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "scenario.hpp"
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+using namespace Eigen;
+
+Scenario::State::State()
+    : width(0), height(0)
+{
+    pose.translation = Vector3f(0.0f, 0.0f, -2.0f);
+    pose.rotation = Matrix3f::Identity();
+}
+
+Scenario::Scenario()
+{
+}
+
+bool
+Scenario::empty() const
+{
+    return last_event(pose) == nullptr;
+}
+
+std::size_t
+Scenario::num_events() const
+{
+    return m_events.size();
+}
+
+double
+Scenario::duration_ms() const
+{
+    return m_events.empty() ? 0.0 : m_events.back().time_ms;
+}
+
+void
+Scenario::max_viewport(int& width, int& height) const
+{
+    width = height = 0;
+
+    for (Event const& event : m_events)
+    {
+        if (event.type == viewport)
+        {
+            width = std::max(width, event.width);
+            height = std::max(height, event.height);
+        }
+    }
+}
+
+void
+Scenario::record_pose(double time_ms, CameraPose const& pose)
+{
+    Event const* last = last_event(Scenario::pose);
+    if (last && last->pose.translation == pose.translation
+        && last->pose.rotation == pose.rotation)
+    {
+        return;
+    }
+
+    Event event;
+    event.time_ms = time_ms;
+    event.type = Scenario::pose;
+    event.pose = pose;
+
+    append(event);
+}
+
+void
+Scenario::record_viewport(double time_ms, int width, int height)
+{
+    Event const* last = last_event(viewport);
+    if (last && last->width == width && last->height == height)
+    {
+        return;
+    }
+
+    Event event;
+    event.time_ms = time_ms;
+    event.type = viewport;
+    event.width = width;
+    event.height = height;
+
+    append(event);
+}
+
+void
+Scenario::record_settings(double time_ms, std::string const& settings)
+{
+    Event const* last = last_event(Scenario::settings);
+    if (last && last->settings == settings)
+    {
+        return;
+    }
+
+    Event event;
+    event.time_ms = time_ms;
+    event.type = Scenario::settings;
+    event.settings = settings;
+
+    append(event);
+}
+
+Scenario::State
+Scenario::state(double time_ms) const
+{
+    State state;
+
+    Event const* previous = nullptr;
+    Event const* next = nullptr;
+
+    for (Event const& event : m_events)
+    {
+        if (event.time_ms > time_ms)
+        {
+            if (event.type == pose)
+            {
+                next = &event;
+                break;
+            }
+
+            continue;
+        }
+
+        switch (event.type)
+        {
+            case pose:
+                previous = &event;
+                break;
+            case viewport:
+                state.width = event.width;
+                state.height = event.height;
+                break;
+            case settings:
+                state.settings = event.settings;
+                break;
+        }
+    }
+
+    if (previous && next)
+    {
+        float t = static_cast<float>((time_ms - previous->time_ms)
+            / (next->time_ms - previous->time_ms));
+        state.pose = interpolate_poses(previous->pose, next->pose, t);
+    }
+    else if (previous || next)
+    {
+        state.pose = previous ? previous->pose : next->pose;
+    }
+
+    return state;
+}
+
+double
+Scenario::frame_time(std::size_t i, std::size_t num_frames) const
+{
+    if (num_frames < 2)
+    {
+        return 0.0;
+    }
+
+    return duration_ms() * static_cast<double>(i)
+        / static_cast<double>(num_frames - 1);
+}
+
+void
+Scenario::load(std::string const& filename)
+{
+    std::ifstream input(filename);
+    if (!input.good())
+    {
+        throw std::runtime_error("Failed to open " + filename + ".");
+    }
+
+    m_events.clear();
+
+    std::string line;
+
+    for (unsigned int line_number(1); std::getline(input, line);
+        ++line_number)
+    {
+        std::istringstream tokens(line);
+
+        Event event;
+        std::string type;
+
+        if (!(tokens >> type) || type[0] == '#')
+        {
+            continue;
+        }
+
+        tokens.clear();
+        tokens.seekg(0);
+
+        bool valid = static_cast<bool>(tokens >> event.time_ms >> type)
+            && (m_events.empty() || event.time_ms >= m_events.back().time_ms);
+
+        if (valid && type == "pose")
+        {
+            Vector3f t;
+            Quaternionf q;
+            valid = static_cast<bool>(tokens >> t.x() >> t.y() >> t.z()
+                >> q.w() >> q.x() >> q.y() >> q.z());
+
+            event.type = pose;
+            event.pose.translation = t;
+            event.pose.rotation = q.normalized().toRotationMatrix();
+        }
+        else if (valid && type == "viewport")
+        {
+            valid = static_cast<bool>(tokens >> event.width >> event.height)
+                && event.width > 0 && event.height > 0;
+
+            event.type = viewport;
+        }
+        else if (valid && type == "settings")
+        {
+            // An empty list stands for the default settings.
+            tokens >> event.settings;
+
+            event.type = settings;
+        }
+        else
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            std::ostringstream message;
+            message << filename << "(" << line_number
+                << "): Expected 'time pose tx ty tz qw qx qy qz', "
+                "'time viewport width height' or 'time settings list' "
+                "with a nondecreasing time.";
+            throw std::runtime_error(message.str());
+        }
+
+        m_events.push_back(event);
+    }
+}
+
+void
+Scenario::save(std::string const& filename) const
+{
+    std::ofstream output(filename);
+    if (!output.good())
+    {
+        throw std::runtime_error("Failed to open " + filename + ".");
+    }
+
+    output << "# Surface Splatting scenario, times in milliseconds."
+        << std::endl;
+
+    for (Event const& event : m_events)
+    {
+        output << std::fixed << std::setprecision(3) << event.time_ms;
+
+        switch (event.type)
+        {
+            case pose:
+            {
+                Vector3f const& t = event.pose.translation;
+                Quaternionf q(event.pose.rotation);
+
+                output << " pose" << std::defaultfloat << std::setprecision(
+                    std::numeric_limits<float>::max_digits10)
+                    << " " << t.x() << " " << t.y() << " " << t.z()
+                    << " " << q.w() << " " << q.x() << " " << q.y()
+                    << " " << q.z();
+                break;
+            }
+            case viewport:
+                output << " viewport " << event.width << " " << event.height;
+                break;
+            case settings:
+                output << " settings " << event.settings;
+                break;
+        }
+
+        output << std::endl;
+    }
+
+    if (!output.good())
+    {
+        throw std::runtime_error("Failed to write " + filename + ".");
+    }
+}
+
+Scenario::Event const*
+Scenario::last_event(Type type) const
+{
+    for (auto it = m_events.rbegin(); it != m_events.rend(); ++it)
+    {
+        if (it->type == type)
+        {
+            return &*it;
+        }
+    }
+
+    return nullptr;
+}
+
+void
+Scenario::append(Event const& event)
+{
+    if (!m_events.empty() && event.time_ms < m_events.back().time_ms)
+    {
+        throw std::invalid_argument("Scenario events must not go back in "
+            "time.");
+    }
+
+    m_events.push_back(event);
+}
+
+FrameTiming::FrameTiming()
+    : frame(0), time_ms(0.0), frame_ms(0.0), width(0), height(0)
+{
+    std::fill(pass_ms, pass_ms + 3, 0.0f);
+}
+
+void
+write_frame_report(std::string const& filename,
+    std::vector<FrameTiming> const& frames)
+{
+    std::ofstream output(filename);
+    if (!output.good())
+    {
+        throw std::runtime_error("Failed to open " + filename + ".");
+    }
+
+    output << "frame,time_ms,width,height,frame_ms,visibility_ms,"
+        "attribute_ms,finalization_ms" << std::endl;
+
+    for (FrameTiming const& timing : frames)
+    {
+        output << timing.frame << "," << std::fixed << std::setprecision(3)
+            << timing.time_ms << "," << timing.width << "," << timing.height
+            << "," << timing.frame_ms << "," << timing.pass_ms[0] << ","
+            << timing.pass_ms[1] << "," << timing.pass_ms[2] << std::endl;
+    }
+
+    if (!output.good())
+    {
+        throw std::runtime_error("Failed to write " + filename + ".");
+    }
+}
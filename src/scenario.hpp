@@ -0,0 +1,125 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef SCENARIO_HPP
+#define SCENARIO_HPP
+
+#include "camera_path.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A scenario holds the camera poses, viewport sizes and renderer settings
+// of an interactive session, each with the time in milliseconds since the
+// start of the recording. Replaying it samples the session at a fixed
+// number of evenly spaced frames, independent of the frame rate at which
+// it was recorded.
+class Scenario
+{
+
+public:
+    struct State
+    {
+        State();
+
+        CameraPose pose;
+
+        // Zero unless a viewport has been recorded up to the time.
+        int width, height;
+
+        // Renderer settings as a comma-separated list, e.g. "smooth,ewa".
+        std::string settings;
+    };
+
+    Scenario();
+
+    // A scenario without camera poses cannot be replayed.
+    bool empty() const;
+    std::size_t num_events() const;
+    double duration_ms() const;
+
+    // Largest recorded viewport, or zero if none has been recorded.
+    void max_viewport(int& width, int& height) const;
+
+    // Records an event unless it equals the last one of its kind. The
+    // time must not decrease between events.
+    void record_pose(double time_ms, CameraPose const& pose);
+    void record_viewport(double time_ms, int width, int height);
+    void record_settings(double time_ms, std::string const& settings);
+
+    // Returns the state at a time. Poses are interpolated between events,
+    // viewports and settings hold until the next event.
+    State state(double time_ms) const;
+
+    // Returns the time of frame i of num_frames evenly spaced frames
+    // spanning the scenario.
+    double frame_time(std::size_t i, std::size_t num_frames) const;
+
+    // Reads and writes a text file with one event per line, either
+    // 'time pose tx ty tz qw qx qy qz', 'time viewport width height' or
+    // 'time settings list'. Lines starting with '#' are skipped.
+    void load(std::string const& filename);
+    void save(std::string const& filename) const;
+
+private:
+    enum Type
+    {
+        pose,
+        viewport,
+        settings
+    };
+
+    struct Event
+    {
+        double time_ms;
+        Type type;
+
+        CameraPose pose;
+        int width, height;
+        std::string settings;
+    };
+
+    Event const* last_event(Type type) const;
+    void append(Event const& event);
+
+private:
+    std::vector<Event> m_events;
+};
+
+// Timing of a replayed frame. The pass times are zero unless timed.
+struct FrameTiming
+{
+    FrameTiming();
+
+    std::size_t frame;
+    double time_ms, frame_ms;
+    int width, height;
+    float pass_ms[3];
+};
+
+// Writes a CSV report with one line per frame.
+void write_frame_report(std::string const& filename,
+    std::vector<FrameTiming> const& frames);
+
+#endif // SCENARIO_HPP
@@ -25,6 +25,8 @@
 #define VISIBILITY_PASS  0
 #define SMOOTH           0
 #define EWA_FILTER       0
+#define MULTIVIEW        0
+#define SPLAT_CLASS      0
 
 layout(std140, column_major) uniform Camera
 {
@@ -46,6 +48,7 @@ layout(std140) uniform Parameter
     float radius_scale;
     float ewa_radius;
     float epsilon;
+    float subpixel_size;
 };
 
 uniform sampler1D filter_kernel;
@@ -58,6 +61,10 @@ in block
     flat in vec3 p;
     flat in vec3 n_eye;
 
+    #if MULTIVIEW
+        flat in int view;
+    #endif
+
     #if !VISIBILITY_PASS
         #if EWA_FILTER
             flat in vec2 c_scr;
@@ -67,6 +74,22 @@ in block
 }
 In;
 
+#if MULTIVIEW
+    #define MAX_VIEWS 6
+
+    layout(std140, column_major) uniform MultiView
+    {
+        mat4 view_modelview_matrix[MAX_VIEWS];
+        mat4 view_projection_matrix[MAX_VIEWS];
+        mat4 view_projection_matrix_inv[MAX_VIEWS];
+        vec4 view_frustum_plane[6 * MAX_VIEWS];
+        int num_views;
+    };
+
+    #define projection_matrix view_projection_matrix[In.view]
+    #define projection_matrix_inv view_projection_matrix_inv[In.view]
+#endif
+
 #define FRAG_COLOR 0
 layout(location = FRAG_COLOR) out vec4 frag_color;
 
@@ -79,6 +102,23 @@ layout(location = FRAG_COLOR) out vec4 frag_color;
 
 void main()
 {
+#if SPLAT_CLASS == 2
+    // Sub-pixel splats skip the ray casting. Their fragments take the depth
+    // of the center, which also decides the clipping, and are weighted by
+    // the screen-space filter only.
+    if (In.p.z < 0.0)
+    {
+        discard;
+    }
+
+    float zval = In.c_eye.z;
+
+    #if !VISIBILITY_PASS && EWA_FILTER
+        float dist = distance(gl_FragCoord.xy, In.c_scr) / ewa_radius;
+    #else
+        float dist = 0.0;
+    #endif
+#else
     vec4 p_ndc = vec4(2.0 * (gl_FragCoord.xy - viewport.xy)
         / (viewport.zw) - 1.0, -1.0, 1.0);
     vec4 p_eye = projection_matrix_inv * p_ndc;
@@ -112,6 +152,7 @@ void main()
     #else
         float dist = w3d;
     #endif
+#endif
 
     if (dist > 1.0)
     {
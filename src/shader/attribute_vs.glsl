@@ -28,6 +28,16 @@
 #define COLOR_MATERIAL     0
 #define EWA_FILTER         0
 #define POINTSIZE_METHOD   0
+#define MULTIVIEW          0
+
+// Compiles this shader as the geometry shader of a multiview frame, which
+// splats each surfel into the layer of every view it is visible in. The
+// vertex shader of a multiview frame then only fetches the surfels.
+#define GEOMETRY_SHADER    0
+
+// 0: all splats, 1: splats larger than subpixel_size pixels,
+// 2: splats of at most subpixel_size pixels.
+#define SPLAT_CLASS        0
 
 layout(std140, column_major) uniform Camera
 {
@@ -54,22 +64,88 @@ layout(std140) uniform Parameter
     float radius_scale;
     float ewa_radius;
     float epsilon;
+    float subpixel_size;
 };
 
-#define ATTR_CENTER 0
-layout(location = ATTR_CENTER) in vec3 c;
+#if MULTIVIEW
+    // The geometry shader splats each surfel into the view current_view
+    // of all views in turn.
+    #define MAX_VIEWS 6
+
+    layout(std140, column_major) uniform MultiView
+    {
+        mat4 view_modelview_matrix[MAX_VIEWS];
+        mat4 view_projection_matrix[MAX_VIEWS];
+        mat4 view_projection_matrix_inv[MAX_VIEWS];
+        vec4 view_frustum_plane[6 * MAX_VIEWS];
+        int num_views;
+    };
+
+    int current_view;
+
+    #define modelview_matrix view_modelview_matrix[current_view]
+    #define projection_matrix view_projection_matrix[current_view]
+    #define projection_matrix_inv view_projection_matrix_inv[current_view]
+    #define FRUSTUM_PLANE(i) view_frustum_plane[6 * current_view + (i)]
+#else
+    #define FRUSTUM_PLANE(i) frustum_plane[i]
+#endif
+
+#if !GEOMETRY_SHADER
+    #define ATTR_CENTER 0
+    layout(location = ATTR_CENTER) in vec3 c;
+
+    #define ATTR_T1 1
+    layout(location = ATTR_T1) in vec3 u;
+
+    #define ATTR_T2 2
+    layout(location = ATTR_T2) in vec3 v;
+
+    #define ATTR_PLANE 3
+    layout(location = ATTR_PLANE) in vec3 p;
+
+    #define ATTR_COLOR 4
+    layout(location = ATTR_COLOR) in vec4 rgba;
+#endif
+
+#if MULTIVIEW && !GEOMETRY_SHADER
+
+// Each surfel is fetched once and passed on to the geometry shader.
+out Surfel
+{
+    vec3 c;
+    vec3 u;
+    vec3 v;
+    vec3 p;
+    vec4 rgba;
+}
+Out;
 
-#define ATTR_T1 1
-layout(location = ATTR_T1) in vec3 u;
+void main()
+{
+    Out.c = c;
+    Out.u = u;
+    Out.v = v;
+    Out.p = p;
+    Out.rgba = rgba;
+}
 
-#define ATTR_T2 2
-layout(location = ATTR_T2) in vec3 v;
+#else
 
-#define ATTR_PLANE 3
-layout(location = ATTR_PLANE) in vec3 p;
+#if GEOMETRY_SHADER
+    layout(points) in;
+    layout(points, max_vertices = MAX_VIEWS) out;
 
-#define ATTR_COLOR 4
-layout(location = ATTR_COLOR) in vec4 rgba;
+    in Surfel
+    {
+        vec3 c;
+        vec3 u;
+        vec3 v;
+        vec3 p;
+        vec4 rgba;
+    }
+    In[];
+#endif
 
 out block
 {
@@ -79,6 +155,10 @@ out block
     flat out vec3 p;
     flat out vec3 n_eye;
 
+    #if MULTIVIEW
+        flat out int view;
+    #endif
+
     #if !VISIBILITY_PASS
         #if EWA_FILTER
             flat out vec2 c_scr;
@@ -258,13 +338,13 @@ pointsprite(in vec3 c, in vec3 u, in vec3 v,
     // WHA+07.
     float r = max(length(u), length(v));
     vec3 pl = vec3(
-        dot(frustum_plane[0], vec4(c, 1.0)),
-        dot(frustum_plane[2], vec4(c, 1.0)),
-        dot(frustum_plane[4], vec4(c, 1.0)));
+        dot(FRUSTUM_PLANE(0), vec4(c, 1.0)),
+        dot(FRUSTUM_PLANE(2), vec4(c, 1.0)),
+        dot(FRUSTUM_PLANE(4), vec4(c, 1.0)));
     vec3 pr = vec3(
-        dot(frustum_plane[1], vec4(c, 1.0)),
-        dot(frustum_plane[3], vec4(c, 1.0)),
-        dot(frustum_plane[5], vec4(c, 1.0)));
+        dot(FRUSTUM_PLANE(1), vec4(c, 1.0)),
+        dot(FRUSTUM_PLANE(3), vec4(c, 1.0)),
+        dot(FRUSTUM_PLANE(5), vec4(c, 1.0)));
 
     bool t_lr = (pl.x + r) > 0.0 && (pr.x + r) > 0.0;
     bool t_bt = (pl.y + r) > 0.0 && (pr.y + r) > 0.0;
@@ -333,8 +413,18 @@ pointsprite(in vec3 c, in vec3 u, in vec3 v,
 #endif
 }
 
-void main()
+// Projects a splat and sets the outputs of its point sprite, or clips it
+// by a position with w = 0.
+void
+splat(vec3 c, vec3 u, vec3 v, vec3 p, vec4 rgba)
 {
+    // Removed surfels have zero tangent axes and are clipped.
+    if (u == vec3(0.0) && v == vec3(0.0))
+    {
+        gl_Position = vec4(1.0, 0.0, 0.0, 0.0);
+        return;
+    }
+
     vec4 c_eye = modelview_matrix * vec4(c, 1.0);
     vec3 u_eye = radius_scale * mat3(modelview_matrix) * u;
     vec3 v_eye = radius_scale * mat3(modelview_matrix) * v;
@@ -381,6 +471,23 @@ void main()
         float point_size = max(w[0] * viewport.z,
             w[1] * viewport.w) + 1.0;
 
+#if SPLAT_CLASS == 1
+        if (point_size <= subpixel_size + 1.0)
+        {
+            gl_Position = vec4(1.0, 0.0, 0.0, 0.0);
+        }
+#elif SPLAT_CLASS == 2
+        if (point_size > subpixel_size + 1.0)
+        {
+            gl_Position = vec4(1.0, 0.0, 0.0, 0.0);
+        }
+
+    #if VISIBILITY_PASS || !EWA_FILTER
+        // Without the screen-space filter a single fragment suffices.
+        point_size = 1.0;
+    #endif
+#endif
+
 #if !VISIBILITY_PASS && EWA_FILTER
         Out.c_scr = vec2((p_scr.xy + 1.0) * viewport.zw * 0.5);
         gl_PointSize = max(2.0, point_size);
@@ -396,3 +503,32 @@ void main()
     }
 #endif
 }
+
+#if GEOMETRY_SHADER
+
+void main()
+{
+    for (int i = 0; i < num_views; ++i)
+    {
+        current_view = i;
+        splat(In[0].c, In[0].u, In[0].v, In[0].p, In[0].rgba);
+
+        if (gl_Position.w != 0.0)
+        {
+            gl_Layer = i;
+            Out.view = i;
+            EmitVertex();
+        }
+    }
+}
+
+#else
+
+void main()
+{
+    splat(c, u, v, p, rgba);
+}
+
+#endif
+
+#endif
@@ -24,6 +24,7 @@
 
 #define MULTISAMPLING  0
 #define SMOOTH         0
+#define LAYERED        0
 
 layout(std140, column_major) uniform Camera
 {
@@ -45,10 +46,14 @@ layout(std140) uniform Parameter
     float radius_scale;
     float ewa_radius;
     float epsilon;
+    float subpixel_size;
 };
 
 #if MULTISAMPLING
     uniform sampler2DMS color_texture;
+#elif LAYERED
+    uniform sampler2DArray color_texture;
+    uniform int layer;
 #else
     uniform sampler2D color_texture;
 #endif
@@ -57,6 +62,9 @@ layout(std140) uniform Parameter
     #if MULTISAMPLING
         uniform sampler2DMS normal_texture;
         uniform sampler2DMS depth_texture;
+    #elif LAYERED
+        uniform sampler2DArray normal_texture;
+        uniform sampler2DArray depth_texture;
     #else
         uniform sampler2D normal_texture;
         uniform sampler2D depth_texture;
@@ -92,6 +100,14 @@ void main()
             );
         float depth = texelFetch(depth_texture, ivec2(itexture_uv), i).r;
         #endif
+    #elif LAYERED
+        vec3 texture_uvw = vec3(In.texture_uv, float(layer));
+        vec4 pixel = texture(color_texture, texture_uvw);
+
+        #if SMOOTH
+        vec3 normal = normalize(texture(normal_texture, texture_uvw).xyz);
+        float depth = texture(depth_texture, texture_uvw).r;
+        #endif
     #else
         vec4 pixel = texture(color_texture, In.texture_uv);
 
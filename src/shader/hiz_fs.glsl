@@ -0,0 +1,51 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#version 330
+
+// Reduces the depth of 2x2 texels of the finer level to their maximum,
+// i.e. the farthest visible depth. Texels beyond the odd border of the
+// finer level are ignored.
+uniform sampler2D depth_texture;
+
+#define FRAG_DEPTH 0
+layout(location = FRAG_DEPTH) out float frag_depth;
+
+void main()
+{
+    ivec2 p = 2 * ivec2(gl_FragCoord.xy);
+    ivec2 size = textureSize(depth_texture, 0);
+
+    float depth = texelFetch(depth_texture, p, 0).r;
+
+    for (int i = 1; i < 4; ++i)
+    {
+        ivec2 q = p + ivec2(i % 2, i / 2);
+
+        if (all(lessThan(q, size)))
+        {
+            depth = max(depth, texelFetch(depth_texture, q, 0).r);
+        }
+    }
+
+    frag_depth = depth;
+}
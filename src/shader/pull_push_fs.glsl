@@ -0,0 +1,160 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#version 330
+
+#define PUSH    0
+#define SMOOTH  0
+
+// Pull-push hole filling, see Grossman and Dally, Point Sample Rendering.
+//
+// The pull pass averages 2x2 pixels of the finer level. A level stores
+// the color, and with SMOOTH the normal and depth, premultiplied by the
+// coverage, i.e. the fraction of pixels with samples in its footprint.
+//
+// The push pass proceeds from the coarsest level to the finest. A pixel
+// with samples keeps its own average, an empty pixel takes the filled
+// value of its parent if the parent's coverage is at least min_coverage.
+// The latter keeps holes in the interior of surfaces apart from the
+// background at silhouettes.
+
+// Finest level: the accumulated attachments of the attribute pass.
+// Otherwise: the premultiplied values of the pull pass.
+uniform sampler2D color_texture;
+uniform bool first_level;
+
+#if SMOOTH
+    uniform sampler2D normal_texture;
+    uniform sampler2D depth_texture;
+#endif
+
+#if PUSH
+    // Filled values and premultiplied values of the next coarser level.
+    uniform sampler2D coarse_color_texture;
+    uniform sampler2D coarse_coverage_texture;
+    uniform bool last_level;
+    uniform float min_coverage;
+
+    #if SMOOTH
+        uniform sampler2D coarse_normal_texture;
+    #endif
+#endif
+
+#define FRAG_COLOR 0
+layout(location = FRAG_COLOR) out vec4 frag_color;
+
+#if SMOOTH
+    #define FRAG_NORMAL 1
+    layout(location = FRAG_NORMAL) out vec4 frag_normal;
+
+    #if PUSH
+        #define FRAG_DEPTH 2
+        layout(location = FRAG_DEPTH) out float frag_depth;
+    #endif
+#endif
+
+void fetch(in ivec2 p, out vec4 color, out vec4 normal)
+{
+    color = vec4(0.0);
+    normal = vec4(0.0);
+
+    if (any(greaterThanEqual(p, textureSize(color_texture, 0))))
+    {
+        return;
+    }
+
+    vec4 pixel = texelFetch(color_texture, p, 0);
+
+    if (first_level)
+    {
+        if (pixel.a > 0.0)
+        {
+            color = vec4(pixel.rgb / pixel.a, 1.0);
+
+            #if SMOOTH
+                normal = vec4(normalize(texelFetch(normal_texture, p, 0).xyz),
+                    texelFetch(depth_texture, p, 0).r);
+            #endif
+        }
+    }
+    else
+    {
+        color = pixel;
+
+        #if SMOOTH
+            normal = texelFetch(normal_texture, p, 0);
+        #endif
+    }
+}
+
+void main()
+{
+    ivec2 p = ivec2(gl_FragCoord.xy);
+
+#if PUSH
+    vec4 color, normal;
+    fetch(p, color, normal);
+
+    vec4 res_color = vec4(0.0);
+    vec4 res_normal = vec4(0.0, 0.0, 1.0, 1.0);
+
+    if (color.a > 0.0)
+    {
+        res_color = vec4(color.rgb / color.a, 1.0);
+        res_normal = normal / color.a;
+    }
+    else if (!last_level && texelFetch(coarse_coverage_texture, p / 2, 0).a
+        >= min_coverage)
+    {
+        res_color = texelFetch(coarse_color_texture, p / 2, 0);
+
+        #if SMOOTH
+            res_normal = texelFetch(coarse_normal_texture, p / 2, 0);
+        #endif
+    }
+
+    frag_color = res_color;
+
+    #if SMOOTH
+        frag_normal = vec4(normalize(res_normal.xyz), res_normal.w);
+        frag_depth = res_normal.w;
+    #endif
+#else
+    vec4 sum_color = vec4(0.0);
+    vec4 sum_normal = vec4(0.0);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        vec4 color, normal;
+        fetch(2 * p + ivec2(i % 2, i / 2), color, normal);
+
+        sum_color += color;
+        sum_normal += normal;
+    }
+
+    frag_color = 0.25 * sum_color;
+
+    #if SMOOTH
+        frag_normal = 0.25 * sum_normal;
+    #endif
+#endif
+}
@@ -0,0 +1,145 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "slot_allocator.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+SlotAllocator::SlotAllocator()
+    : m_end(0), m_free_slots(0)
+{
+}
+
+void
+SlotAllocator::reset(std::size_t used)
+{
+    m_free.clear();
+    m_end = used;
+    m_free_slots = 0;
+}
+
+void
+SlotAllocator::allocate(std::size_t count, std::vector<Range>& ranges)
+{
+    while (count > 0 && !m_free.empty())
+    {
+        auto it = m_free.begin();
+        std::size_t n = std::min(count, it->second);
+
+        ranges.push_back(Range(it->first, n));
+
+        if (n < it->second)
+        {
+            m_free[it->first + n] = it->second - n;
+        }
+
+        m_free.erase(it);
+        m_free_slots -= n;
+        count -= n;
+    }
+
+    if (count > 0)
+    {
+        ranges.push_back(Range(m_end, count));
+        m_end += count;
+    }
+}
+
+void
+SlotAllocator::free(std::size_t first, std::size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    std::size_t last = first + count;
+
+    // Coalesce with the adjacent free ranges.
+    auto next = m_free.lower_bound(first);
+    if (next != m_free.end() && next->first == last)
+    {
+        last += next->second;
+        m_free_slots -= next->second;
+        next = m_free.erase(next);
+    }
+
+    if (next != m_free.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == first)
+        {
+            first = previous->first;
+            m_free_slots -= previous->second;
+            m_free.erase(previous);
+        }
+    }
+
+    // Free slots at the end lower the end instead.
+    if (last == m_end)
+    {
+        m_end = first;
+    }
+    else
+    {
+        m_free[first] = last - first;
+        m_free_slots += last - first;
+    }
+}
+
+bool
+SlotAllocator::compact(std::size_t max_count, std::size_t& from,
+    std::size_t& to, std::size_t& count)
+{
+    if (m_free.empty() || max_count == 0)
+    {
+        return false;
+    }
+
+    // The last used run starts after the last free range.
+    auto last_free = std::prev(m_free.end());
+    std::size_t run_first = last_free->first + last_free->second;
+
+    count = std::min(std::min(max_count, m_free.begin()->second),
+        m_end - run_first);
+    to = m_free.begin()->first;
+    from = m_end - count;
+
+    std::vector<Range> ranges;
+    allocate(count, ranges);
+    free(from, count);
+
+    return true;
+}
+
+std::size_t
+SlotAllocator::end() const
+{
+    return m_end;
+}
+
+std::size_t
+SlotAllocator::free_slots() const
+{
+    return m_free_slots;
+}
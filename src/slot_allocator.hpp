@@ -0,0 +1,65 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef SLOT_ALLOCATOR_HPP
+#define SLOT_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+// Free-list allocator of the slots of a buffer. Free slots below the end,
+// i.e. one past the last used slot, are kept as coalesced ranges ordered by
+// their position.
+class SlotAllocator
+{
+
+public:
+    typedef std::pair<std::size_t, std::size_t> Range;
+
+    SlotAllocator();
+
+    // Marks the slots [0, used) as used and all others as free.
+    void reset(std::size_t used);
+
+    // Allocates count slots from the free ranges in order and then from
+    // the end. Appends the allocated (first, count) ranges to ranges.
+    void allocate(std::size_t count, std::vector<Range>& ranges);
+
+    void free(std::size_t first, std::size_t count);
+
+    // Plans moving up to max_count of the last used slots into the first
+    // free range and updates the allocation accordingly. Returns false if
+    // there is no free slot below the end.
+    bool compact(std::size_t max_count, std::size_t& from, std::size_t& to,
+        std::size_t& count);
+
+    std::size_t end() const;
+    std::size_t free_slots() const;
+
+private:
+    std::map<std::size_t, std::size_t> m_free;
+    std::size_t m_end, m_free_slots;
+};
+
+#endif // SLOT_ALLOCATOR_HPP
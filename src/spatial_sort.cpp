@@ -0,0 +1,179 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "spatial_sort.hpp"
+#include "parallel.hpp"
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+using namespace Eigen;
+
+namespace
+{
+
+std::uint64_t
+spread_bits(std::uint32_t x)
+{
+    std::uint64_t v = x & 0x1fffff;
+
+    v = (v | v << 32) & 0x1f00000000ffffull;
+    v = (v | v << 16) & 0x1f0000ff0000ffull;
+    v = (v | v << 8)  & 0x100f00f00f00f00full;
+    v = (v | v << 4)  & 0x10c30c30c30c30c3ull;
+    v = (v | v << 2)  & 0x1249249249249249ull;
+
+    return v;
+}
+
+// Index of the dominant axis and sign of a normal in [0, 6).
+unsigned int
+normal_class(Surfel const& surfel)
+{
+    Vector3f n = surfel.u.cross(surfel.v);
+
+    unsigned int axis;
+    n.cwiseAbs().maxCoeff(&axis);
+
+    return 2 * axis + (n[axis] < 0.0f ? 1 : 0);
+}
+
+}
+
+std::uint64_t
+morton_code(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+{
+    return spread_bits(x) | (spread_bits(y) << 1) | (spread_bits(z) << 2);
+}
+
+void
+morton_sort(std::vector<Surfel>& surfels, bool by_normal,
+    unsigned int num_threads)
+{
+    num_threads = hardware_threads(num_threads);
+
+    std::size_t const n = surfels.size();
+
+    if (n < 2)
+    {
+        return;
+    }
+
+    // Bounding box of the centers, one per chunk.
+    std::vector<AlignedBox3f> boxes(num_threads);
+
+    parallel_for(num_threads, num_threads, [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; ++i)
+        {
+            for (std::size_t j = i * n / num_threads;
+                j < (i + 1) * n / num_threads; ++j)
+            {
+                boxes[i].extend(surfels[j].c);
+            }
+        }
+    });
+
+    AlignedBox3f box;
+    for (auto const& b : boxes)
+    {
+        box.extend(b);
+    }
+
+    // Quantize centers to 21 bits per axis, or to 20 bits per axis with the
+    // normal class in the upper bits of the key.
+    unsigned int const bits = by_normal ? 20 : 21;
+    float const cells = static_cast<float>((1u << bits) - 1);
+
+    Vector3f extent = box.sizes().cwiseMax(Vector3f::Constant(
+        std::numeric_limits<float>::min()));
+    Vector3f scale = Vector3f::Constant(cells).cwiseQuotient(extent);
+
+    std::vector<std::pair<std::uint64_t, std::size_t>> keys(n);
+
+    parallel_for(n, num_threads,
+        [&](std::size_t b, std::size_t e) {
+            for (std::size_t j = b; j < e; ++j)
+            {
+                Vector3f q = (surfels[j].c - box.min()).cwiseProduct(scale);
+
+                std::uint64_t key = morton_code(
+                    static_cast<std::uint32_t>(q.x()),
+                    static_cast<std::uint32_t>(q.y()),
+                    static_cast<std::uint32_t>(q.z()));
+
+                if (by_normal)
+                {
+                    key |= static_cast<std::uint64_t>(
+                        normal_class(surfels[j])) << 60;
+                }
+
+                keys[j] = std::make_pair(key, j);
+            }
+        });
+
+    // Sort chunks in parallel and merge pairs of sorted runs.
+    std::size_t const num_chunks = num_threads;
+
+    parallel_for(num_chunks, num_threads,
+        [&](std::size_t b, std::size_t e) {
+            for (std::size_t i = b; i < e; ++i)
+            {
+                std::sort(keys.begin() + i * n / num_chunks,
+                    keys.begin() + (i + 1) * n / num_chunks);
+            }
+        });
+
+    for (std::size_t width(1); width < num_chunks; width *= 2)
+    {
+        std::size_t const num_merges = (num_chunks + 2 * width - 1)
+            / (2 * width);
+
+        parallel_for(num_merges, num_threads,
+            [&](std::size_t b, std::size_t e) {
+                for (std::size_t i = b; i < e; ++i)
+                {
+                    std::size_t c0 = 2 * i * width;
+                    std::size_t c1 = std::min(c0 + width, num_chunks);
+                    std::size_t c2 = std::min(c0 + 2 * width, num_chunks);
+
+                    std::inplace_merge(keys.begin() + c0 * n / num_chunks,
+                        keys.begin() + c1 * n / num_chunks,
+                        keys.begin() + c2 * n / num_chunks);
+                }
+            });
+    }
+
+    std::vector<Surfel> sorted(n);
+
+    parallel_for(n, num_threads,
+        [&](std::size_t b, std::size_t e) {
+            for (std::size_t j = b; j < e; ++j)
+            {
+                sorted[j] = surfels[keys[j].second];
+            }
+        });
+
+    surfels.swap(sorted);
+}
@@ -0,0 +1,43 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef SPATIAL_SORT_HPP
+#define SPATIAL_SORT_HPP
+
+#include "surfel.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Interleaves the lower 21 bits of three integers, i.e. computes the index
+// of a grid cell along the Morton (Z-order) curve.
+std::uint64_t morton_code(std::uint32_t x, std::uint32_t y, std::uint32_t z);
+
+// Reorders surfels along a Morton curve through their centers, such that
+// consecutive surfels are close in space and hence on screen. If by_normal
+// is set, surfels are grouped by the dominant axis and sign of their
+// normal first. The sort is performed by the given number of threads, zero
+// uses all hardware threads.
+void morton_sort(std::vector<Surfel>& surfels, bool by_normal = false,
+    unsigned int num_threads = 0);
+
+#endif // SPATIAL_SORT_HPP
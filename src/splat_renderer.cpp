@@ -25,11 +25,80 @@
 #include <GLviz/glviz.hpp>
 #include <GLviz/utility.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
 #include <cmath>
 
 using namespace Eigen;
 
+namespace
+{
+
+// Returns the time since begin in milliseconds.
+double
+elapsed_ms(std::chrono::steady_clock::time_point begin)
+{
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - begin;
+
+    return elapsed.count();
+}
+
+void
+set_frustum_planes(Matrix4f const& projection_matrix,
+    Vector4f* frustum_plane)
+{
+    for (unsigned int i(0); i < 6; ++i)
+    {
+        frustum_plane[i] = projection_matrix.row(3) + (-1.0f + 2.0f
+            * static_cast<float>(i % 2)) * projection_matrix.row(i / 2);
+    }
+    
+    for (unsigned int i(0); i < 6; ++i)
+    {
+        frustum_plane[i] = (1.0f / frustum_plane[i].block<3, 1>(
+            0, 0).norm()) * frustum_plane[i];
+    }
+}
+
+// Tests whether a box intersects the frustum given by its planes, see
+// set_frustum_planes().
+bool
+intersects_frustum(AlignedBox3f const& box, Vector4f const* frustum_plane)
+{
+    for (unsigned int i(0); i < 6; ++i)
+    {
+        // Corner of the box farthest along the plane normal.
+        Vector3f p;
+        for (unsigned int j(0); j < 3; ++j)
+        {
+            p[j] = frustum_plane[i][j] >= 0.0f ? box.max()[j]
+                : box.min()[j];
+        }
+
+        if (frustum_plane[i].head<3>().dot(p) + frustum_plane[i].w() < 0.0f)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::size_t const no_index = std::numeric_limits<std::size_t>::max();
+
+// Streamed part of a surfel.
+struct SurfelMotion
+{
+    Vector3f c, u, v;
+};
+
+}
+
 UniformBufferRaycast::UniformBufferRaycast()
     : glUniformBuffer(sizeof(Matrix4f) + sizeof(Vector4f))
 {
@@ -68,6 +137,47 @@ UniformBufferFrustum::set_buffer_data(Vector4f const* frustum_plane)
     unbind();
 }
 
+UniformBufferMultiView::UniformBufferMultiView()
+    : glUniformBuffer(max_views * (3 * sizeof(Matrix4f)
+        + 6 * sizeof(Vector4f)) + sizeof(Vector4f))
+{
+}
+
+void
+UniformBufferMultiView::set_buffer_data(
+    std::vector<GLviz::Camera> const& views)
+{
+    GLsizeiptr const matrix_array_size = max_views * sizeof(Matrix4f);
+
+    bind();
+    for (std::size_t i(0); i < views.size() && i < max_views; ++i)
+    {
+        Matrix4f const& projection_matrix = views[i].get_projection_matrix();
+        Matrix4f modelview_matrix = views[i].get_modelview_matrix();
+        Matrix4f projection_matrix_inv = projection_matrix.inverse();
+
+        Vector4f frustum_plane[6];
+        set_frustum_planes(projection_matrix, frustum_plane);
+
+        GLintptr offset = i * sizeof(Matrix4f);
+        glBufferSubData(GL_UNIFORM_BUFFER, offset,
+            sizeof(Matrix4f), modelview_matrix.data());
+        glBufferSubData(GL_UNIFORM_BUFFER, matrix_array_size + offset,
+            sizeof(Matrix4f), projection_matrix.data());
+        glBufferSubData(GL_UNIFORM_BUFFER, 2 * matrix_array_size + offset,
+            sizeof(Matrix4f), projection_matrix_inv.data());
+        glBufferSubData(GL_UNIFORM_BUFFER, 3 * matrix_array_size
+            + i * 6 * sizeof(Vector4f), 6 * sizeof(Vector4f),
+            static_cast<void const*>(frustum_plane));
+    }
+
+    GLint num_views = static_cast<GLint>(std::min(views.size(),
+        static_cast<std::size_t>(max_views)));
+    glBufferSubData(GL_UNIFORM_BUFFER, max_views * (3 * sizeof(Matrix4f)
+        + 6 * sizeof(Vector4f)), sizeof(GLint), &num_views);
+    unbind();
+}
+
 UniformBufferParameter::UniformBufferParameter()
     : glUniformBuffer(8 * sizeof(float))
 {
@@ -75,7 +185,7 @@ UniformBufferParameter::UniformBufferParameter()
 
 void
 UniformBufferParameter::set_buffer_data(Vector3f const& color, float shininess,
-    float radius_scale, float ewa_radius, float epsilon)
+    float radius_scale, float ewa_radius, float epsilon, float subpixel_size)
 {
     bind();
     glBufferSubData(GL_UNIFORM_BUFFER, 0, 3 * sizeof(float), color.data());
@@ -83,38 +193,81 @@ UniformBufferParameter::set_buffer_data(Vector3f const& color, float shininess,
     glBufferSubData(GL_UNIFORM_BUFFER, 16, sizeof(float), &radius_scale);
     glBufferSubData(GL_UNIFORM_BUFFER, 20, sizeof(float), &ewa_radius);
     glBufferSubData(GL_UNIFORM_BUFFER, 24, sizeof(float), &epsilon);
+    glBufferSubData(GL_UNIFORM_BUFFER, 28, sizeof(float), &subpixel_size);
     unbind();
 }
 
+const std::size_t SplatRenderer::page_size;
+const std::size_t SplatRenderer::cluster_size;
+
+SplatRenderer::PagingStatistics::PagingStatistics()
+    : num_pages(0), resident_pages(0), visible_pages(0), drawn_pages(0),
+      budget_bytes(0), num_buffers(0), uploaded_pages(0), uploaded_bytes(0),
+      evicted_pages(0), frame_uploaded_pages(0)
+{
+}
+
+SplatRenderer::EditingStatistics::EditingStatistics()
+    : num_surfels(0), used_slots(0), free_slots(0), capacity(0),
+      moved_surfels(0)
+{
+}
+
+SplatRenderer::CullingStatistics::CullingStatistics()
+    : tested_clusters(0), occluded_clusters(0)
+{
+}
+
+SplatRenderer::FrameStatistics::FrameStatistics()
+    : upload_ms(0.0), uniforms_ms(0.0), visibility_ms(0.0),
+      attribute_ms(0.0), submitted_surfels(0), culled_surfels(0), width(0),
+      height(0)
+{
+}
+
+SplatRenderer::FramePlan::FramePlan()
+    : visible_pages(0), revision(0)
+{
+}
 
 SplatRenderer::SplatRenderer(GLviz::Camera const& camera)
-    : m_camera(camera), m_soft_zbuffer(true), m_smooth(false),
+    : m_camera(camera), m_chunk_slots(0), m_max_buffer_size(1 << 30),
+      m_num_pts(0), m_capacity(0),
+      m_compaction_rate(65536), m_moved_surfels(0), m_geometry(nullptr),
+      m_memory_budget(0), m_frame(0), m_revision(0),
+      m_occlusion_culling(false),
+      m_occlusion_culled(false), m_target_fbo(0),
+      m_tile_matrix(Matrix4f::Identity()), m_hole_filling(0),
+      m_soft_zbuffer(true), m_smooth(false),
       m_color_material(true), m_ewa_filter(false), m_multisample(false),
       m_pointsize_method(0), m_backface_culling(false),
       m_color(Vector3f(0.0, 0.25f, 1.0f)), m_epsilon(1.0f * 1e-3f),
-      m_shininess(8.0f), m_radius_scale(1.0f), m_ewa_radius(1.0f)
+      m_shininess(8.0f), m_radius_scale(1.0f), m_ewa_radius(1.0f),
+      m_subpixel_size(0.0f),
+      m_pass_timing(false), m_timed_frame(false), m_timed_frames(0),
+      m_pending_timer_frames(0)
 {
-    m_uniform_camera.bind_buffer_base(0);
-    m_uniform_raycast.bind_buffer_base(1);
-    m_uniform_frustum.bind_buffer_base(2);
-    m_uniform_parameter.bind_buffer_base(3);
-
     setup_program_objects();
     setup_filter_kernel();
     setup_screen_size_quad();
-    setup_vertex_array_buffer_object();
+    allocate_chunks(0);
+
+    glGenQueries(3 * num_timer_frames, m_timer_queries[0]);
+    std::fill(m_timer_used[0], m_timer_used[0] + 3 * num_timer_frames,
+        false);
 }
 
 SplatRenderer::~SplatRenderer()
 {
-    glDeleteVertexArrays(1, &m_vao);
-    glDeleteBuffers(1, &m_vbo);
+    release_chunks();
 
     glDeleteBuffers(1, &m_rect_vertices_vbo);
     glDeleteBuffers(1, &m_rect_texture_uv_vbo);
     glDeleteVertexArrays(1, &m_rect_vao);
 
     glDeleteTextures(1, &m_filter_kernel);
+
+    glDeleteQueries(3 * num_timer_frames, m_timer_queries[0]);
 }
 
 void
@@ -131,8 +284,23 @@ SplatRenderer::setup_program_objects()
     m_attribute.set_ewa_filter(m_ewa_filter);
     m_attribute.set_smooth(m_smooth);
 
+    m_visibility_subpixel.set_visibility_pass();
+    m_visibility_subpixel.set_pointsize_method(m_pointsize_method);
+    m_visibility_subpixel.set_backface_culling(m_backface_culling);
+    m_visibility_subpixel.set_splat_class(2);
+
+    m_attribute_subpixel.set_visibility_pass(false);
+    m_attribute_subpixel.set_pointsize_method(m_pointsize_method);
+    m_attribute_subpixel.set_backface_culling(m_backface_culling);
+    m_attribute_subpixel.set_color_material(m_color_material);
+    m_attribute_subpixel.set_ewa_filter(m_ewa_filter);
+    m_attribute_subpixel.set_smooth(m_smooth);
+    m_attribute_subpixel.set_splat_class(2);
+
     m_finalization.set_multisampling(m_multisample);
     m_finalization.set_smooth(m_smooth);
+
+    m_pull_push.set_smooth(m_smooth);
 }
 
 inline void
@@ -202,29 +370,20 @@ SplatRenderer::setup_screen_size_quad()
 }
 
 void
-SplatRenderer::setup_vertex_array_buffer_object()
+SplatRenderer::setup_vertex_array_buffer_object(std::size_t first_slot,
+    std::size_t num_slots, std::size_t bytes, GLenum usage)
 {
-    glGenBuffers(1, &m_vbo);
-
-    glGenVertexArrays(1, &m_vao);
-    glBindVertexArray(m_vao);
+    Chunk chunk;
+    chunk.first_slot = first_slot;
+    chunk.num_slots = num_slots;
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-
-    // Center c.
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
-        sizeof(Surfel), reinterpret_cast<const GLfloat*>(0));
+    glGenBuffers(1, &chunk.vbo);
 
-    // Tagent vector u.
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,
-        sizeof(Surfel), reinterpret_cast<const GLfloat*>(12));
+    glGenVertexArrays(1, &chunk.vao);
+    glBindVertexArray(chunk.vao);
 
-    // Tangent vector v.
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE,
-        sizeof(Surfel), reinterpret_cast<const GLfloat*>(24));
+    glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+    glBufferData(GL_ARRAY_BUFFER, bytes, NULL, usage);
 
     // Clipping plane p.
     glEnableVertexAttribArray(3);
@@ -237,6 +396,106 @@ SplatRenderer::setup_vertex_array_buffer_object()
         sizeof(Surfel), reinterpret_cast<const GLbyte*>(48));
 
     glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_chunks.push_back(chunk);
+}
+
+void
+SplatRenderer::setup_center_tangent_attributes()
+{
+    for (auto const& chunk : m_chunks)
+    {
+        // Streamed geometry is read from the current region.
+        GLuint buffer = chunk.vbo;
+        GLsizei stride = sizeof(Surfel);
+        std::size_t offset(0);
+
+        if (m_stream.buffer() != 0)
+        {
+            buffer = m_stream.buffer();
+            stride = sizeof(SurfelMotion);
+            offset = m_stream.region() * m_stream.region_bytes();
+        }
+
+        glBindVertexArray(chunk.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+        // Center c.
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
+            stride, reinterpret_cast<const GLbyte*>(offset));
+
+        // Tagent vector u.
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,
+            stride, reinterpret_cast<const GLbyte*>(offset + 12));
+
+        // Tangent vector v.
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE,
+            stride, reinterpret_cast<const GLbyte*>(offset + 24));
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool
+SplatRenderer::allocate_chunks(std::size_t num_slots)
+{
+    release_chunks();
+
+    std::size_t const page_bytes = page_size * sizeof(Surfel);
+    bool resident = num_slots == m_pages.size();
+
+    // Each buffer object holds whole pages and fewer than 2^31 surfels,
+    // such that draw offsets within it fit into a GLint.
+    m_chunk_slots = std::max<std::size_t>(1, std::min<std::size_t>(
+        m_max_buffer_size / page_bytes,
+        std::numeric_limits<GLint>::max() / page_size));
+
+    while (glGetError() != GL_NO_ERROR)
+    {
+    }
+
+    // Buffer objects of resident geometry are sized to it.
+    std::size_t first(0);
+    do
+    {
+        std::size_t count = std::min(m_chunk_slots, num_slots - first);
+        std::size_t bytes = resident ? (std::min(m_num_pts, (first + count)
+            * page_size) - first * page_size) * sizeof(Surfel)
+            : count * page_bytes;
+
+        setup_vertex_array_buffer_object(first, count, bytes, resident
+            ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
+
+        if (glGetError() == GL_OUT_OF_MEMORY)
+        {
+            release_chunks();
+            return false;
+        }
+
+        first += count;
+    }
+    while (first < num_slots);
+
+    setup_center_tangent_attributes();
+
+    return true;
+}
+
+void
+SplatRenderer::release_chunks()
+{
+    for (auto const& chunk : m_chunks)
+    {
+        glDeleteVertexArrays(1, &chunk.vao);
+        glDeleteBuffers(1, &chunk.vbo);
+    }
+
+    m_chunks.clear();
 }
 
 bool
@@ -253,7 +512,9 @@ SplatRenderer::set_smooth(bool enable)
         m_smooth = enable;
 
         m_attribute.set_smooth(enable);
+        m_attribute_subpixel.set_smooth(enable);
         m_finalization.set_smooth(enable);
+        m_pull_push.set_smooth(enable);
 
         if (m_smooth)
         {
@@ -281,6 +542,7 @@ SplatRenderer::set_color_material(bool enable)
     {
         m_color_material = enable;
         m_attribute.set_color_material(enable);
+        m_attribute_subpixel.set_color_material(enable);
     }
 }
 
@@ -298,6 +560,8 @@ SplatRenderer::set_backface_culling(bool enable)
         m_backface_culling = enable;
         m_visibility.set_backface_culling(enable);
         m_attribute.set_backface_culling(enable);
+        m_visibility_subpixel.set_backface_culling(enable);
+        m_attribute_subpixel.set_backface_culling(enable);
     }
 }
 
@@ -316,6 +580,7 @@ SplatRenderer::set_soft_zbuffer(bool enable)
         {
             m_ewa_filter = false;
             m_attribute.set_ewa_filter(false);
+            m_attribute_subpixel.set_ewa_filter(false);
         }
 
         m_soft_zbuffer = enable;
@@ -348,6 +613,8 @@ SplatRenderer::set_pointsize_method(unsigned int pointsize_method)
         m_pointsize_method = pointsize_method;
         m_visibility.set_pointsize_method(pointsize_method);
         m_attribute.set_pointsize_method(pointsize_method);
+        m_visibility_subpixel.set_pointsize_method(pointsize_method);
+        m_attribute_subpixel.set_pointsize_method(pointsize_method);
     }
 }
 
@@ -364,6 +631,7 @@ SplatRenderer::set_ewa_filter(bool enable)
     {
         m_ewa_filter = enable;
         m_attribute.set_ewa_filter(enable);
+        m_attribute_subpixel.set_ewa_filter(enable);
     }
 }
 
@@ -418,7 +686,13 @@ SplatRenderer::radius_scale() const
 void
 SplatRenderer::set_radius_scale(float radius_scale)
 {
-    m_radius_scale = radius_scale;
+    std::lock_guard<std::mutex> lock(m_plan_mutex);
+
+    if (m_radius_scale != radius_scale)
+    {
+        m_radius_scale = radius_scale;
+        ++m_revision;
+    }
 }
 
 float
@@ -433,49 +707,180 @@ SplatRenderer::set_ewa_radius(float ewa_radius)
     m_ewa_radius = ewa_radius;
 }
 
+float
+SplatRenderer::subpixel_size() const
+{
+    return m_subpixel_size;
+}
+
+void
+SplatRenderer::set_subpixel_size(float pixels)
+{
+    m_subpixel_size = pixels;
+
+    m_visibility.set_splat_class(pixels > 0.0f ? 1 : 0);
+    m_attribute.set_splat_class(pixels > 0.0f ? 1 : 0);
+}
+
+unsigned int
+SplatRenderer::hole_filling() const
+{
+    return m_hole_filling;
+}
+
+void
+SplatRenderer::set_hole_filling(unsigned int levels)
+{
+    m_hole_filling = levels;
+
+    if (levels > 0)
+    {
+        m_pull_push.set_levels(levels);
+    }
+}
+
 void
 SplatRenderer::reshape(int width, int height)
 {
     m_fbo.reshape(width, height);
 }
 
+bool
+SplatRenderer::pass_timing() const
+{
+    return m_pass_timing;
+}
+
 void
-SplatRenderer::setup_uniforms(glProgram& program)
+SplatRenderer::set_pass_timing(bool enable)
 {
-    m_uniform_camera.set_buffer_data(m_camera);
-    
-    GLint viewport[4];
-    glGetIntegerv(GL_VIEWPORT, viewport);
-    GLviz::Frustum view_frustum = m_camera.get_frustum();
-        
-    m_uniform_raycast.set_buffer_data(
-        m_camera.get_projection_matrix().inverse(),
-        viewport);
+    m_pass_timing = enable;
+}
+
+void
+SplatRenderer::pass_times(float* milliseconds) const
+{
+    if (m_timed_frames == 0)
+    {
+        std::fill(milliseconds, milliseconds + 3, 0.0f);
+        return;
+    }
+
+    read_timer_queries((m_timed_frames - 1) % num_timer_frames,
+        milliseconds);
+}
 
-    Vector4f frustum_plane[6];
+std::size_t
+SplatRenderer::timed_frames() const
+{
+    return m_timed_frames;
+}
 
-    Matrix4f const& projection_matrix = m_camera.get_projection_matrix();
-    for (unsigned int i(0); i < 6; ++i)
+bool
+SplatRenderer::poll_pass_times(std::size_t& frame, float* milliseconds,
+    bool wait)
+{
+    if (m_pending_timer_frames == 0)
     {
-        frustum_plane[i] = projection_matrix.row(3) + (-1.0f + 2.0f
-            * static_cast<float>(i % 2)) * projection_matrix.row(i / 2);
+        return false;
     }
-    
-    for (unsigned int i(0); i < 6; ++i)
+
+    frame = m_timed_frames - m_pending_timer_frames;
+    unsigned int slot = frame % num_timer_frames;
+
+    for (unsigned int i(0); i < 3 && !wait; ++i)
     {
-        frustum_plane[i] = (1.0f / frustum_plane[i].block<3, 1>(
-            0, 0).norm()) * frustum_plane[i];
+        GLuint available(GL_TRUE);
+
+        if (m_timer_used[slot][i])
+        {
+            glGetQueryObjectuiv(m_timer_queries[slot][i],
+                GL_QUERY_RESULT_AVAILABLE, &available);
+        }
+
+        if (!available)
+        {
+            return false;
+        }
+    }
+
+    read_timer_queries(slot, milliseconds);
+    --m_pending_timer_frames;
+
+    return true;
+}
+
+void
+SplatRenderer::read_timer_queries(unsigned int slot,
+    float* milliseconds) const
+{
+    for (unsigned int i(0); i < 3; ++i)
+    {
+        GLuint64 elapsed(0);
+
+        if (m_timer_used[slot][i])
+        {
+            glGetQueryObjectui64v(m_timer_queries[slot][i], GL_QUERY_RESULT,
+                &elapsed);
+        }
+
+        milliseconds[i] = static_cast<float>(elapsed) * 1e-6f;
+    }
+}
+
+void
+SplatRenderer::begin_timer(unsigned int pass)
+{
+    if (m_timed_frame)
+    {
+        unsigned int slot = (m_timed_frames - 1) % num_timer_frames;
+
+        glBeginQuery(GL_TIME_ELAPSED, m_timer_queries[slot][pass]);
+        m_timer_used[slot][pass] = true;
+    }
+}
+
+void
+SplatRenderer::end_timer()
+{
+    if (m_timed_frame)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
     }
+}
+
+void
+SplatRenderer::setup_uniforms(glProgram& program, View const& view)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    m_uniform_camera.set_buffer_data(view.camera);
 
-    m_uniform_frustum.set_buffer_data(frustum_plane);
+    // A tile replaces the projection matrix of the camera block.
+    if (!m_tile_matrix.isIdentity())
+    {
+        m_uniform_camera.bind();
+        glBufferSubData(GL_UNIFORM_BUFFER, 2 * sizeof(Matrix4f),
+            sizeof(Matrix4f), view.projection_matrix.data());
+        m_uniform_camera.unbind();
+    }
+    
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+        
+    m_uniform_raycast.set_buffer_data(view.projection_matrix_inv, viewport);
+    m_uniform_frustum.set_buffer_data(view.eye_frustum_plane);
 
     m_uniform_parameter.set_buffer_data(
-        m_color, m_shininess, m_radius_scale, m_ewa_radius, m_epsilon
+        m_color, m_shininess, m_radius_scale, m_ewa_radius, m_epsilon,
+        m_subpixel_size
     );
+
+    m_frame_statistics.uniforms_ms += elapsed_ms(begin);
 }
 
 void
-SplatRenderer::render_pass(bool depth_only)
+SplatRenderer::render_pass(View const& view, bool depth_only)
 { 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_PROGRAM_POINT_SIZE);
@@ -487,10 +892,6 @@ SplatRenderer::render_pass(bool depth_only)
         glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE, GL_ONE, GL_ONE);
     }
 
-    glProgram &program = depth_only ? m_visibility : m_attribute;
-
-    program.use();
-
     if (depth_only)
     {
         glDepthMask(GL_TRUE);
@@ -506,21 +907,57 @@ SplatRenderer::render_pass(bool depth_only)
         glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
     }
 
-    setup_uniforms(program);
+    // With the sub-pixel fast path, the splats are drawn twice, each time
+    // discarding the vertices of the other class.
+    glProgram* programs[2] = {
+        depth_only ? &m_visibility : &m_attribute, nullptr };
 
-    if (!depth_only && m_soft_zbuffer && m_ewa_filter)
+    if (m_subpixel_size > 0.0f)
     {
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_1D, m_filter_kernel);
+        programs[1] = depth_only ? &m_visibility_subpixel
+            : &m_attribute_subpixel;
+    }
+
+    setup_uniforms(*programs[0], view);
+
+    // The attribute pass skips the clusters found occluded.
+    bool culled = !depth_only && m_occlusion_culled;
+    std::vector<std::size_t> const& draw_first = culled ? m_visible_first
+        : m_draw_first;
+    std::vector<GLsizei> const& draw_count = culled ? m_visible_count
+        : m_draw_count;
+
+    if (!depth_only)
+    {
+        std::size_t submitted(0);
+        for (GLsizei count : draw_count)
+        {
+            submitted += static_cast<std::size_t>(count);
+        }
 
-        program.set_uniform_1i("filter_kernel", 1);
+        m_frame_statistics.submitted_surfels += submitted;
+        m_frame_statistics.culled_surfels += m_num_pts
+            - std::min(submitted, m_num_pts);
     }
 
-    glBindVertexArray(m_vao);
-    glDrawArrays(GL_POINTS, 0, m_num_pts);
-    glBindVertexArray(0);
+    for (unsigned int i(0); i < 2 && programs[i]; ++i)
+    {
+        glProgram& program = *programs[i];
+
+        program.use();
+
+        if (!depth_only && m_soft_zbuffer && m_ewa_filter)
+        {
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_1D, m_filter_kernel);
+
+            program.set_uniform_1i("filter_kernel", 1);
+        }
+
+        draw(draw_first, draw_count);
 
-    program.unuse();
+        program.unuse();
+    }
 
     glDisable(GL_PROGRAM_POINT_SIZE);
     glDisable(GL_BLEND);
@@ -528,58 +965,206 @@ SplatRenderer::render_pass(bool depth_only)
 }
 
 void
-SplatRenderer::begin_frame()
+SplatRenderer::draw(std::vector<std::size_t> const& first,
+    std::vector<GLsizei> const& count)
 {
-    m_fbo.bind();
+    for (auto& chunk : m_chunks)
+    {
+        chunk.draw_first.clear();
+        chunk.draw_count.clear();
+    }
 
-    glDepthMask(GL_TRUE);
-    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    
-    glClearColor(0.0, 0.0, 0.0, 0.0);
-    glClearDepth(1.0);
+    // Draw ranges do not cross buffer objects.
+    for (std::size_t i(0); i < first.size(); ++i)
+    {
+        Chunk& chunk = m_chunks[first[i] / (m_chunk_slots * page_size)];
 
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-}
+        chunk.draw_first.push_back(static_cast<GLint>(first[i]
+            - chunk.first_slot * page_size));
+        chunk.draw_count.push_back(count[i]);
+    }
 
-void
-SplatRenderer::end_frame()
+    for (auto const& chunk : m_chunks)
+    {
+        if (chunk.draw_first.empty())
+        {
+            continue;
+        }
+
+        glBindVertexArray(chunk.vao);
+
+        // In a layered framebuffer, the geometry shader fans each surfel
+        // out to the views.
+        glMultiDrawArrays(GL_POINTS, chunk.draw_first.data(),
+            chunk.draw_count.data(),
+            static_cast<GLsizei>(chunk.draw_first.size()));
+    }
+
+    glBindVertexArray(0);
+}
+
+// Appends a draw range, which is merged with the previous one if they are
+// adjacent within a buffer object.
+void
+SplatRenderer::append_range(std::size_t first, std::size_t count,
+    std::vector<std::size_t>& draw_first,
+    std::vector<GLsizei>& draw_count) const
 {
-    m_fbo.unbind();
+    if (!draw_first.empty() && draw_first.back() + static_cast<std::size_t>(
+        draw_count.back()) == first && first % (m_chunk_slots * page_size)
+        != 0)
+    {
+        draw_count.back() += static_cast<GLsizei>(count);
+    }
+    else
+    {
+        draw_first.push_back(first);
+        draw_count.push_back(static_cast<GLsizei>(count));
+    }
+}
 
-    if (m_multisample)
+void
+SplatRenderer::render_geometry(View const& view)
+{
+    if (!m_draw_first.empty())
     {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_fbo.color_texture());
+        if (m_multisample)
+        {
+            glEnable(GL_MULTISAMPLE);
+            glEnable(GL_SAMPLE_SHADING);
+            glMinSampleShading(4.0);
+        }
 
-        if (m_smooth)
+        m_occlusion_culled = m_occlusion_culling && m_soft_zbuffer
+            && !m_multisample && m_fbo.layers() == 0;
+
+        if (!m_occlusion_culled)
         {
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_fbo.normal_texture());
+            m_culling = CullingStatistics();
+            m_hiz.discard();
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+
+        if (m_soft_zbuffer)
+        {
+            begin_timer(0);
+            render_pass(view, true);
+
+            if (m_occlusion_culled)
+            {
+                GLint viewport[4];
+                glGetIntegerv(GL_VIEWPORT, viewport);
+
+                m_hiz.build(m_rect_vao, view.modelview_projection);
+
+                m_fbo.bind();
+                glViewport(viewport[0], viewport[1], viewport[2],
+                    viewport[3]);
+
+                cull_occluded();
+            }
+
+            end_timer();
+        }
 
-            glActiveTexture(GL_TEXTURE2);
-            glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_fbo.depth_texture());
+        m_frame_statistics.visibility_ms += elapsed_ms(begin);
+        begin = std::chrono::steady_clock::now();
+
+        begin_timer(1);
+        render_pass(view, false);
+        end_timer();
+
+        m_frame_statistics.attribute_ms += elapsed_ms(begin);
+
+        if (m_multisample)
+        {
+            glDisable(GL_MULTISAMPLE);
+            glDisable(GL_SAMPLE_SHADING);
         }
     }
-    else
+}
+
+void
+SplatRenderer::begin_frame()
+{
+    // The binding points are context state and are bound per frame, such
+    // that several renderers may share a context.
+    m_uniform_camera.bind_buffer_base(0);
+    m_uniform_raycast.bind_buffer_base(1);
+    m_uniform_frustum.bind_buffer_base(2);
+    m_uniform_parameter.bind_buffer_base(3);
+    m_uniform_multiview.bind_buffer_base(4);
+
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_target_fbo);
+    m_fbo.bind();
+
+    glDepthMask(GL_TRUE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    glClearDepth(1.0);
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void
+SplatRenderer::end_frame()
+{
+    m_fbo.unbind();
+
+    GLenum target = GL_TEXTURE_2D;
+    if (m_fbo.layers() > 0)
+    {
+        target = GL_TEXTURE_2D_ARRAY;
+    }
+    else if (m_multisample)
     {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, m_fbo.color_texture());
+        target = GL_TEXTURE_2D_MULTISAMPLE;
+    }
 
-        if (m_smooth)
-        {
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, m_fbo.normal_texture());
+    GLuint color = m_fbo.color_texture();
+    GLuint normal = m_smooth ? m_fbo.normal_texture() : 0;
+    GLuint depth = m_smooth ? m_fbo.depth_texture() : 0;
 
-            glActiveTexture(GL_TEXTURE2);
-            glBindTexture(GL_TEXTURE_2D, m_fbo.depth_texture());
-        }
+    if (m_hole_filling > 0 && target == GL_TEXTURE_2D)
+    {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+
+        m_pull_push.apply(m_fbo.width(), m_fbo.height(), color, normal,
+            depth, m_rect_vao);
+
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+        color = m_pull_push.color_texture();
+        normal = m_pull_push.normal_texture();
+        depth = m_pull_push.depth_texture();
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_target_fbo);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(target, color);
+
+    if (m_smooth)
+    {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(target, normal);
+
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(target, depth);
     }
 
     m_finalization.use();
-    
+}
+
+void
+SplatRenderer::finalize(View const& view, GLint layer)
+{
     try
     {
-        setup_uniforms(m_finalization);
+        setup_uniforms(m_finalization, view);
         m_finalization.set_uniform_1i("color_texture", 0);
 
         if (m_smooth)
@@ -587,6 +1172,11 @@ SplatRenderer::end_frame()
             m_finalization.set_uniform_1i("normal_texture", 1);
             m_finalization.set_uniform_1i("depth_texture", 2);
         }
+
+        if (m_fbo.layers() > 0)
+        {
+            m_finalization.set_uniform_1i("layer", layer);
+        }
     }
     catch (uniform_not_found_error const& e)
     {
@@ -600,49 +1190,1264 @@ SplatRenderer::end_frame()
 }
 
 void
-SplatRenderer::render_frame(std::vector<Surfel> const& visible_geometry)
+SplatRenderer::set_geometry(std::vector<Surfel> const& geometry)
 {
-    begin_frame();
+    std::lock_guard<std::mutex> lock(m_plan_mutex);
+    ++m_revision;
 
-    m_num_pts = static_cast<unsigned int>(visible_geometry.size());
+    m_num_pts = geometry.size();
+    m_geometry = &geometry;
+    m_paging = PagingStatistics();
 
-    if (m_num_pts > 0)
+    m_stream.release();
+    for (auto& ranges : m_stream_ranges)
     {
-        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-        glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(Surfel) * m_num_pts,
-            &visible_geometry.front(), GL_DYNAMIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        ranges.clear();
+    }
 
-        if (m_multisample)
+    m_allocator.reset(m_num_pts);
+    m_id_slot.clear();
+    m_slot_id.clear();
+    m_moved_surfels = 0;
+
+    m_clusters.resize((m_num_pts + cluster_size - 1) / cluster_size);
+    m_cluster_radius.resize(m_clusters.size());
+    m_pages.resize((m_num_pts + page_size - 1) / page_size);
+
+    for (std::size_t i(0); i < m_pages.size(); ++i)
+    {
+        m_pages[i].slot = no_index;
+    }
+
+    update_bounds(geometry, 0, m_num_pts);
+
+    std::size_t const page_bytes = page_size * sizeof(Surfel);
+    std::size_t num_slots = m_pages.size();
+
+    if (m_memory_budget > 0 && m_memory_budget < m_num_pts * sizeof(Surfel))
+    {
+        num_slots = std::max<std::size_t>(1, m_memory_budget / page_bytes);
+    }
+
+    // Halve the number of slots until the allocation succeeds.
+    for (;;)
+    {
+        std::size_t bytes = num_slots == m_pages.size()
+            ? m_num_pts * sizeof(Surfel) : num_slots * page_bytes;
+
+        if (allocate_chunks(num_slots))
         {
-            glEnable(GL_MULTISAMPLE);
-            glEnable(GL_SAMPLE_SHADING);
-            glMinSampleShading(4.0);
+            m_paging.budget_bytes = bytes;
+            m_paging.num_buffers = m_chunks.size();
+            break;
         }
 
-        if (m_soft_zbuffer)
+        std::cerr << "Warning: Failed to allocate " << bytes / 1048576
+            << " MiB for the geometry." << std::endl;
+
+        num_slots = num_slots > 1 && num_slots == m_pages.size()
+            ? std::max<std::size_t>(1, bytes / page_bytes / 2)
+            : num_slots / 2;
+    }
+
+    m_slots.assign(num_slots, Slot());
+    for (auto& slot : m_slots)
+    {
+        slot.page = no_index;
+        slot.last_used = 0;
+    }
+
+    // Geometry within the budget is uploaded at once and stays resident.
+    if (num_slots == m_pages.size() && m_num_pts > 0)
+    {
+        for (auto const& chunk : m_chunks)
+        {
+            std::size_t first = chunk.first_slot * page_size;
+            std::size_t count = std::min(m_num_pts, first + chunk.num_slots
+                * page_size) - first;
+
+            glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(Surfel),
+                &geometry[first]);
+        }
+
+        for (std::size_t i(0); i < m_pages.size(); ++i)
         {
-            render_pass(true);
+            m_pages[i].slot = i;
+            m_slots[i].page = i;
         }
 
-        render_pass(false);
+        m_geometry = nullptr;
+        m_capacity = m_num_pts;
+        m_paging.uploaded_pages = m_pages.size();
+        m_paging.uploaded_bytes = m_num_pts * sizeof(Surfel);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        if (m_multisample)
+    m_paging.num_pages = m_pages.size();
+    m_paging.resident_pages = m_geometry ? 0 : m_pages.size();
+}
+
+void
+SplatRenderer::update_bounds(std::vector<Surfel> const& geometry,
+    std::size_t first, std::size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    std::size_t const clusters_per_page = page_size / cluster_size;
+    std::size_t const first_cluster = first / cluster_size;
+    std::size_t const last_cluster = (first + count - 1) / cluster_size;
+
+    // The bounds of a cluster include the extent of its splats.
+    for (std::size_t i(first_cluster); i <= last_cluster; ++i)
+    {
+        AlignedBox3f bounds;
+        float radius(0.0f);
+
+        for (std::size_t j(i * cluster_size); j < std::min(m_num_pts,
+            (i + 1) * cluster_size); ++j)
         {
-            glDisable(GL_MULTISAMPLE);
-            glDisable(GL_SAMPLE_SHADING);
+            bounds.extend(geometry[j].c);
+            radius = std::max(radius, std::max(geometry[j].u.norm(),
+                geometry[j].v.norm()));
         }
+
+        m_clusters[i] = AlignedBox3f(
+            bounds.min() - Vector3f::Constant(radius),
+            bounds.max() + Vector3f::Constant(radius));
+        m_cluster_radius[i] = radius;
     }
 
-    end_frame();
+    for (std::size_t i(first_cluster / clusters_per_page);
+        i <= last_cluster / clusters_per_page; ++i)
+    {
+        m_pages[i].bounds.setEmpty();
+        m_pages[i].radius = 0.0f;
 
-#ifndef NDEBUG
-    GLenum gl_error = glGetError();
-    if (GL_NO_ERROR != gl_error)
+        for (std::size_t j(i * clusters_per_page); j < std::min(
+            m_clusters.size(), (i + 1) * clusters_per_page); ++j)
+        {
+            m_pages[i].bounds.extend(m_clusters[j]);
+            m_pages[i].radius = std::max(m_pages[i].radius,
+                m_cluster_radius[j]);
+        }
+    }
+}
+
+void
+SplatRenderer::update_geometry(std::vector<Surfel> const& geometry)
+{
+    update_geometry(geometry, std::vector<std::pair<std::size_t,
+        std::size_t>>(1, std::make_pair(std::size_t(0), geometry.size())));
+}
+
+void
+SplatRenderer::update_geometry(std::vector<Surfel> const& geometry,
+    std::vector<std::pair<std::size_t, std::size_t>> const& ranges)
+{
+    if (geometry.size() != m_num_pts)
     {
-        std::cerr << __FILE__ << "(" << __LINE__ << "): "
-            << GLviz::get_gl_error_string(gl_error) << std::endl;
+        throw std::invalid_argument("The size of the updated geometry "
+            "differs.");
     }
-#endif
+
+    if (m_geometry != nullptr)
+    {
+        throw std::invalid_argument("Updated geometry must be resident "
+            "within the memory budget.");
+    }
+
+    if (!m_id_slot.empty())
+    {
+        throw std::invalid_argument("Edited geometry cannot be updated.");
+    }
+
+    if (m_chunks.size() > 1)
+    {
+        throw std::invalid_argument("Updated geometry must fit into one "
+            "buffer object.");
+    }
+
+    for (auto const& range : ranges)
+    {
+        if (range.first > m_num_pts || range.second > m_num_pts
+            - range.first)
+        {
+            throw std::invalid_argument("Update range out of bounds.");
+        }
+    }
+
+    if (m_num_pts == 0)
+    {
+        return;
+    }
+
+    // A region was last written three updates ago. It receives the
+    // changes of the two previous updates along with the current ones.
+    // The first update writes all surfels to every region.
+    std::vector<std::pair<std::size_t, std::size_t>> writes(ranges);
+    unsigned int first_region(0), last_region(0);
+
+    if (m_stream.buffer() == 0)
+    {
+        m_stream.allocate(m_num_pts * sizeof(SurfelMotion));
+
+        writes.assign(1, std::make_pair(std::size_t(0), m_num_pts));
+        last_region = StreamBuffer::num_regions - 1;
+    }
+    else
+    {
+        first_region = last_region = m_stream.next_region();
+
+        for (unsigned int i(0); i < StreamBuffer::num_regions; ++i)
+        {
+            if (i != first_region)
+            {
+                writes.insert(writes.end(), m_stream_ranges[i].begin(),
+                    m_stream_ranges[i].end());
+            }
+        }
+    }
+
+    std::size_t first(m_num_pts), last(0);
+    for (auto const& range : writes)
+    {
+        if (range.second > 0)
+        {
+            first = std::min(first, range.first);
+            last = std::max(last, range.first + range.second);
+        }
+    }
+
+    for (unsigned int region(first_region); region <= last_region
+        && first < last; ++region)
+    {
+        char* mapped = m_stream.map(region, first * sizeof(SurfelMotion),
+            last * sizeof(SurfelMotion));
+
+        SurfelMotion* motion = reinterpret_cast<SurfelMotion*>(mapped);
+
+        for (auto const& range : writes)
+        {
+            for (std::size_t i(range.first); i < range.first + range.second;
+                ++i)
+            {
+                motion[i - first].c = geometry[i].c;
+                motion[i - first].u = geometry[i].u;
+                motion[i - first].v = geometry[i].v;
+            }
+
+            m_stream.flush(range.first * sizeof(SurfelMotion),
+                (range.first + range.second) * sizeof(SurfelMotion));
+        }
+
+        m_stream.unmap();
+    }
+
+    m_stream_ranges[m_stream.region()] = ranges;
+
+    {
+        std::lock_guard<std::mutex> lock(m_plan_mutex);
+
+        for (auto const& range : ranges)
+        {
+            update_bounds(geometry, range.first, range.second);
+        }
+
+        ++m_revision;
+    }
+
+    setup_center_tangent_attributes();
+}
+
+std::size_t
+SplatRenderer::stream_stalls() const
+{
+    return m_stream.stalls();
+}
+
+void
+SplatRenderer::begin_editing()
+{
+    if (m_geometry != nullptr)
+    {
+        throw std::invalid_argument("Edited geometry must be resident "
+            "within the memory budget.");
+    }
+
+    if (m_stream.buffer() != 0)
+    {
+        throw std::invalid_argument("Updated geometry cannot be edited.");
+    }
+
+    if (m_chunks.size() > 1)
+    {
+        throw std::invalid_argument("Edited geometry must fit into one "
+            "buffer object.");
+    }
+
+    // Identifiers start out as the indices of the geometry.
+    if (m_id_slot.empty() && m_num_pts > 0)
+    {
+        m_id_slot.resize(m_num_pts);
+        for (std::size_t i(0); i < m_num_pts; ++i)
+        {
+            m_id_slot[i] = i;
+        }
+
+        m_slot_id = m_id_slot;
+    }
+}
+
+void
+SplatRenderer::upload_surfels(std::size_t slot, Surfel const* surfels,
+    std::size_t count)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, m_chunks.front().vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, slot * sizeof(Surfel),
+        count * sizeof(Surfel), surfels);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void
+SplatRenderer::extend_bounds(std::size_t slot, AlignedBox3f const& box,
+    float radius)
+{
+    std::size_t cluster = slot / cluster_size;
+    Page& page = m_pages[slot / page_size];
+
+    m_clusters[cluster].extend(box);
+    m_cluster_radius[cluster] = std::max(m_cluster_radius[cluster], radius);
+
+    page.bounds.extend(box);
+    page.radius = std::max(page.radius, radius);
+
+    ++m_revision;
+}
+
+AlignedBox3f
+SplatRenderer::scaled_bounds(AlignedBox3f const& bounds, float radius) const
+{
+    if (m_radius_scale <= 1.0f || bounds.isEmpty())
+    {
+        return bounds;
+    }
+
+    Vector3f margin = Vector3f::Constant((m_radius_scale - 1.0f) * radius);
+
+    return AlignedBox3f(bounds.min() - margin, bounds.max() + margin);
+}
+
+void
+SplatRenderer::resize_pages()
+{
+    m_num_pts = m_allocator.end();
+
+    std::size_t num_pages = (m_num_pts + page_size - 1) / page_size;
+    std::size_t num_clusters = (m_num_pts + cluster_size - 1) / cluster_size;
+
+    if (num_pages != m_pages.size() || num_clusters != m_clusters.size())
+    {
+        ++m_revision;
+    }
+
+    // Bounds of pages and clusters grow conservatively and are kept while
+    // they are in use.
+    m_clusters.resize(num_clusters);
+    m_cluster_radius.resize(num_clusters, 0.0f);
+
+    while (m_pages.size() < num_pages)
+    {
+        Page page;
+        page.bounds.setEmpty();
+        page.radius = 0.0f;
+        page.slot = m_pages.size();
+        m_pages.push_back(page);
+
+        Slot slot;
+        slot.page = m_slots.size();
+        slot.last_used = 0;
+        m_slots.push_back(slot);
+    }
+
+    m_pages.resize(num_pages);
+    m_slots.resize(num_pages);
+
+    m_paging.num_pages = m_pages.size();
+    m_paging.resident_pages = m_pages.size();
+}
+
+std::vector<std::size_t>
+SplatRenderer::insert_surfels(std::vector<Surfel> const& surfels)
+{
+    begin_editing();
+
+    std::size_t const max_capacity = m_chunk_slots * page_size;
+    if (m_allocator.end() + surfels.size() > max_capacity
+        + m_allocator.free_slots())
+    {
+        throw std::invalid_argument("Edited geometry must fit into one "
+            "buffer object.");
+    }
+
+    std::vector<SlotAllocator::Range> ranges;
+    m_allocator.allocate(surfels.size(), ranges);
+
+    // Grow the buffer by copying its contents on the GPU.
+    if (m_allocator.end() > m_capacity)
+    {
+        std::size_t capacity = std::min(max_capacity, std::max(2 * m_capacity,
+            (m_allocator.end() + page_size - 1) / page_size * page_size));
+
+        GLuint copy;
+        glGenBuffers(1, &copy);
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, copy);
+        glBufferData(GL_COPY_WRITE_BUFFER, m_num_pts * sizeof(Surfel),
+            nullptr, GL_STREAM_COPY);
+        glBindBuffer(GL_COPY_READ_BUFFER, m_chunks.front().vbo);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+            m_num_pts * sizeof(Surfel));
+
+        glBufferData(GL_COPY_READ_BUFFER, capacity * sizeof(Surfel),
+            nullptr, GL_STATIC_DRAW);
+        glCopyBufferSubData(GL_COPY_WRITE_BUFFER, GL_COPY_READ_BUFFER, 0, 0,
+            m_num_pts * sizeof(Surfel));
+
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glDeleteBuffers(1, &copy);
+
+        m_capacity = capacity;
+        m_chunks.front().num_slots = capacity / page_size;
+        m_paging.budget_bytes = capacity * sizeof(Surfel);
+        m_slot_id.resize(capacity, no_index);
+    }
+
+    std::lock_guard<std::mutex> lock(m_plan_mutex);
+    resize_pages();
+
+    std::vector<std::size_t> ids;
+    ids.reserve(surfels.size());
+
+    std::size_t i(0);
+    for (auto const& range : ranges)
+    {
+        upload_surfels(range.first, &surfels[i], range.second);
+
+        for (std::size_t j(0); j < range.second; ++j, ++i)
+        {
+            float radius = std::max(surfels[i].u.norm(), surfels[i].v.norm());
+            extend_bounds(range.first + j, AlignedBox3f(
+                surfels[i].c - Vector3f::Constant(radius),
+                surfels[i].c + Vector3f::Constant(radius)), radius);
+
+            m_slot_id[range.first + j] = m_id_slot.size();
+            ids.push_back(m_id_slot.size());
+            m_id_slot.push_back(range.first + j);
+        }
+    }
+
+    return ids;
+}
+
+void
+SplatRenderer::remove_surfels(std::vector<std::size_t> const& ids)
+{
+    begin_editing();
+
+    std::vector<std::size_t> slots;
+    slots.reserve(ids.size());
+
+    for (std::size_t id : ids)
+    {
+        if (id >= m_id_slot.size() || m_id_slot[id] == no_index)
+        {
+            throw std::invalid_argument("Invalid surfel identifier.");
+        }
+
+        slots.push_back(m_id_slot[id]);
+        m_slot_id[m_id_slot[id]] = no_index;
+        m_id_slot[id] = no_index;
+    }
+
+    std::sort(slots.begin(), slots.end());
+
+    // Removed surfels are masked by zero tangent axes. Consecutive slots
+    // are masked and freed together.
+    Surfel removed(Vector3f::Zero(), Vector3f::Zero(), Vector3f::Zero(),
+        Vector3f::Zero(), 0);
+    std::vector<Surfel> masks;
+
+    for (std::size_t i(0); i < slots.size();)
+    {
+        std::size_t n(1);
+        while (i + n < slots.size() && slots[i + n] == slots[i] + n)
+        {
+            ++n;
+        }
+
+        if (slots[i] + n < m_allocator.end())
+        {
+            masks.resize(std::max(masks.size(), n), removed);
+            upload_surfels(slots[i], masks.data(), n);
+        }
+
+        m_allocator.free(slots[i], n);
+        i += n;
+    }
+
+    // Removing the last surfels may have lowered the end.
+    std::lock_guard<std::mutex> lock(m_plan_mutex);
+    resize_pages();
+}
+
+void
+SplatRenderer::replace_surfels(std::vector<std::size_t> const& ids,
+    std::vector<Surfel> const& surfels)
+{
+    begin_editing();
+
+    if (ids.size() != surfels.size())
+    {
+        throw std::invalid_argument("The number of identifiers and surfels "
+            "differs.");
+    }
+
+    std::lock_guard<std::mutex> lock(m_plan_mutex);
+
+    for (std::size_t i(0); i < ids.size(); ++i)
+    {
+        if (ids[i] >= m_id_slot.size() || m_id_slot[ids[i]] == no_index)
+        {
+            throw std::invalid_argument("Invalid surfel identifier.");
+        }
+
+        std::size_t slot = m_id_slot[ids[i]];
+        upload_surfels(slot, &surfels[i], 1);
+
+        float radius = std::max(surfels[i].u.norm(), surfels[i].v.norm());
+        extend_bounds(slot, AlignedBox3f(
+            surfels[i].c - Vector3f::Constant(radius),
+            surfels[i].c + Vector3f::Constant(radius)), radius);
+    }
+}
+
+std::size_t
+SplatRenderer::compaction_rate() const
+{
+    return m_compaction_rate;
+}
+
+void
+SplatRenderer::set_compaction_rate(std::size_t surfels_per_frame)
+{
+    m_compaction_rate = surfels_per_frame;
+}
+
+SplatRenderer::EditingStatistics
+SplatRenderer::editing_statistics() const
+{
+    EditingStatistics statistics;
+
+    statistics.used_slots = m_num_pts;
+    statistics.free_slots = m_allocator.free_slots();
+    statistics.num_surfels = m_num_pts - statistics.free_slots;
+    statistics.capacity = m_capacity;
+    statistics.moved_surfels = m_moved_surfels;
+
+    return statistics;
+}
+
+void
+SplatRenderer::compact()
+{
+    if (m_id_slot.empty())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_plan_mutex);
+
+    std::size_t budget = m_compaction_rate;
+    std::size_t from, to, count;
+
+    glBindBuffer(GL_COPY_READ_BUFFER, m_chunks.front().vbo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_chunks.front().vbo);
+
+    while (m_allocator.compact(budget, from, to, count))
+    {
+        // The ranges do not overlap since the surfels are moved from the
+        // last used run into the first free range.
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+            from * sizeof(Surfel), to * sizeof(Surfel),
+            count * sizeof(Surfel));
+
+        for (std::size_t i(0); i < count; ++i)
+        {
+            std::size_t id = m_slot_id[from + i];
+
+            m_id_slot[id] = to + i;
+            m_slot_id[to + i] = id;
+            m_slot_id[from + i] = no_index;
+
+            std::size_t cluster = (from + i) / cluster_size;
+            extend_bounds(to + i, m_clusters[cluster],
+                m_cluster_radius[cluster]);
+        }
+
+        m_moved_surfels += count;
+        budget -= count;
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    resize_pages();
+}
+
+std::size_t
+SplatRenderer::memory_budget() const
+{
+    return m_memory_budget;
+}
+
+void
+SplatRenderer::set_memory_budget(std::size_t bytes)
+{
+    m_memory_budget = bytes;
+}
+
+SplatRenderer::PagingStatistics const&
+SplatRenderer::paging_statistics() const
+{
+    return m_paging;
+}
+
+std::size_t
+SplatRenderer::max_buffer_size() const
+{
+    return m_max_buffer_size;
+}
+
+void
+SplatRenderer::set_max_buffer_size(std::size_t bytes)
+{
+    m_max_buffer_size = bytes;
+}
+
+bool
+SplatRenderer::occlusion_culling() const
+{
+    return m_occlusion_culling;
+}
+
+void
+SplatRenderer::set_occlusion_culling(bool enable)
+{
+    m_occlusion_culling = enable;
+}
+
+SplatRenderer::CullingStatistics const&
+SplatRenderer::culling_statistics() const
+{
+    return m_culling;
+}
+
+SplatRenderer::FrameStatistics const&
+SplatRenderer::frame_statistics() const
+{
+    return m_frame_statistics;
+}
+
+std::string
+SplatRenderer::program_variant() const
+{
+    std::ostringstream variant;
+
+    variant << "pointsize=" << m_pointsize_method;
+
+    if (m_soft_zbuffer)     variant << ",soft-zbuffer";
+    if (m_ewa_filter)       variant << ",ewa";
+    if (m_smooth)           variant << ",smooth";
+    if (!m_color_material)  variant << ",surfel-color";
+    if (m_backface_culling) variant << ",backface-culling";
+    if (m_subpixel_size > 0.0f) variant << ",subpixel";
+    if (m_multisample)      variant << ",multisample";
+    if (m_fbo.layers() > 0) variant << ",multiview";
+    if (m_occlusion_culled) variant << ",occlusion";
+
+    return variant.str();
+}
+
+void
+SplatRenderer::cull_occluded()
+{
+    // The screen-space filter extends splats beyond their bounds.
+    float margin = m_ewa_filter ? m_ewa_radius + 1.0f : 1.0f;
+
+    m_visible_first.clear();
+    m_visible_count.clear();
+    m_culling = CullingStatistics();
+
+    for (std::size_t i(0); i < m_draw_first.size(); ++i)
+    {
+        // Draw ranges consist of whole clusters of the pages resident in
+        // the slots they cover.
+        std::size_t end = m_draw_first[i] + static_cast<std::size_t>(
+            m_draw_count[i]);
+
+        for (std::size_t first(m_draw_first[i]); first < end;
+            first += cluster_size)
+        {
+            std::size_t page = m_slots[first / page_size].page;
+            std::size_t cluster = page * (page_size / cluster_size)
+                + first % page_size / cluster_size;
+            ++m_culling.tested_clusters;
+
+            if (m_hiz.occluded(scaled_bounds(m_clusters[cluster],
+                m_cluster_radius[cluster]), margin))
+            {
+                ++m_culling.occluded_clusters;
+                continue;
+            }
+
+            append_range(first, std::min(cluster_size, end - first),
+                m_visible_first, m_visible_count);
+        }
+    }
+}
+
+void
+SplatRenderer::plan_frame(GLviz::Camera const& camera, FramePlan& plan) const
+{
+    plan_views(&camera, 1, Matrix4f::Identity(), plan);
+}
+
+void
+SplatRenderer::plan_views(GLviz::Camera const* cameras,
+    std::size_t num_cameras, Matrix4f const& tile_matrix,
+    FramePlan& plan) const
+{
+    plan.views.resize(num_cameras);
+    for (std::size_t i(0); i < num_cameras; ++i)
+    {
+        View& view = plan.views[i];
+
+        view.camera = cameras[i];
+        view.projection_matrix = tile_matrix
+            * cameras[i].get_projection_matrix();
+        view.projection_matrix_inv = view.projection_matrix.inverse();
+        view.modelview_projection = view.projection_matrix
+            * cameras[i].get_modelview_matrix();
+
+        set_frustum_planes(view.projection_matrix, view.eye_frustum_plane);
+        set_frustum_planes(view.modelview_projection, view.frustum_plane);
+    }
+
+    plan.pages.clear();
+    plan.clusters.clear();
+
+    std::lock_guard<std::mutex> lock(m_plan_mutex);
+
+    plan.revision = m_revision;
+
+    auto in_view = [this, &plan](AlignedBox3f const& bounds, float radius) {
+        AlignedBox3f box = scaled_bounds(bounds, radius);
+
+        for (auto const& view : plan.views)
+        {
+            if (intersects_frustum(box, view.frustum_plane))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    };
+
+    for (std::size_t i(0); i < m_pages.size(); ++i)
+    {
+        if (in_view(m_pages[i].bounds, m_pages[i].radius))
+        {
+            plan.pages.push_back(i);
+        }
+    }
+
+    plan.visible_pages = plan.pages.size();
+
+    if (m_geometry != nullptr && !plan.pages.empty())
+    {
+        // The pages nearest to the first view take precedence if the
+        // visible pages exceed the budget.
+        Vector3f eye = cameras[0].get_modelview_matrix().inverse()
+            .col(3).head<3>();
+
+        std::stable_sort(plan.pages.begin(), plan.pages.end(),
+            [this, &eye](std::size_t a, std::size_t b) {
+                return m_pages[a].bounds.squaredExteriorDistance(eye)
+                    < m_pages[b].bounds.squaredExteriorDistance(eye);
+            });
+
+        if (plan.pages.size() > m_slots.size())
+        {
+            plan.pages.resize(m_slots.size());
+        }
+    }
+
+    // Pages without a cluster in view are neither uploaded nor drawn.
+    std::size_t const clusters_per_page = page_size / cluster_size;
+    std::size_t num_pages(0);
+
+    for (std::size_t page : plan.pages)
+    {
+        std::size_t const first = page * clusters_per_page;
+        std::size_t const end = std::min(m_clusters.size(),
+            first + clusters_per_page);
+
+        bool drawn(false);
+        for (std::size_t i(first); i < end; ++i)
+        {
+            if (!in_view(m_clusters[i], m_cluster_radius[i]))
+            {
+                continue;
+            }
+
+            if (drawn && plan.clusters.back().second == i)
+            {
+                ++plan.clusters.back().second;
+            }
+            else
+            {
+                plan.clusters.push_back(std::make_pair(i, i + 1));
+            }
+
+            drawn = true;
+        }
+
+        if (drawn)
+        {
+            plan.pages[num_pages++] = page;
+        }
+    }
+
+    plan.pages.resize(num_pages);
+}
+
+SplatRenderer::FramePlan const&
+SplatRenderer::current_plan(FramePlan const& plan)
+{
+    // The bounds are only changed on this thread.
+    if (plan.revision == m_revision)
+    {
+        return plan;
+    }
+
+    std::vector<GLviz::Camera> cameras;
+    for (auto const& view : plan.views)
+    {
+        cameras.push_back(view.camera);
+    }
+
+    plan_views(cameras.data(), cameras.size(), m_tile_matrix, m_plan);
+
+    return m_plan;
+}
+
+void
+SplatRenderer::update_residency(FramePlan const& plan)
+{
+    ++m_frame;
+
+    m_paging.visible_pages = plan.visible_pages;
+    m_paging.frame_uploaded_pages = 0;
+
+    if (m_geometry != nullptr && !plan.pages.empty())
+    {
+        for (std::size_t i : plan.pages)
+        {
+            if (m_pages[i].slot != no_index)
+            {
+                m_slots[m_pages[i].slot].last_used = m_frame;
+            }
+        }
+
+        for (std::size_t i : plan.pages)
+        {
+            if (m_pages[i].slot != no_index)
+            {
+                continue;
+            }
+
+            // Evict the least recently used page not needed this frame.
+            std::size_t victim(0);
+            for (std::size_t j(1); j < m_slots.size(); ++j)
+            {
+                if (m_slots[j].last_used < m_slots[victim].last_used)
+                {
+                    victim = j;
+                }
+            }
+
+            Slot& slot = m_slots[victim];
+            if (slot.page != no_index)
+            {
+                m_pages[slot.page].slot = no_index;
+                ++m_paging.evicted_pages;
+            }
+            else
+            {
+                ++m_paging.resident_pages;
+            }
+
+            std::size_t first = i * page_size;
+            std::size_t count = std::min(page_size, m_num_pts - first);
+
+            Chunk const& chunk = m_chunks[victim / m_chunk_slots];
+
+            glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+            glBufferSubData(GL_ARRAY_BUFFER, (victim - chunk.first_slot)
+                * page_size * sizeof(Surfel), count * sizeof(Surfel),
+                m_geometry->data() + first);
+
+            slot.page = i;
+            slot.last_used = m_frame;
+            m_pages[i].slot = victim;
+
+            ++m_paging.frame_uploaded_pages;
+            ++m_paging.uploaded_pages;
+            m_paging.uploaded_bytes += count * sizeof(Surfel);
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    m_draw_first.clear();
+    m_draw_count.clear();
+
+    std::size_t const clusters_per_page = page_size / cluster_size;
+
+    for (auto const& range : plan.clusters)
+    {
+        std::size_t page = range.first / clusters_per_page;
+        std::size_t first = m_pages[page].slot * page_size
+            + range.first % clusters_per_page * cluster_size;
+        std::size_t count = std::min(range.second * cluster_size, m_num_pts)
+            - range.first * cluster_size;
+
+        append_range(first, count, m_draw_first, m_draw_count);
+    }
+
+    m_paging.drawn_pages = plan.pages.size();
+}
+
+void
+SplatRenderer::render_frame()
+{
+    plan_views(&m_camera, 1, m_tile_matrix, m_plan);
+    render_planned(m_plan);
+}
+
+void
+SplatRenderer::render_frame(FramePlan const& plan)
+{
+    if (plan.views.size() != 1)
+    {
+        throw std::invalid_argument("The frame plan must have one view.");
+    }
+
+    render_planned(plan);
+}
+
+void
+SplatRenderer::render_planned(FramePlan const& plan)
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    m_visibility.set_multiview(false);
+    m_attribute.set_multiview(false);
+    m_visibility_subpixel.set_multiview(false);
+    m_attribute_subpixel.set_multiview(false);
+    m_finalization.set_layered(false);
+
+    m_fbo.set_layers(0);
+    if (m_fbo.width() != viewport[2] || m_fbo.height() != viewport[3])
+    {
+        m_fbo.reshape(viewport[2], viewport[3]);
+    }
+
+    m_timed_frame = m_pass_timing;
+    if (m_timed_frame)
+    {
+        // The queries of the oldest pending frame are reused if the GPU
+        // lags behind by all of them, which drops its times.
+        if (m_pending_timer_frames == num_timer_frames)
+        {
+            --m_pending_timer_frames;
+        }
+
+        unsigned int slot = m_timed_frames % num_timer_frames;
+        std::fill(m_timer_used[slot], m_timer_used[slot] + 3, false);
+
+        ++m_timed_frames;
+        ++m_pending_timer_frames;
+    }
+
+    m_frame_statistics = FrameStatistics();
+    m_frame_statistics.width = m_fbo.width();
+    m_frame_statistics.height = m_fbo.height();
+
+    auto begin = std::chrono::steady_clock::now();
+
+    compact();
+
+    FramePlan const& current = current_plan(plan);
+    update_residency(current);
+
+    m_frame_statistics.upload_ms = elapsed_ms(begin);
+
+    begin_frame();
+    render_geometry(current.views.front());
+
+    begin_timer(2);
+    end_frame();
+    finalize(current.views.front(), 0);
+    end_timer();
+
+    m_timed_frame = false;
+
+#ifndef NDEBUG
+    GLenum gl_error = glGetError();
+    if (GL_NO_ERROR != gl_error)
+    {
+        std::cerr << __FILE__ << "(" << __LINE__ << "): "
+            << GLviz::get_gl_error_string(gl_error) << std::endl;
+    }
+#endif
+}
+
+void
+SplatRenderer::render_frame(std::vector<GLviz::Camera> const& views)
+{
+    if (views.size() > UniformBufferMultiView::max_views)
+    {
+        throw std::invalid_argument("Too many views for multi-view "
+            "rendering.");
+    }
+
+    if (views.empty())
+    {
+        return;
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    GLsizei num_views = static_cast<GLsizei>(views.size());
+    GLsizei width = viewport[2] / num_views;
+    GLsizei height = viewport[3];
+
+    // All views are rendered with a single draw call per pass, in which a
+    // geometry shader splats each surfel into the layers of the views.
+    // With multisampling, the views are rendered one after another from
+    // the resident geometry.
+    bool layered = !m_multisample;
+
+    m_visibility.set_multiview(layered);
+    m_attribute.set_multiview(layered);
+    m_visibility_subpixel.set_multiview(layered);
+    m_attribute_subpixel.set_multiview(layered);
+    m_finalization.set_layered(layered);
+
+    glViewport(0, 0, width, height);
+
+    m_frame_statistics = FrameStatistics();
+    m_frame_statistics.width = width;
+    m_frame_statistics.height = height;
+
+    auto begin = std::chrono::steady_clock::now();
+
+    compact();
+    plan_views(views.data(), views.size(), m_tile_matrix, m_plan);
+    update_residency(m_plan);
+
+    m_frame_statistics.upload_ms = elapsed_ms(begin);
+
+    m_fbo.set_layers(layered ? num_views : 0);
+    if (m_fbo.width() != width || m_fbo.height() != height)
+    {
+        m_fbo.reshape(width, height);
+    }
+
+    if (layered)
+    {
+        m_uniform_multiview.set_buffer_data(views);
+
+        begin_frame();
+        render_geometry(m_plan.views.front());
+        end_frame();
+
+        for (GLsizei i(0); i < num_views; ++i)
+        {
+            glViewport(viewport[0] + i * width, viewport[1], width, height);
+            finalize(m_plan.views[i], i);
+        }
+    }
+    else
+    {
+        for (GLsizei i(0); i < num_views; ++i)
+        {
+            glViewport(0, 0, width, height);
+
+            begin_frame();
+            render_geometry(m_plan.views[i]);
+            end_frame();
+
+            glViewport(viewport[0] + i * width, viewport[1], width, height);
+            finalize(m_plan.views[i], 0);
+        }
+    }
+
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+#ifndef NDEBUG
+    GLenum gl_error = glGetError();
+    if (GL_NO_ERROR != gl_error)
+    {
+        std::cerr << __FILE__ << "(" << __LINE__ << "): "
+            << GLviz::get_gl_error_string(gl_error) << std::endl;
+    }
+#endif
+}
+
+void
+SplatRenderer::capture_frame(FrameCapture& capture, unsigned int channels)
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    capture.begin(viewport[2], viewport[3]);
+
+    if (channels & FrameCapture::color)
+    {
+        capture.read(FrameCapture::color);
+    }
+
+    if ((channels & (FrameCapture::depth | FrameCapture::normal))
+        && !m_multisample && m_fbo.layers() == 0)
+    {
+        m_fbo.bind();
+
+        if (channels & FrameCapture::depth)
+        {
+            capture.read(FrameCapture::depth);
+        }
+
+        if ((channels & FrameCapture::normal) && m_smooth)
+        {
+            glReadBuffer(GL_COLOR_ATTACHMENT1);
+            capture.read(FrameCapture::normal);
+            glReadBuffer(GL_COLOR_ATTACHMENT0);
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, m_target_fbo);
+    }
+
+    capture.end();
+}
+
+void
+SplatRenderer::render_tiled(GLsizei width, GLsizei height,
+    GLsizei tile_size, std::vector<unsigned char>& rgba, GLsizei border)
+{
+    GLint viewport[4], framebuffer, alignment;
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+
+    // Tiles including their border must fit into the tile-sized target
+    // and the internal framebuffer.
+    GLint max_texture_size, max_renderbuffer_size;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+    glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &max_renderbuffer_size);
+
+    GLsizei max_size = std::min(max_texture_size, max_renderbuffer_size);
+    border = std::max(0, std::min(border, max_size / 4));
+    tile_size = std::max(1, std::min(tile_size, max_size - 2 * border));
+
+    GLsizei size = tile_size + 2 * border;
+
+    GLuint fbo, color;
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size, size);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+        GL_RENDERBUFFER, color);
+
+    rgba.resize(4 * static_cast<std::size_t>(width)
+        * static_cast<std::size_t>(height));
+    std::vector<unsigned char> tile(4 * static_cast<std::size_t>(size)
+        * static_cast<std::size_t>(size));
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    for (GLsizei y(0); y < height; y += tile_size)
+    {
+        for (GLsizei x(0); x < width; x += tile_size)
+        {
+            GLsizei w = std::min(tile_size, width - x);
+            GLsizei h = std::min(tile_size, height - y);
+
+            // Maps the part of the image covered by the tile and its border
+            // to the normalized device coordinates of the tile. Tiles at
+            // the right and top edges extend beyond the image, such that
+            // all tiles have the same size.
+            float x0 = static_cast<float>(x - border);
+            float y0 = static_cast<float>(y - border);
+            float w0 = static_cast<float>(size);
+            float h0 = static_cast<float>(size);
+
+            m_tile_matrix.setIdentity();
+            m_tile_matrix(0, 0) = static_cast<float>(width) / w0;
+            m_tile_matrix(0, 3) = (static_cast<float>(width) - 2.0f * x0
+                - w0) / w0;
+            m_tile_matrix(1, 1) = static_cast<float>(height) / h0;
+            m_tile_matrix(1, 3) = (static_cast<float>(height) - 2.0f * y0
+                - h0) / h0;
+
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            glViewport(0, 0, size, size);
+
+            render_frame();
+
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+            glReadPixels(border, border, w, h, GL_RGBA, GL_UNSIGNED_BYTE,
+                tile.data());
+
+            for (std::size_t i(0); i < static_cast<std::size_t>(h); ++i)
+            {
+                std::copy(tile.begin() + 4 * i * w,
+                    tile.begin() + 4 * (i + 1) * w, rgba.begin() + 4
+                    * ((y + i) * width + x));
+            }
+        }
+    }
+
+    m_tile_matrix.setIdentity();
+
+    glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &color);
 }
@@ -28,27 +28,22 @@
 
 #include <GLviz/buffer.hpp>
 
+#include "frame_capture.hpp"
 #include "framebuffer.hpp"
+#include "hiz_buffer.hpp"
+#include "pull_push.hpp"
+#include "slot_allocator.hpp"
+#include "stream_buffer.hpp"
+#include "surfel.hpp"
 
 #include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <cstddef>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
-struct Surfel
-{
-    Surfel() { }
-
-    Surfel(Eigen::Vector3f c_, Eigen::Vector3f u_, Eigen::Vector3f v_,
-           Eigen::Vector3f p_, unsigned int rgba_)
-        : c(c_), u(u_), v(v_), p(p_), rgba(rgba_) { }
-
-    Eigen::Vector3f c,      // Position of the ellipse center point.
-                    u, v,   // Ellipse major and minor axis.
-                    p;      // Clipping plane.
-
-    unsigned int    rgba;   // Color.
-};
-
 class UniformBufferRaycast : public GLviz::glUniformBuffer
 {
 
@@ -68,6 +63,20 @@ public:
     void set_buffer_data(Eigen::Vector4f const* frustum_plane);
 };
 
+class UniformBufferMultiView : public GLviz::glUniformBuffer
+{
+
+public:
+    // Must match MAX_VIEWS in the attribute shaders.
+    static const unsigned int max_views = 6;
+
+    UniformBufferMultiView();
+
+    // Also sets the number of views, which the geometry shader fans each
+    // splat out to.
+    void set_buffer_data(std::vector<GLviz::Camera> const& views);
+};
+
 class UniformBufferParameter : public GLviz::glUniformBuffer
 {
 
@@ -75,17 +84,190 @@ public:
     UniformBufferParameter();
 
     void set_buffer_data(Eigen::Vector3f const& color, float shininess,
-        float radius_scale, float ewa_radius, float epsilon);
+        float radius_scale, float ewa_radius, float epsilon,
+        float subpixel_size);
 };
 
 class SplatRenderer
 {
 
 public:
+    // Surfels per page of the geometry.
+    static const std::size_t page_size = 65536;
+
+    // Surfels per cluster tested for occlusion, a divisor of page_size.
+    static const std::size_t cluster_size = 1024;
+
+    // Timed frames whose pass times can be pending on the GPU at once.
+    static const unsigned int num_timer_frames = 4;
+
+    struct PagingStatistics
+    {
+        PagingStatistics();
+
+        std::size_t num_pages, resident_pages, visible_pages, drawn_pages;
+        std::size_t budget_bytes, num_buffers;
+
+        // Totals since the geometry was set and uploads of the last frame.
+        std::size_t uploaded_pages, uploaded_bytes, evicted_pages;
+        std::size_t frame_uploaded_pages;
+    };
+
+    struct EditingStatistics
+    {
+        EditingStatistics();
+
+        // Surfels, slots up to the last one in use, free slots below it,
+        // allocated slots and surfels moved by compaction so far.
+        std::size_t num_surfels, used_slots, free_slots, capacity;
+        std::size_t moved_surfels;
+    };
+
+    struct CullingStatistics
+    {
+        CullingStatistics();
+
+        // Clusters of the drawn pages and those skipped by the attribute
+        // pass in the last frame.
+        std::size_t tested_clusters, occluded_clusters;
+    };
+
+    struct FrameStatistics
+    {
+        FrameStatistics();
+
+        // CPU time in milliseconds of the last frame spent on compaction
+        // and paging, i.e. updating the geometry on the GPU, on setting up
+        // uniforms and on issuing the visibility and attribute passes.
+        double upload_ms, uniforms_ms, visibility_ms, attribute_ms;
+
+        // Surfels submitted to the attribute pass and those culled by
+        // paging and occlusion culling, summed over the passes of a frame.
+        std::size_t submitted_surfels, culled_surfels;
+
+        // Size of the internal framebuffer.
+        int width, height;
+    };
+
+    // Uniforms of a view that follow from its camera: the projection
+    // including a tile, its inverse for ray casting and the frustum planes
+    // in eye space for the shaders and in object space for culling.
+    struct View
+    {
+        GLviz::Camera camera;
+        Eigen::Matrix4f projection_matrix, projection_matrix_inv;
+        Eigen::Matrix4f modelview_projection;
+        Eigen::Vector4f eye_frustum_plane[6], frustum_plane[6];
+    };
+
+    // The CPU part of a frame, made by plan_frame() without OpenGL calls.
+    // Besides the uniforms of the views, it lists the pages intersecting a
+    // view frustum, nearest to the first view first if the geometry is
+    // paged and at most as many as fit into the budget, and the ranges
+    // [first, end) of the clusters within them that intersect a view
+    // frustum, with adjacent clusters merged.
+    struct FramePlan
+    {
+        FramePlan();
+
+        std::vector<View, Eigen::aligned_allocator<View>> views;
+        std::vector<std::size_t> pages;
+        std::vector<std::pair<std::size_t, std::size_t>> clusters;
+
+        // Pages intersecting a view frustum before the budget is applied
+        // and the bounds of the geometry the plan was made for.
+        std::size_t visible_pages, revision;
+    };
+
+    // A renderer uses the OpenGL context current on construction, which
+    // must be current whenever it is used. Renderers on separate threads
+    // need separate contexts, while several renderers may share one. They
+    // keep no global state, and geometry set on several renderers is only
+    // read, hence it may be shared between threads as long as it is not
+    // modified.
     SplatRenderer(GLviz::Camera const& camera);
     virtual ~SplatRenderer();
 
-    void render_frame(std::vector<Surfel> const& visible_geometry);
+    // Uploads the geometry once if it fits into the memory budget.
+    // Subsequent frames are rendered from the resident buffer object until
+    // the geometry is replaced. Otherwise, pages that intersect the view
+    // frustum are uploaded on demand in the order of their distance to the
+    // camera and evicted in least recently used order. The geometry is
+    // then read during rendering and must remain unchanged until it is
+    // replaced.
+    void set_geometry(std::vector<Surfel> const& geometry);
+
+    // Streams the centers and tangent axes of deforming geometry, which
+    // must have the size of the geometry set last and be resident within
+    // the memory budget. The geometry holds the current state of all
+    // surfels, of which only the given (first, count) ranges changed since
+    // the last update. The update writes into one of three regions of a
+    // persistently mapped buffer, while the GPU may still read the others,
+    // and waits only if the GPU is more than two frames behind.
+    void update_geometry(std::vector<Surfel> const& geometry);
+    void update_geometry(std::vector<Surfel> const& geometry,
+        std::vector<std::pair<std::size_t, std::size_t>> const& ranges);
+
+    // Number of updates that waited for the GPU since the geometry was set.
+    std::size_t stream_stalls() const;
+
+    // Sparse editing of geometry that is resident within the memory budget
+    // and not streamed. Surfels are identified by their index in the
+    // geometry set last, or by the identifiers returned on insertion, which
+    // stay valid until the geometry is replaced. Inserted surfels occupy
+    // free slots of the vertex buffer, which grows if there are none, and
+    // removed surfels are masked in place. Each edit uploads only the
+    // edited surfels. Surfels at the end are moved into free slots by at
+    // most compaction_rate() surfels per frame with copies on the GPU.
+    std::vector<std::size_t> insert_surfels(
+        std::vector<Surfel> const& surfels);
+    void remove_surfels(std::vector<std::size_t> const& ids);
+    void replace_surfels(std::vector<std::size_t> const& ids,
+        std::vector<Surfel> const& surfels);
+
+    std::size_t compaction_rate() const;
+    void set_compaction_rate(std::size_t surfels_per_frame);
+
+    EditingStatistics editing_statistics() const;
+
+    void render_frame();
+
+    // Plans a frame for the camera. Planning does not use OpenGL and may
+    // run on another thread concurrently with the other functions, e.g.
+    // one frame ahead of rendering.
+    void plan_frame(GLviz::Camera const& camera, FramePlan& plan) const;
+
+    // Renders a frame planned by plan_frame(), which leaves compaction,
+    // paging, uniform uploads and draw calls to the render thread. A plan
+    // made before the bounds of the geometry or the radius scale changed,
+    // e.g. by editing or streaming, is made again.
+    void render_frame(FramePlan const& plan);
+
+    // Renders the geometry as seen from up to six views, e.g. a stereo pair
+    // or the faces of a cube map. The views are placed side by side in the
+    // current viewport. All views are rasterized by a single draw call per
+    // pass into a layered framebuffer if supported.
+    void render_frame(std::vector<GLviz::Camera> const& views);
+
+    // Renders an image of the given size with the camera's projection in
+    // tiles of at most tile_size pixels, e.g. beyond the maximum size of
+    // textures and renderbuffers, and stitches them into rgba in bottom-up
+    // row order. Each tile is rendered with the projection of its part of
+    // the view frustum, extended by border pixels for splats and hole
+    // filling across tile edges, and pages and clusters are culled per
+    // tile. The internal framebuffer and one tile-sized target are reused
+    // for all tiles, so GPU memory does not grow with the image size.
+    void render_tiled(GLsizei width, GLsizei height, GLsizei tile_size,
+        std::vector<unsigned char>& rgba, GLsizei border = 64);
+
+    // Reads the frame rendered last back through the pixel buffer objects
+    // of the capture, which delivers it a few frames later. The color is
+    // read from the current read framebuffer. The depth of the visibility
+    // pass and, with smooth shading, the normals summed by the attribute
+    // pass before normalization are read from the internal framebuffer if
+    // it is single-sampled and not layered.
+    void capture_frame(FrameCapture& capture,
+        unsigned int channels = FrameCapture::color);
 
     bool smooth() const;
     void set_smooth(bool enable = true);
@@ -122,45 +304,232 @@ public:
     float ewa_radius() const;
     void set_ewa_radius(float ewa_radius);
 
+    // Fills holes between splats with a pull-push pyramid of the given
+    // number of levels before shading, zero disables hole filling. This
+    // allows rendering sparser surfel sets with smaller radii. Hole filling
+    // applies to single-sampled, non-layered frames only.
+    unsigned int hole_filling() const;
+    void set_hole_filling(unsigned int levels);
+
+    // Splats whose projected extent is at most the given number of pixels
+    // are drawn by a program variant without per-fragment ray casting,
+    // which writes the depth and color of their center. Zero disables the
+    // fast path.
+    float subpixel_size() const;
+    void set_subpixel_size(float pixels);
+
     void reshape(int width, int height);
 
+    // Limits the GPU memory of the geometry in bytes, zero is unlimited. The
+    // budget takes effect with the next call of set_geometry(). If the
+    // driver cannot allocate the budget, it is halved until the allocation
+    // succeeds. Visible pages exceeding the budget are not drawn.
+    std::size_t memory_budget() const;
+    void set_memory_budget(std::size_t bytes);
+
+    PagingStatistics const& paging_statistics() const;
+
+    // Size in bytes of the largest buffer object allocated for the
+    // geometry, by default 1 GiB. Larger geometry is split into several
+    // buffer objects of whole pages, each drawn separately, such that any
+    // number of surfels is addressed by 32-bit draw offsets. Streaming and
+    // editing require the geometry to fit into one buffer object. Takes
+    // effect with the next call of set_geometry().
+    std::size_t max_buffer_size() const;
+    void set_max_buffer_size(std::size_t bytes);
+
+    // Builds a hierarchical z-buffer from the depth of the visibility pass
+    // and skips clusters behind it in the attribute pass. Requires the soft
+    // z-buffer and applies to single-sampled, non-layered frames only. The
+    // depth is read back once per frame, which stalls until the visibility
+    // pass completes.
+    bool occlusion_culling() const;
+    void set_occlusion_culling(bool enable = true);
+
+    CullingStatistics const& culling_statistics() const;
+
+    FrameStatistics const& frame_statistics() const;
+
+    // Describes the shader variant of the last frame, e.g.
+    // "pointsize=0,ewa,smooth".
+    std::string program_variant() const;
+
+    // Measures the GPU time of the visibility, attribute and finalization
+    // passes of render_frame() with timer queries. The finalization pass
+    // includes hole filling.
+    bool pass_timing() const;
+    void set_pass_timing(bool enable = true);
+
+    // Writes the pass times of the last frame in milliseconds to
+    // milliseconds[0..2]. A pass that did not run reports zero. Waits for
+    // the frame to complete on the GPU.
+    void pass_times(float* milliseconds) const;
+
+    // Number of frames rendered with pass timing so far.
+    std::size_t timed_frames() const;
+
+    // Writes the pass times of the oldest timed frame not yet polled, and
+    // its number among the timed frames, once its timer queries completed.
+    // Returns false without waiting for the GPU if they did not, unless
+    // wait is set. The times of a frame are lost if num_timer_frames later
+    // frames start before they are polled.
+    bool poll_pass_times(std::size_t& frame, float* milliseconds,
+        bool wait = false);
+
 private:
     void setup_program_objects();
     void setup_filter_kernel();
     void setup_screen_size_quad();
-    void setup_vertex_array_buffer_object();
+    void setup_vertex_array_buffer_object(std::size_t first_slot,
+        std::size_t num_slots, std::size_t bytes, GLenum usage);
+    void setup_center_tangent_attributes();
+
+    bool allocate_chunks(std::size_t num_slots);
+    void release_chunks();
 
-    void setup_uniforms(glProgram& program);
+    void update_bounds(std::vector<Surfel> const& geometry,
+        std::size_t first, std::size_t count);
+
+    void begin_editing();
+    void upload_surfels(std::size_t slot, Surfel const* surfels,
+        std::size_t count);
+    void extend_bounds(std::size_t slot, Eigen::AlignedBox3f const& box,
+        float radius);
+    Eigen::AlignedBox3f scaled_bounds(Eigen::AlignedBox3f const& bounds,
+        float radius) const;
+    void resize_pages();
+    void compact();
+
+    void setup_uniforms(glProgram& program, View const& view);
 
     void begin_frame();
     void end_frame();
-    void render_pass(bool depth_only = false);
+    void finalize(View const& view, GLint layer);
+    void render_geometry(View const& view);
+    void render_pass(View const& view, bool depth_only = false);
+    void draw(std::vector<std::size_t> const& first,
+        std::vector<GLsizei> const& count);
+    void append_range(std::size_t first, std::size_t count,
+        std::vector<std::size_t>& draw_first,
+        std::vector<GLsizei>& draw_count) const;
+
+    void begin_timer(unsigned int pass);
+    void end_timer();
+    void read_timer_queries(unsigned int slot, float* milliseconds) const;
+
+    void plan_views(GLviz::Camera const* cameras, std::size_t num_cameras,
+        Eigen::Matrix4f const& tile_matrix, FramePlan& plan) const;
+    FramePlan const& current_plan(FramePlan const& plan);
+    void render_planned(FramePlan const& plan);
+
+    void update_residency(FramePlan const& plan);
+    void cull_occluded();
 
+private:
+    // Bounds include the splats at their unscaled radius, up to the largest
+    // radius given, such that they are widened by the radius scale when
+    // tested instead of being rebuilt whenever it changes.
+    struct Page
+    {
+        Eigen::AlignedBox3f bounds;
+        float radius;
+        std::size_t slot;
+    };
+
+    struct Slot
+    {
+        std::size_t page, last_used;
+    };
+
+    // Buffer object holding the slots [first_slot, first_slot + num_slots)
+    // and the draw ranges relative to it in the current pass.
+    struct Chunk
+    {
+        GLuint vbo, vao;
+        std::size_t first_slot, num_slots;
+        std::vector<GLint> draw_first;
+        std::vector<GLsizei> draw_count;
+    };
 private:
     GLviz::Camera const& m_camera;
 
     GLuint m_rect_vertices_vbo, m_rect_texture_uv_vbo,
         m_rect_vao, m_filter_kernel;
 
-    GLuint m_vbo, m_vao;
-    unsigned int m_num_pts;
+    std::vector<Chunk> m_chunks;
+    std::size_t m_chunk_slots, m_max_buffer_size;
+    std::size_t m_num_pts;
+
+    // Centers and tangent axes of deforming geometry and the ranges last
+    // written to each region.
+    StreamBuffer m_stream;
+    std::vector<std::pair<std::size_t, std::size_t>>
+        m_stream_ranges[StreamBuffer::num_regions];
+
+    // Slot of each surfel identifier and identifier of each slot while the
+    // geometry is edited.
+    SlotAllocator m_allocator;
+    std::vector<std::size_t> m_id_slot, m_slot_id;
+    std::size_t m_capacity, m_compaction_rate, m_moved_surfels;
+
+    std::vector<Surfel> const* m_geometry;
+    std::vector<Page> m_pages;
+    std::vector<Eigen::AlignedBox3f> m_clusters;
+    std::vector<float> m_cluster_radius;
+    std::vector<Slot> m_slots;
+    std::size_t m_memory_budget, m_frame;
+    std::vector<std::size_t> m_draw_first;
+    std::vector<GLsizei> m_draw_count;
+    PagingStatistics m_paging;
+
+    // Guards the bounds, pages and slots and the radius scale read by
+    // plan_frame() while they are changed. The revision counts the changes
+    // of the bounds and the number of pages, clusters and slots.
+    mutable std::mutex m_plan_mutex;
+    std::size_t m_revision;
+    FramePlan m_plan;
+
+    // Draw ranges of the attribute pass without the occluded clusters.
+    std::vector<std::size_t> m_visible_first;
+    std::vector<GLsizei> m_visible_count;
+    bool m_occlusion_culling, m_occlusion_culled;
+    CullingStatistics m_culling;
+    FrameStatistics m_frame_statistics;
 
     ProgramAttribute m_visibility, m_attribute;
+    ProgramAttribute m_visibility_subpixel, m_attribute_subpixel;
     ProgramFinalization m_finalization;
 
     Framebuffer m_fbo;
 
+    // Framebuffer bound when the frame began, which receives the final
+    // image, and the mapping of the view frustum to the current tile.
+    GLint m_target_fbo;
+    Eigen::Matrix4f m_tile_matrix;
+
+    PullPush m_pull_push;
+    HiZBuffer m_hiz;
+    unsigned int m_hole_filling;
+
     bool m_soft_zbuffer, m_backface_culling, m_smooth,
         m_color_material, m_ewa_filter, m_multisample;
     unsigned int m_pointsize_method;
     Eigen::Vector3f m_color;
     float m_epsilon, m_shininess, m_radius_scale,
-        m_ewa_radius;
+        m_ewa_radius, m_subpixel_size;
 
     GLviz::UniformBufferCamera m_uniform_camera;
     UniformBufferRaycast m_uniform_raycast;
     UniformBufferFrustum m_uniform_frustum;
     UniformBufferParameter m_uniform_parameter;
+    UniformBufferMultiView m_uniform_multiview;
+
+    // Timer queries of the passes of the last timed frames in a ring, of
+    // which the oldest m_pending_timer_frames are not polled yet.
+    bool m_pass_timing, m_timed_frame;
+    GLuint m_timer_queries[num_timer_frames][3];
+    bool m_timer_used[num_timer_frames][3];
+    std::size_t m_timed_frames, m_pending_timer_frames;
 };
 
 #endif // SPLATRENDER_HPP
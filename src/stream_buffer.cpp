@@ -0,0 +1,207 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "stream_buffer.hpp"
+
+#include <algorithm>
+
+const unsigned int StreamBuffer::num_regions;
+
+StreamBuffer::StreamBuffer()
+    : m_buffer(0), m_region_bytes(0), m_region(0), m_persistent(nullptr),
+      m_mapped_first(0), m_stalls(0)
+{
+    std::fill(m_fences, m_fences + num_regions, nullptr);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    release();
+}
+
+void
+StreamBuffer::allocate(std::size_t region_bytes)
+{
+    release();
+
+    m_region_bytes = region_bytes;
+    m_region = 0;
+    m_stalls = 0;
+
+    GLsizeiptr bytes = static_cast<GLsizeiptr>(num_regions * region_bytes);
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+
+    if (GLEW_ARB_buffer_storage)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT
+            | GL_MAP_COHERENT_BIT;
+
+        glBufferStorage(GL_ARRAY_BUFFER, bytes, nullptr, flags);
+        m_persistent = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER,
+            0, bytes, flags));
+    }
+    else
+    {
+        glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void
+StreamBuffer::release()
+{
+    for (GLsync& fence : m_fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    if (m_buffer)
+    {
+        if (m_persistent)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        glDeleteBuffers(1, &m_buffer);
+    }
+
+    m_buffer = 0;
+    m_region_bytes = 0;
+    m_persistent = nullptr;
+}
+
+GLuint
+StreamBuffer::buffer() const
+{
+    return m_buffer;
+}
+
+std::size_t
+StreamBuffer::region_bytes() const
+{
+    return m_region_bytes;
+}
+
+bool
+StreamBuffer::persistent() const
+{
+    return m_persistent != nullptr;
+}
+
+unsigned int
+StreamBuffer::region() const
+{
+    return m_region;
+}
+
+unsigned int
+StreamBuffer::next_region()
+{
+    if (m_fences[m_region])
+    {
+        glDeleteSync(m_fences[m_region]);
+    }
+
+    m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_region = (m_region + 1) % num_regions;
+
+    GLsync& fence = m_fences[m_region];
+
+    if (fence)
+    {
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+            0);
+
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            ++m_stalls;
+
+            do
+            {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                    1000000);
+            }
+            while (result == GL_TIMEOUT_EXPIRED);
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    return m_region;
+}
+
+char*
+StreamBuffer::map(unsigned int region, std::size_t first, std::size_t last)
+{
+    std::size_t offset = region * m_region_bytes;
+
+    if (m_persistent)
+    {
+        return m_persistent + offset + first;
+    }
+
+    m_mapped_first = first;
+
+    // The fences guarantee that the GPU does not read the region.
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    return static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER,
+        static_cast<GLintptr>(offset + first),
+        static_cast<GLsizeiptr>(last - first), GL_MAP_WRITE_BIT
+        | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_FLUSH_EXPLICIT_BIT));
+}
+
+void
+StreamBuffer::flush(std::size_t first, std::size_t last)
+{
+    if (!m_persistent)
+    {
+        glFlushMappedBufferRange(GL_ARRAY_BUFFER,
+            static_cast<GLintptr>(first - m_mapped_first),
+            static_cast<GLsizeiptr>(last - first));
+    }
+}
+
+void
+StreamBuffer::unmap()
+{
+    if (!m_persistent)
+    {
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+std::size_t
+StreamBuffer::stalls() const
+{
+    return m_stalls;
+}
@@ -0,0 +1,77 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef STREAM_BUFFER_HPP
+#define STREAM_BUFFER_HPP
+
+#include <GL/glew.h>
+#include <cstddef>
+
+// Buffer object split into regions that are written by the CPU in turn,
+// while the GPU reads the regions of previous frames. Each region is
+// fenced when the next one is taken, and taking a region waits for its
+// fence. The buffer is mapped persistently if GL_ARB_buffer_storage is
+// available, and otherwise mapped per write without synchronization.
+class StreamBuffer
+{
+
+public:
+    static const unsigned int num_regions = 3;
+
+    StreamBuffer();
+    ~StreamBuffer();
+
+    // Allocates the regions. Region zero is the current one.
+    void allocate(std::size_t region_bytes);
+    void release();
+
+    GLuint buffer() const;
+    std::size_t region_bytes() const;
+    bool persistent() const;
+
+    unsigned int region() const;
+
+    // Fences the current region and makes the next one current once the
+    // GPU is done reading it.
+    unsigned int next_region();
+
+    // Maps the bytes [first, last) of a region for writing. Written
+    // subranges must be flushed before the region is unmapped.
+    char* map(unsigned int region, std::size_t first, std::size_t last);
+    void flush(std::size_t first, std::size_t last);
+    void unmap();
+
+    // Number of times next_region() had to wait for the GPU.
+    std::size_t stalls() const;
+
+private:
+    GLuint m_buffer;
+    std::size_t m_region_bytes;
+    unsigned int m_region;
+    GLsync m_fences[num_regions];
+
+    char* m_persistent;
+    std::size_t m_mapped_first;
+    std::size_t m_stalls;
+};
+
+#endif // STREAM_BUFFER_HPP
@@ -0,0 +1,704 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "surfel_file.hpp"
+#include "parallel.hpp"
+#include "spatial_sort.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace Eigen;
+
+namespace
+{
+
+// File layout, all values little-endian:
+//
+//   header       magic "SURFELS\0", uint32 version, uint32 chunk size,
+//                uint64 number of surfels, uint64 number of chunks
+//   chunk table  per chunk uint64 offset, uint32 bytes, uint32 surfels,
+//                float bounding box min[3] and max[3]
+//   chunks       per chunk uint32 palette size, uint32 clipped surfels,
+//                uint32 position bytes, float log2 of the minimum tangent
+//                length, followed by five uint16 streams of tangent
+//                directions, rotations and lengths, where length code 0
+//                stands for a zero length, the colors, the
+//                clipped surfels as uint16 index and float p[3], and the
+//                position deltas as zigzag varints.
+
+char const magic[8] = { 'S', 'U', 'R', 'F', 'E', 'L', 'S', '\0' };
+std::uint32_t const version(2);
+
+std::size_t const header_size(32);
+std::size_t const table_entry_size(40);
+std::size_t const chunk_header_size(16);
+
+// Tangent lengths are quantized in steps of 1/4096 octave.
+float const length_steps(4096.0f);
+
+float
+dequantize_length(std::uint16_t q, float log_min)
+{
+    return q > 0 ? std::exp2(log_min + static_cast<float>(q - 1)
+        / length_steps) : 0.0f;
+}
+
+bool
+host_little_endian()
+{
+    std::uint16_t const x(1);
+    unsigned char c;
+    std::memcpy(&c, &x, 1);
+
+    return c == 1;
+}
+
+template <typename T>
+void
+put(std::vector<unsigned char>& buffer, T const& value)
+{
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+T
+get(unsigned char const* ptr)
+{
+    T value;
+    std::memcpy(&value, ptr, sizeof(T));
+    return value;
+}
+
+std::uint16_t
+quantize_unorm(float x)
+{
+    return static_cast<std::uint16_t>(std::min(std::max(
+        x * 65535.0f + 0.5f, 0.0f), 65535.0f));
+}
+
+float
+dequantize_unorm(std::uint16_t q)
+{
+    return static_cast<float>(q) * (1.0f / 65535.0f);
+}
+
+float
+sign_not_zero(float x)
+{
+    return x < 0.0f ? -1.0f : 1.0f;
+}
+
+// Octahedral mapping of a unit vector to [-1, 1]^2.
+Vector2f
+octahedral_encode(Vector3f const& n)
+{
+    Vector3f m = n / n.cwiseAbs().sum();
+
+    if (m.z() < 0.0f)
+    {
+        return Vector2f((1.0f - std::abs(m.y())) * sign_not_zero(m.x()),
+            (1.0f - std::abs(m.x())) * sign_not_zero(m.y()));
+    }
+
+    return m.head<2>();
+}
+
+Vector3f
+octahedral_decode(float x, float y)
+{
+    Vector3f n(x, y, 1.0f - std::abs(x) - std::abs(y));
+
+    if (n.z() < 0.0f)
+    {
+        n.x() = (1.0f - std::abs(y)) * sign_not_zero(x);
+        n.y() = (1.0f - std::abs(x)) * sign_not_zero(y);
+    }
+
+    return n.normalized();
+}
+
+// Orthonormal basis of the plane perpendicular to a unit vector, see
+// Duff et al., Building an Orthonormal Basis, Revisited.
+void
+orthonormal_basis(Vector3f const& n, Vector3f& b1, Vector3f& b2)
+{
+    float sign = std::copysign(1.0f, n.z());
+    float a = -1.0f / (sign + n.z());
+    float b = n.x() * n.y() * a;
+
+    b1 = Vector3f(1.0f + sign * n.x() * n.x() * a, sign * b,
+        -sign * n.x());
+    b2 = Vector3f(b, sign + n.y() * n.y() * a, -n.y());
+}
+
+void
+put_varint(std::vector<unsigned char>& buffer, std::uint32_t x)
+{
+    while (x >= 0x80)
+    {
+        buffer.push_back(static_cast<unsigned char>(x | 0x80));
+        x >>= 7;
+    }
+
+    buffer.push_back(static_cast<unsigned char>(x));
+}
+
+bool
+get_varint(unsigned char const*& ptr, unsigned char const* end,
+    std::uint32_t& x)
+{
+    x = 0;
+
+    for (unsigned int shift(0); shift < 32; shift += 7)
+    {
+        if (ptr == end)
+        {
+            return false;
+        }
+
+        unsigned char byte = *ptr++;
+        x |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::vector<unsigned char>
+encode_chunk(Surfel const* surfels, std::size_t n,
+    AlignedBox3f const& bounds)
+{
+    // Tangent lengths relative to the smallest one in the chunk.
+    float log_min = std::numeric_limits<float>::max();
+    for (std::size_t i(0); i < n; ++i)
+    {
+        float lu = surfels[i].u.norm(), lv = surfels[i].v.norm();
+
+        if (lu > 0.0f) log_min = std::min(log_min, std::log2(lu));
+        if (lv > 0.0f) log_min = std::min(log_min, std::log2(lv));
+    }
+
+    if (log_min == std::numeric_limits<float>::max())
+    {
+        log_min = 0.0f;
+    }
+
+    // Code 0 is reserved for zero lengths, e.g. of degenerate axes.
+    auto quantize_length = [log_min](float length) {
+        float q = length > 0.0f ? (std::log2(length) - log_min)
+            * length_steps + 1.5f : 0.0f;
+
+        return static_cast<std::uint16_t>(std::min(q, 65535.0f));
+    };
+
+    std::vector<std::uint16_t> tangents(5 * n);
+
+    for (std::size_t i(0); i < n; ++i)
+    {
+        Surfel const& s = surfels[i];
+
+        float lu = s.u.norm();
+        Vector3f du = lu > 0.0f ? Vector3f(s.u / lu) : Vector3f::UnitX();
+
+        Vector2f oct = octahedral_encode(du);
+        std::uint16_t ox = quantize_unorm(0.5f * oct.x() + 0.5f);
+        std::uint16_t oy = quantize_unorm(0.5f * oct.y() + 0.5f);
+
+        // The rotation of v is relative to the decoded direction of u.
+        Vector3f b1, b2;
+        orthonormal_basis(octahedral_decode(2.0f * dequantize_unorm(ox)
+            - 1.0f, 2.0f * dequantize_unorm(oy) - 1.0f), b1, b2);
+
+        float angle = std::atan2(s.v.dot(b2), s.v.dot(b1));
+
+        tangents[i] = ox;
+        tangents[n + i] = oy;
+        tangents[2 * n + i] = quantize_unorm(angle * (0.5f / 3.14159265f)
+            + 0.5f);
+        tangents[3 * n + i] = quantize_length(lu);
+        tangents[4 * n + i] = quantize_length(s.v.norm());
+    }
+
+    // Palette of up to 256 colors.
+    std::vector<std::uint32_t> palette;
+    std::unordered_map<std::uint32_t, std::uint8_t> palette_index;
+
+    for (std::size_t i(0); i < n && palette.size() <= 256; ++i)
+    {
+        if (palette_index.find(surfels[i].rgba) == palette_index.end())
+        {
+            palette_index[surfels[i].rgba] = static_cast<std::uint8_t>(
+                palette.size());
+            palette.push_back(surfels[i].rgba);
+        }
+    }
+
+    if (palette.size() > 256)
+    {
+        palette.clear();
+    }
+
+    std::vector<std::size_t> clipped;
+    for (std::size_t i(0); i < n; ++i)
+    {
+        if (surfels[i].p != Vector3f::Zero())
+        {
+            clipped.push_back(i);
+        }
+    }
+
+    std::vector<unsigned char> positions;
+    positions.reserve(3 * n);
+
+    Vector3f extent = bounds.sizes();
+    Vector3f scale;
+    for (unsigned int j(0); j < 3; ++j)
+    {
+        scale[j] = extent[j] > 0.0f ? 1.0f / extent[j] : 0.0f;
+    }
+
+    std::int32_t previous[3] = { 0, 0, 0 };
+
+    for (std::size_t i(0); i < n; ++i)
+    {
+        for (unsigned int j(0); j < 3; ++j)
+        {
+            std::int32_t q = quantize_unorm((surfels[i].c[j]
+                - bounds.min()[j]) * scale[j]);
+            std::int32_t delta = q - previous[j];
+
+            put_varint(positions, (static_cast<std::uint32_t>(delta) << 1)
+                ^ static_cast<std::uint32_t>(delta >> 31));
+            previous[j] = q;
+        }
+    }
+
+    std::vector<unsigned char> buffer;
+    put(buffer, static_cast<std::uint32_t>(palette.size()));
+    put(buffer, static_cast<std::uint32_t>(clipped.size()));
+    put(buffer, static_cast<std::uint32_t>(positions.size()));
+    put(buffer, log_min);
+
+    for (std::uint16_t t : tangents)
+    {
+        put(buffer, t);
+    }
+
+    if (palette.empty())
+    {
+        for (std::size_t i(0); i < n; ++i)
+        {
+            put(buffer, static_cast<std::uint32_t>(surfels[i].rgba));
+        }
+    }
+    else
+    {
+        for (std::uint32_t color : palette)
+        {
+            put(buffer, color);
+        }
+
+        for (std::size_t i(0); i < n; ++i)
+        {
+            buffer.push_back(palette_index[surfels[i].rgba]);
+        }
+    }
+
+    for (std::size_t i : clipped)
+    {
+        put(buffer, static_cast<std::uint16_t>(i));
+        put(buffer, surfels[i].p.x());
+        put(buffer, surfels[i].p.y());
+        put(buffer, surfels[i].p.z());
+    }
+
+    buffer.insert(buffer.end(), positions.begin(), positions.end());
+
+    return buffer;
+}
+
+}
+
+void
+write_surfels(std::string const& filename, std::vector<Surfel> const&
+    surfels, unsigned int chunk_size)
+{
+    if (!host_little_endian())
+    {
+        throw std::runtime_error("Writing surfel files requires a "
+            "little-endian host.");
+    }
+
+    if (chunk_size == 0 || chunk_size > 65536)
+    {
+        throw std::invalid_argument("Invalid surfel file chunk size.");
+    }
+
+    std::vector<Surfel> sorted(surfels);
+    morton_sort(sorted);
+
+    std::size_t const num_chunks = (sorted.size() + chunk_size - 1)
+        / chunk_size;
+
+    std::vector<AlignedBox3f> bounds(num_chunks);
+    std::vector<std::vector<unsigned char>> chunks(num_chunks);
+
+    // Chunks are encoded in parallel, each thread taking the next chunk.
+    parallel_for(num_chunks, 0, 1, [&](std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; ++i)
+        {
+            Surfel const* begin = sorted.data() + i * chunk_size;
+            std::size_t n = std::min<std::size_t>(chunk_size,
+                sorted.size() - i * chunk_size);
+
+            for (std::size_t j(0); j < n; ++j)
+            {
+                bounds[i].extend(begin[j].c);
+            }
+
+            chunks[i] = encode_chunk(begin, n, bounds[i]);
+        }
+    });
+
+    std::vector<unsigned char> header;
+    header.insert(header.end(), magic, magic + 8);
+    put(header, version);
+    put(header, static_cast<std::uint32_t>(chunk_size));
+    put(header, static_cast<std::uint64_t>(sorted.size()));
+    put(header, static_cast<std::uint64_t>(num_chunks));
+
+    std::uint64_t offset = header_size + num_chunks * table_entry_size;
+
+    for (std::size_t i(0); i < num_chunks; ++i)
+    {
+        put(header, offset);
+        put(header, static_cast<std::uint32_t>(chunks[i].size()));
+        put(header, static_cast<std::uint32_t>(std::min<std::size_t>(
+            chunk_size, sorted.size() - i * chunk_size)));
+
+        for (unsigned int j(0); j < 3; ++j) put(header, bounds[i].min()[j]);
+        for (unsigned int j(0); j < 3; ++j) put(header, bounds[i].max()[j]);
+
+        offset += chunks[i].size();
+    }
+
+    std::ofstream output(filename, std::ios::binary);
+    if (!output.good())
+    {
+        throw std::runtime_error("Failed to open " + filename + ".");
+    }
+
+    output.write(reinterpret_cast<char const*>(header.data()),
+        header.size());
+
+    for (auto const& chunk : chunks)
+    {
+        output.write(reinterpret_cast<char const*>(chunk.data()),
+            chunk.size());
+    }
+
+    if (!output.good())
+    {
+        throw std::runtime_error("Failed to write " + filename + ".");
+    }
+}
+
+SurfelFile::SurfelFile(std::string const& filename)
+    : m_filename(filename), m_file(filename), m_size(0)
+{
+    if (!host_little_endian())
+    {
+        throw std::runtime_error("Reading surfel files requires a "
+            "little-endian host.");
+    }
+
+    unsigned char const* data = m_file.data();
+    std::size_t const file_size = m_file.size();
+
+    if (file_size < header_size || std::memcmp(data, magic, 8) != 0)
+    {
+        throw std::runtime_error(filename + " is not a surfel file.");
+    }
+
+    if (get<std::uint32_t>(data + 8) != version)
+    {
+        throw std::runtime_error(filename + " has an unsupported version.");
+    }
+
+    std::uint32_t max_chunk_size = get<std::uint32_t>(data + 12);
+    std::uint64_t num_surfels = get<std::uint64_t>(data + 16);
+    std::uint64_t num_chunks = get<std::uint64_t>(data + 24);
+
+    if (num_chunks > (file_size - header_size) / table_entry_size)
+    {
+        throw std::runtime_error(filename + " is truncated.");
+    }
+
+    m_chunks.resize(num_chunks);
+
+    for (std::size_t i(0); i < num_chunks; ++i)
+    {
+        unsigned char const* entry = data + header_size
+            + i * table_entry_size;
+
+        Chunk& chunk = m_chunks[i];
+        chunk.offset = get<std::uint64_t>(entry);
+        chunk.bytes = get<std::uint32_t>(entry + 8);
+        chunk.size = get<std::uint32_t>(entry + 12);
+
+        for (unsigned int j(0); j < 3; ++j)
+        {
+            chunk.bounds.min()[j] = get<float>(entry + 16 + 4 * j);
+            chunk.bounds.max()[j] = get<float>(entry + 28 + 4 * j);
+        }
+
+        if (chunk.offset > file_size || chunk.bytes > file_size
+            - chunk.offset)
+        {
+            throw std::runtime_error(filename + " is truncated.");
+        }
+
+        if (chunk.size > max_chunk_size || chunk.size > 65536
+            || chunk.bytes < chunk_header_size)
+        {
+            throw std::runtime_error(filename + " is corrupt.");
+        }
+
+        m_size += chunk.size;
+    }
+
+    if (m_size != num_surfels)
+    {
+        throw std::runtime_error(filename + " is corrupt.");
+    }
+}
+
+std::size_t
+SurfelFile::size() const
+{
+    return m_size;
+}
+
+std::size_t
+SurfelFile::num_chunks() const
+{
+    return m_chunks.size();
+}
+
+std::size_t
+SurfelFile::chunk_size(std::size_t chunk) const
+{
+    return m_chunks[chunk].size;
+}
+
+AlignedBox3f const&
+SurfelFile::chunk_bounds(std::size_t chunk) const
+{
+    return m_chunks[chunk].bounds;
+}
+
+void
+SurfelFile::decode(std::vector<Surfel>& surfels,
+    unsigned int num_threads) const
+{
+    std::vector<std::size_t> chunks(m_chunks.size());
+    for (std::size_t i(0); i < chunks.size(); ++i)
+    {
+        chunks[i] = i;
+    }
+
+    decode(chunks, surfels, num_threads);
+}
+
+void
+SurfelFile::decode(std::vector<std::size_t> const& chunks,
+    std::vector<Surfel>& surfels, unsigned int num_threads) const
+{
+    std::vector<std::size_t> offsets(chunks.size() + 1, 0);
+    for (std::size_t i(0); i < chunks.size(); ++i)
+    {
+        offsets[i + 1] = offsets[i] + m_chunks.at(chunks[i]).size;
+    }
+
+    surfels.resize(offsets.back());
+
+    std::atomic<bool> corrupt(false);
+
+    parallel_for(chunks.size(), num_threads, 1,
+        [&](std::size_t b, std::size_t e) {
+            for (std::size_t i = b; i < e; ++i)
+            {
+                if (!decode_chunk(m_chunks[chunks[i]],
+                    surfels.data() + offsets[i]))
+                {
+                    corrupt = true;
+                }
+            }
+        });
+
+    if (corrupt)
+    {
+        throw std::runtime_error(m_filename + " is corrupt.");
+    }
+}
+
+void
+SurfelFile::decode_chunk(std::size_t chunk, Surfel* surfels) const
+{
+    if (!decode_chunk(m_chunks.at(chunk), surfels))
+    {
+        throw std::runtime_error(m_filename + " is corrupt.");
+    }
+}
+
+bool
+SurfelFile::decode_chunk(Chunk const& chunk, Surfel* surfels) const
+{
+    std::size_t const n = chunk.size;
+
+    unsigned char const* ptr = m_file.data() + chunk.offset;
+    unsigned char const* end = ptr + chunk.bytes;
+
+    std::uint32_t palette_size = get<std::uint32_t>(ptr);
+    std::uint32_t num_clipped = get<std::uint32_t>(ptr + 4);
+    std::uint32_t position_bytes = get<std::uint32_t>(ptr + 8);
+    float log_min = get<float>(ptr + 12);
+    ptr += chunk_header_size;
+
+    std::size_t const color_bytes = palette_size > 0
+        ? 4 * static_cast<std::size_t>(palette_size) + n : 4 * n;
+
+    if (palette_size > 256 || num_clipped > n
+        || static_cast<std::size_t>(end - ptr) != 10 * n + color_bytes
+            + 14 * static_cast<std::size_t>(num_clipped) + position_bytes)
+    {
+        return false;
+    }
+
+    // Tangent axes.
+    unsigned char const* tangents = ptr;
+    ptr += 10 * n;
+
+    for (std::size_t i(0); i < n; ++i)
+    {
+        float x = 2.0f * dequantize_unorm(get<std::uint16_t>(
+            tangents + 2 * i)) - 1.0f;
+        float y = 2.0f * dequantize_unorm(get<std::uint16_t>(
+            tangents + 2 * (n + i))) - 1.0f;
+        float angle = (dequantize_unorm(get<std::uint16_t>(
+            tangents + 2 * (2 * n + i))) - 0.5f) * 6.28318531f;
+        float lu = dequantize_length(get<std::uint16_t>(
+            tangents + 2 * (3 * n + i)), log_min);
+        float lv = dequantize_length(get<std::uint16_t>(
+            tangents + 2 * (4 * n + i)), log_min);
+
+        Vector3f du = octahedral_decode(x, y);
+
+        Vector3f b1, b2;
+        orthonormal_basis(du, b1, b2);
+
+        surfels[i].u = lu * du;
+        surfels[i].v = lv * (std::cos(angle) * b1 + std::sin(angle) * b2);
+        surfels[i].p = Vector3f::Zero();
+    }
+
+    // Colors.
+    if (palette_size > 0)
+    {
+        unsigned char const* indices = ptr + 4 * palette_size;
+
+        for (std::size_t i(0); i < n; ++i)
+        {
+            if (indices[i] >= palette_size)
+            {
+                return false;
+            }
+
+            surfels[i].rgba = get<std::uint32_t>(ptr + 4 * indices[i]);
+        }
+    }
+    else
+    {
+        for (std::size_t i(0); i < n; ++i)
+        {
+            surfels[i].rgba = get<std::uint32_t>(ptr + 4 * i);
+        }
+    }
+
+    ptr += color_bytes;
+
+    // Clipping planes of the clipped surfels.
+    for (std::uint32_t i(0); i < num_clipped; ++i, ptr += 14)
+    {
+        std::uint16_t j = get<std::uint16_t>(ptr);
+
+        if (j >= n)
+        {
+            return false;
+        }
+
+        surfels[j].p = Vector3f(get<float>(ptr + 2), get<float>(ptr + 6),
+            get<float>(ptr + 10));
+    }
+
+    // Positions.
+    Vector3f scale = chunk.bounds.sizes() * (1.0f / 65535.0f);
+    std::uint32_t q[3] = { 0, 0, 0 };
+
+    for (std::size_t i(0); i < n; ++i)
+    {
+        for (unsigned int j(0); j < 3; ++j)
+        {
+            std::uint32_t zigzag;
+            if (!get_varint(ptr, end, zigzag))
+            {
+                return false;
+            }
+
+            q[j] += (zigzag >> 1) ^ (0u - (zigzag & 1));
+
+            if (q[j] > 65535)
+            {
+                return false;
+            }
+
+            surfels[i].c[j] = chunk.bounds.min()[j] + scale[j]
+                * static_cast<float>(q[j]);
+        }
+    }
+
+    return ptr == end;
+}
@@ -0,0 +1,88 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010-2024 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef SURFEL_FILE_HPP
+#define SURFEL_FILE_HPP
+
+#include "mapped_file.hpp"
+#include "surfel.hpp"
+
+#include <Eigen/Geometry>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Writes surfels to a compressed file of independently decodable chunks.
+// The surfels are stored in Morton order, such that each chunk covers a
+// compact region of space. Within a chunk, positions are quantized to 16
+// bits per axis of the chunk's bounding box and delta-coded, tangent axes
+// are stored as a quantized direction, rotation and log-scale lengths, and
+// colors are palette-coded if a chunk has at most 256 distinct colors. A
+// chunk holds at most 65536 surfels.
+void write_surfels(std::string const& filename,
+    std::vector<Surfel> const& surfels, unsigned int chunk_size = 4096);
+
+// Read access to a file written by write_surfels() through a memory
+// mapping. The chunk table is read on construction, chunks are decoded on
+// demand.
+class SurfelFile
+{
+
+public:
+    explicit SurfelFile(std::string const& filename);
+
+    std::size_t size() const;
+    std::size_t num_chunks() const;
+
+    std::size_t chunk_size(std::size_t chunk) const;
+    Eigen::AlignedBox3f const& chunk_bounds(std::size_t chunk) const;
+
+    // Decodes all chunks, or the given chunks in the given order, e.g.
+    // those intersecting the view frustum. Chunks are decoded by the given
+    // number of threads, zero uses all hardware threads.
+    void decode(std::vector<Surfel>& surfels,
+        unsigned int num_threads = 0) const;
+    void decode(std::vector<std::size_t> const& chunks,
+        std::vector<Surfel>& surfels, unsigned int num_threads = 0) const;
+
+    // Decodes a single chunk to chunk_size(chunk) surfels.
+    void decode_chunk(std::size_t chunk, Surfel* surfels) const;
+
+private:
+    struct Chunk
+    {
+        std::size_t offset, bytes, size;
+        Eigen::AlignedBox3f bounds;
+    };
+
+    bool decode_chunk(Chunk const& chunk, Surfel* surfels) const;
+
+private:
+    std::string m_filename;
+    MappedFile m_file;
+
+    std::size_t m_size;
+    std::vector<Chunk> m_chunks;
+};
+
+#endif // SURFEL_FILE_HPP
@@ -0,0 +1,272 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "telemetry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace
+{
+
+double
+milliseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// Writes a complete event of a span in milliseconds, which trace events
+// give in microseconds.
+void
+write_span(std::ostream& output, char const* name, int tid, double start_ms,
+    double duration_ms)
+{
+    output << ",\n{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,"
+        "\"tid\":" << tid << ",\"ts\":" << 1e3 * start_ms << ",\"dur\":"
+        << 1e3 * duration_ms << "}";
+}
+
+}
+
+Telemetry::Frame::Frame()
+    : index(0), start_ms(0.0), frame_ms(0.0), cpu_ms(0.0)
+{
+    std::fill(gpu_ms, gpu_ms + 3, 0.0f);
+}
+
+Telemetry::Telemetry()
+    : m_last_timed(0)
+{
+}
+
+void
+Telemetry::begin_frame()
+{
+    m_frame_start = std::chrono::steady_clock::now();
+
+    if (m_frames.empty())
+    {
+        m_start = m_frame_start;
+    }
+    else
+    {
+        Frame& previous = m_frames.back();
+        previous.frame_ms = milliseconds(m_frame_start - m_start)
+            - previous.start_ms;
+    }
+}
+
+void
+Telemetry::end_frame(SplatRenderer& renderer)
+{
+    Frame frame;
+    frame.index = m_frames.size();
+    frame.start_ms = milliseconds(m_frame_start - m_start);
+
+    // The last frame lasts until its end, unless another one follows.
+    frame.cpu_ms = milliseconds(std::chrono::steady_clock::now()
+        - m_frame_start);
+    frame.frame_ms = frame.cpu_ms;
+
+    frame.statistics = renderer.frame_statistics();
+    frame.program = renderer.program_variant();
+
+    m_frames.push_back(frame);
+
+    if (renderer.pass_timing() && renderer.timed_frames() > 0)
+    {
+        m_pending.emplace_back(renderer.timed_frames() - 1, frame.index);
+    }
+
+    attach_pass_times(renderer, false);
+}
+
+void
+Telemetry::finish(SplatRenderer& renderer)
+{
+    attach_pass_times(renderer, true);
+    m_pending.clear();
+}
+
+void
+Telemetry::attach_pass_times(SplatRenderer& renderer, bool wait)
+{
+    std::size_t timed_frame;
+    float gpu_ms[3];
+
+    while (!m_pending.empty()
+        && renderer.poll_pass_times(timed_frame, gpu_ms, wait))
+    {
+        // Frames whose times were dropped by the renderer keep zero.
+        while (!m_pending.empty() && m_pending.front().first < timed_frame)
+        {
+            m_pending.pop_front();
+        }
+
+        if (!m_pending.empty() && m_pending.front().first == timed_frame)
+        {
+            Frame& frame = m_frames[m_pending.front().second];
+            std::copy(gpu_ms, gpu_ms + 3, frame.gpu_ms);
+
+            m_last_timed = frame.index + 1;
+            m_pending.pop_front();
+        }
+    }
+}
+
+std::vector<Telemetry::Frame> const&
+Telemetry::frames() const
+{
+    return m_frames;
+}
+
+Telemetry::Frame const*
+Telemetry::last_timed_frame() const
+{
+    return m_last_timed > 0 ? &m_frames[m_last_timed - 1] : nullptr;
+}
+
+double
+Telemetry::percentile(double p) const
+{
+    if (m_frames.empty())
+    {
+        return 0.0;
+    }
+
+    std::vector<double> frame_times;
+    for (Frame const& frame : m_frames)
+    {
+        frame_times.push_back(frame.frame_ms);
+    }
+
+    // The nearest rank, i.e. the smallest frame time not below a fraction
+    // p of the frames.
+    std::size_t rank = static_cast<std::size_t>(std::ceil(p
+        * static_cast<double>(frame_times.size())));
+    rank = std::min(std::max(rank, std::size_t(1)), frame_times.size());
+
+    std::nth_element(frame_times.begin(), frame_times.begin() + rank - 1,
+        frame_times.end());
+
+    return frame_times[rank - 1];
+}
+
+void
+Telemetry::write_csv(std::string const& filename) const
+{
+    std::ofstream output(filename);
+    if (!output.good())
+    {
+        throw std::runtime_error("Failed to open " + filename + ".");
+    }
+
+    output << "frame,start_ms,frame_ms,cpu_ms,upload_ms,uniforms_ms,"
+        "visibility_ms,attribute_ms,gpu_visibility_ms,gpu_attribute_ms,"
+        "gpu_finalization_ms,submitted_surfels,culled_surfels,width,height,"
+        "program" << std::endl;
+
+    output << std::fixed << std::setprecision(3);
+
+    for (Frame const& frame : m_frames)
+    {
+        SplatRenderer::FrameStatistics const& statistics = frame.statistics;
+
+        output << frame.index << "," << frame.start_ms << ","
+            << frame.frame_ms << "," << frame.cpu_ms << ","
+            << statistics.upload_ms << "," << statistics.uniforms_ms << ","
+            << statistics.visibility_ms << "," << statistics.attribute_ms
+            << "," << frame.gpu_ms[0] << "," << frame.gpu_ms[1] << ","
+            << frame.gpu_ms[2] << "," << statistics.submitted_surfels << ","
+            << statistics.culled_surfels << "," << statistics.width << ","
+            << statistics.height << ",\"" << frame.program << "\""
+            << std::endl;
+    }
+
+    if (!output.good())
+    {
+        throw std::runtime_error("Failed to write " + filename + ".");
+    }
+}
+
+void
+Telemetry::write_trace(std::string const& filename) const
+{
+    std::ofstream output(filename);
+    if (!output.good())
+    {
+        throw std::runtime_error("Failed to open " + filename + ".");
+    }
+
+    output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+        "\"args\":{\"name\":\"CPU\"}},\n"
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,"
+        "\"args\":{\"name\":\"GPU\"}}";
+
+    output << std::fixed << std::setprecision(3);
+
+    for (Frame const& frame : m_frames)
+    {
+        SplatRenderer::FrameStatistics const& statistics = frame.statistics;
+        double const start = frame.start_ms;
+
+        output << ",\n{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+            "\"ts\":" << 1e3 * start << ",\"dur\":" << 1e3 * frame.cpu_ms
+            << ",\"args\":{\"frame\":" << frame.index << ",\"frame_ms\":"
+            << frame.frame_ms << ",\"uniforms_ms\":" << statistics.uniforms_ms
+            << ",\"width\":" << statistics.width << ",\"height\":"
+            << statistics.height << ",\"program\":\"" << frame.program
+            << "\"}}";
+
+        // The passes are issued one after another following the upload.
+        // The GPU passes are laid out likewise from the start of the
+        // frame, since timer queries measure durations only.
+        write_span(output, "upload", 1, start, statistics.upload_ms);
+        write_span(output, "visibility", 1, start + statistics.upload_ms,
+            statistics.visibility_ms);
+        write_span(output, "attribute", 1, start + statistics.upload_ms
+            + statistics.visibility_ms, statistics.attribute_ms);
+
+        write_span(output, "visibility", 2, start, frame.gpu_ms[0]);
+        write_span(output, "attribute", 2, start + frame.gpu_ms[0],
+            frame.gpu_ms[1]);
+        write_span(output, "finalization", 2, start + frame.gpu_ms[0]
+            + frame.gpu_ms[1], frame.gpu_ms[2]);
+
+        output << ",\n{\"name\":\"surfels\",\"ph\":\"C\",\"pid\":1,\"ts\":"
+            << 1e3 * start << ",\"args\":{\"submitted\":"
+            << statistics.submitted_surfels << ",\"culled\":"
+            << statistics.culled_surfels << "}}";
+    }
+
+    output << "\n]}" << std::endl;
+
+    if (!output.good())
+    {
+        throw std::runtime_error("Failed to write " + filename + ".");
+    }
+}
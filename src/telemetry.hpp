@@ -0,0 +1,98 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include "splat_renderer.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Collects the timings and statistics of each frame of a renderer, such
+// that stutters hidden by an average frame rate can be analyzed offline.
+// Frames are written as CSV or as Chrome trace events, which can be viewed
+// in chrome://tracing or Perfetto.
+class Telemetry
+{
+
+public:
+    struct Frame
+    {
+        Frame();
+
+        std::size_t index;
+
+        // Start of the frame since the start of the first frame, the time
+        // until the next frame started and the CPU time of the frame.
+        double start_ms, frame_ms, cpu_ms;
+
+        // GPU times of the visibility, attribute and finalization passes,
+        // zero unless the renderer times its passes. They are attached a
+        // few frames late, once the timer queries completed.
+        float gpu_ms[3];
+
+        SplatRenderer::FrameStatistics statistics;
+        std::string program;
+    };
+
+    Telemetry();
+
+    // Brackets the rendering of a frame. With pass timing enabled on the
+    // renderer, end_frame() attaches the GPU times of earlier frames whose
+    // timer queries completed, without waiting for the GPU.
+    void begin_frame();
+    void end_frame(SplatRenderer& renderer);
+
+    // Waits for the GPU times of the frames still pending.
+    void finish(SplatRenderer& renderer);
+
+    std::vector<Frame> const& frames() const;
+
+    // Returns the latest frame with its GPU times attached, or nullptr.
+    Frame const* last_timed_frame() const;
+
+    // Returns the frame time below which a fraction p of the frames lie,
+    // e.g. p = 0.99 for the 99th percentile.
+    double percentile(double p) const;
+
+    void write_csv(std::string const& filename) const;
+    void write_trace(std::string const& filename) const;
+
+private:
+    void attach_pass_times(SplatRenderer& renderer, bool wait);
+
+    std::vector<Frame> m_frames;
+
+    // Frames awaiting their GPU times, as the number of the timed frame of
+    // the renderer and the index of the frame.
+    std::deque<std::pair<std::size_t, std::size_t>> m_pending;
+    std::size_t m_last_timed;
+    std::chrono::steady_clock::time_point m_start, m_frame_start;
+};
+
+#endif // TELEMETRY_HPP
@@ -0,0 +1,108 @@
+// This file is part of Surface Splatting.
+//
+// Copyright (C) 2010, 2015 by Sebastian Lipponer.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+// Round trip of surfels with zero length tangent axes through the compact
+// surfel file format. Zero lengths must decode to zero, the other lengths
+// to within the quantization error.
+
+#include "surfel_file.hpp"
+
+#include <Eigen/Core>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace Eigen;
+
+namespace
+{
+
+bool
+check_length(float expected, float actual, unsigned int i, char const* axis)
+{
+    bool ok = expected > 0.0f
+        ? std::abs(actual - expected) <= 1e-3f * expected
+        : actual == 0.0f;
+
+    if (!ok)
+    {
+        std::cerr << "Surfel " << i << ": " << axis << " length " << actual
+            << " instead of " << expected << "." << std::endl;
+    }
+
+    return ok;
+}
+
+}
+
+int
+main()
+{
+    // Distinct colors identify the surfels after the spatial sort.
+    std::vector<Surfel> surfels;
+    for (unsigned int i(0); i < 64; ++i)
+    {
+        float lu = i % 4 == 1 || i % 4 == 3 ? 0.0f : 0.01f * (1.0f + i);
+        float lv = i % 4 == 2 || i % 4 == 3 ? 0.0f : 0.005f * (1.0f + i);
+
+        surfels.push_back(Surfel(Vector3f(0.1f * (i % 8), 0.1f * (i / 8),
+            0.0f), lu * Vector3f::UnitX(), lv * Vector3f::UnitY(),
+            Vector3f::Zero(), i));
+    }
+
+    char const* filename = "surfel_file_test.surfels";
+    write_surfels(filename, surfels, 16);
+
+    std::vector<Surfel> decoded;
+    {
+        SurfelFile file(filename);
+        file.decode(decoded);
+    }
+    std::remove(filename);
+
+    if (decoded.size() != surfels.size())
+    {
+        std::cerr << "Decoded " << decoded.size() << " of "
+            << surfels.size() << " surfels." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    bool ok = true;
+    for (Surfel const& s : decoded)
+    {
+        if (s.rgba >= surfels.size())
+        {
+            std::cerr << "Unknown color " << s.rgba << "." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        Surfel const& expected = surfels[s.rgba];
+        ok = check_length(expected.u.norm(), s.u.norm(), s.rgba, "u") && ok;
+        ok = check_length(expected.v.norm(), s.v.norm(), s.rgba, "v") && ok;
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}